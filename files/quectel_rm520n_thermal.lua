@@ -10,6 +10,7 @@ local cjson = require "cjson"
 local SYSFS_BASE = "/sys/kernel/quectel_rm520n_thermal"
 local CLI_PATH = "/usr/bin/quectel_rm520n_temp"
 local PID_FILE = "/var/run/quectel_rm520n_temp.pid"
+local STATE_FILE = "/var/run/quectel_rm520n_thermal.state"
 
 -- Helper: trim whitespace
 local function trim(s)
@@ -26,6 +27,18 @@ local function read_file(path)
     return nil
 end
 
+-- Helper: read the daemon's key=value state file
+local function read_state()
+    local state = {}
+    local content = get_contents(STATE_FILE)
+    if content then
+        for key, value in string.gmatch(content, "([%w_]+)=([^\n]*)") do
+            state[key] = value
+        end
+    end
+    return state
+end
+
 -- Helper: check if daemon is running
 local function is_daemon_running()
     local pid = read_file(PID_FILE)
@@ -87,6 +100,13 @@ local function scrape()
         metric("quectel_modem_source", "gauge", {source=source}, 1)
     end
 
+    -- Export whether the value is a board-sensor estimate (sysfs only)
+    local temp_source = read_file(SYSFS_BASE .. "/temp_source")
+    if temp_source then
+        metric("quectel_modem_temperature_estimated", "gauge", nil,
+            temp_source == "estimated" and 1 or 0)
+    end
+
     -- Export thresholds (sysfs only)
     local temp_min = read_file(SYSFS_BASE .. "/temp_min")
     if temp_min then
@@ -122,6 +142,47 @@ local function scrape()
         end
     end
 
+    -- Export published state (daemon only)
+    local state = read_state()
+    if state.headroom then
+        metric("quectel_modem_thermal_headroom", "gauge", nil,
+            tonumber(state.headroom))
+    end
+
+    for _, sensor in ipairs({"modem", "ap", "pa"}) do
+        local stress = tonumber(state["stress_" .. sensor])
+        if stress then
+            metric("quectel_modem_stress_hours", "gauge", {sensor=sensor}, stress)
+        end
+
+        for _, q in ipairs({{"p50", "0.5"}, {"p95", "0.95"}, {"p99", "0.99"}}) do
+            local value = tonumber(state[q[1] .. "_" .. sensor])
+            if value then
+                metric("quectel_modem_temperature_quantile_celsius", "gauge",
+                    {sensor=sensor, quantile=q[2]}, value)
+            end
+        end
+    end
+
+    if state.quantile_window then
+        metric("quectel_modem_temperature_quantile_window_seconds", "gauge", nil,
+            tonumber(state.quantile_window))
+    end
+
+    for _, step in ipairs({"reopen", "reset", "usb", "power"}) do
+        local attempts = tonumber(state["recovery_attempts_" .. step])
+        if attempts then
+            metric("quectel_modem_recovery_attempts_total", "counter", {step=step}, attempts)
+            metric("quectel_modem_recovery_recovered_total", "counter", {step=step},
+                tonumber(state["recovery_recovered_" .. step]) or 0)
+        end
+    end
+
+    if state.recovery_step then
+        metric("quectel_modem_recovery_in_progress", "gauge", nil,
+            state.recovery_step ~= "none" and 1 or 0)
+    end
+
     -- Export daemon status
     metric("quectel_modem_daemon_running", "gauge", nil,
         daemon_running and 1 or 0)
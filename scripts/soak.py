@@ -0,0 +1,325 @@
+#!/usr/bin/env python3
+#
+# Soak test for the quectel_rm520n_temp daemon
+#
+# Runs the daemon against a fake root (QUECTEL_ROOT) with an accelerated
+# clock (QUECTEL_TIME_SCALE) and a pty modem that randomly leaves requests
+# unanswered, replies with garbage and disconnects, while the UCI file is
+# rewritten to exercise the reload path. Open fds, RSS and CPU time per
+# sample are read from /proc; the run fails (exit 1) if any of them grows
+# between the baseline window after warm-up and the last window, or if the
+# daemon exits.
+#
+# Usage: scripts/soak.py --binary src/quectel_rm520n_temp [--duration 300]
+#
+# Exit status: 0 pass, 1 growth or daemon exit, 2 setup error
+#
+
+import argparse
+import os
+import pty
+import random
+import re
+import select
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import tty
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+UCI_TEMPLATE = os.path.join(REPO, 'files', 'quectel_rm520n_thermal')
+UCI_PATH = 'etc/config/quectel_rm520n_thermal'
+SYSFS_DIR = 'sys/kernel/quectel_rm520n_thermal'
+SERIAL_PORT = '/dev/ttyUSB3'
+
+SYSFS_DEFAULTS = {
+    'temp': '40000', 'temp_source': 'modem', 'temp_min': '-30000',
+    'temp_max': '75000', 'temp_crit': '85000', 'temp_default': '40000',
+}
+
+# Options rotated through by the config-change injector
+CONFIG_VARIANTS = [
+    {'temp_max': '75', 'log_level': 'info'},
+    {'temp_max': '76', 'log_level': 'warning'},
+    {'temp_max': '74', 'log_level': 'info', 'history_size': '120'},
+]
+
+
+class Modem(threading.Thread):
+    """AT+QTEMP responder on a pty linked into the fake /dev"""
+
+    def __init__(self, root, args):
+        super().__init__(daemon=True)
+        self.link = os.path.join(root, SERIAL_PORT.lstrip('/'))
+        self.args = args
+        self.rng = random.Random(args.seed)
+        self.stop = threading.Event()
+        self.lock = threading.Lock()
+        self.counts = {'requests': 0, 'answered': 0, 'timeouts': 0,
+                       'garbage': 0, 'disconnects': 0}
+        self.master = None
+        self.temp = 45
+
+    def count(self, key):
+        with self.lock:
+            self.counts[key] += 1
+
+    def snapshot(self):
+        with self.lock:
+            return dict(self.counts)
+
+    def attach(self):
+        master, slave = pty.openpty()
+        tty.setraw(slave)
+        tmp = self.link + '.new'
+        if os.path.lexists(tmp):
+            os.unlink(tmp)
+        os.symlink(os.ttyname(slave), tmp)
+        os.rename(tmp, self.link)
+        # The slave stays open here so the pty survives daemon reconnects
+        self.master, self.slave = master, slave
+
+    def detach(self):
+        if os.path.lexists(self.link):
+            os.unlink(self.link)
+        os.close(self.master)
+        os.close(self.slave)
+        self.master = None
+
+    def answer(self, cmd):
+        if not cmd:
+            return
+        if b'QTEMP' not in cmd:
+            os.write(self.master, b'\r\nOK\r\n')
+            return
+        self.count('requests')
+
+        roll = self.rng.random()
+        if roll < self.args.timeout_rate:
+            self.count('timeouts')
+            return
+        if roll < self.args.timeout_rate + self.args.garbage_rate:
+            self.count('garbage')
+            junk = bytes(self.rng.randrange(256) for _ in range(self.rng.randrange(1, 200)))
+            tail = b'\r\nOK\r\n' if self.rng.random() < 0.5 else b''
+            os.write(self.master, b'\r\n+QTEMP:"modem-ambient-usr","' + junk + tail)
+            return
+
+        self.temp = min(max(self.temp + self.rng.choice((-1, 0, 0, 1)), 30), 70)
+        temp = str(self.temp).encode()
+        os.write(self.master,
+                 b'\r\n+QTEMP:"modem-ambient-usr","' + temp + b'"\r\n'
+                 b'+QTEMP:"cpuss-0-usr","' + temp + b'"\r\n'
+                 b'+QTEMP:"modem-lte-sub6-pa1","' + temp + b'"\r\n\r\nOK\r\n')
+        self.count('answered')
+
+    def run(self):
+        self.attach()
+        buf = b''
+        next_disconnect = time.monotonic() + self.args.disconnect_every
+
+        while not self.stop.is_set():
+            if self.args.disconnect_every > 0 and time.monotonic() >= next_disconnect:
+                self.count('disconnects')
+                self.detach()
+                time.sleep(self.rng.uniform(0.1, 1.0))
+                self.attach()
+                buf = b''
+                next_disconnect = time.monotonic() + self.args.disconnect_every
+
+            ready, _, _ = select.select([self.master], [], [], 0.1)
+            if not ready:
+                continue
+            try:
+                buf += os.read(self.master, 512)
+            except OSError:
+                continue
+            while b'\r' in buf:
+                cmd, buf = buf.split(b'\r', 1)
+                try:
+                    self.answer(cmd.strip())
+                except OSError:
+                    pass
+
+        self.detach()
+
+
+def write_config(root, variant, interval):
+    with open(UCI_TEMPLATE) as f:
+        text = f.read()
+    text = re.sub(r"option interval '\d+'", "option interval '%d'" % interval, text)
+    text = re.sub(r"option serial_port '[^']*'", "option serial_port '%s'" % SERIAL_PORT, text)
+    for key, value in variant.items():
+        line = "\toption %s '%s'" % (key, value)
+        text, n = re.subn(r"^\t#?option %s '[^']*'" % key, line, text, count=1, flags=re.M)
+        if n == 0:
+            text = text.rstrip('\n') + '\n' + line + '\n'
+
+    path = os.path.join(root, UCI_PATH)
+    with open(path + '.new', 'w') as f:
+        f.write(text)
+    os.rename(path + '.new', path)
+
+
+def make_root(root, interval):
+    for d in ('etc/config', 'dev', 'var/run', SYSFS_DIR):
+        os.makedirs(os.path.join(root, d), exist_ok=True)
+    for name, value in SYSFS_DEFAULTS.items():
+        with open(os.path.join(root, SYSFS_DIR, name), 'w') as f:
+            f.write(value + '\n')
+    write_config(root, CONFIG_VARIANTS[0], interval)
+
+
+def proc_usage(pid):
+    """Open fds, RSS in kB and CPU time in clock ticks of a process"""
+    fds = len(os.listdir('/proc/%d/fd' % pid))
+    rss = 0
+    with open('/proc/%d/status' % pid) as f:
+        for line in f:
+            if line.startswith('VmRSS:'):
+                rss = int(line.split()[1])
+    with open('/proc/%d/stat' % pid) as f:
+        fields = f.read().rsplit(')', 1)[1].split()
+    return fds, rss, int(fields[11]) + int(fields[12])
+
+
+def window(samples, start, end):
+    return [s for s in samples if start <= s['t'] < end]
+
+
+def summarize(samples):
+    """Max fds/RSS and CPU ms per modem request over a window"""
+    first, last = samples[0], samples[-1]
+    requests = last['requests'] - first['requests']
+    cpu_ms = (last['cpu'] - first['cpu']) * 1000.0 / os.sysconf('SC_CLK_TCK')
+    return {
+        'fds': max(s['fds'] for s in samples),
+        'rss': max(s['rss'] for s in samples),
+        'requests': requests,
+        'cpu_per_sample': cpu_ms / requests if requests > 0 else 0.0,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Soak test the daemon against a fault-injecting pty modem')
+    parser.add_argument('--binary', required=True, help='quectel_rm520n_temp built for this host')
+    parser.add_argument('--duration', type=int, default=300, help='Real seconds to run (default: 300)')
+    parser.add_argument('--scale', type=int, default=100, help='QUECTEL_TIME_SCALE (default: 100)')
+    parser.add_argument('--interval', type=int, default=1, help='UCI interval in daemon seconds (default: 1)')
+    parser.add_argument('--warmup', type=int, default=60, help='Seconds before the baseline window (default: 60)')
+    parser.add_argument('--window', type=int, default=60, help='Length of the compared windows (default: 60)')
+    parser.add_argument('--timeout-rate', type=float, default=0.02, help='Share of unanswered requests')
+    parser.add_argument('--garbage-rate', type=float, default=0.02, help='Share of garbage replies')
+    parser.add_argument('--disconnect-every', type=float, default=20, help='Seconds between disconnects (0 = never)')
+    parser.add_argument('--config-every', type=float, default=30, help='Seconds between UCI changes (0 = never)')
+    parser.add_argument('--fd-slack', type=int, default=1, help='Allowed growth of the open fd count')
+    parser.add_argument('--rss-slack', type=int, default=256, help='Allowed RSS growth in kB')
+    parser.add_argument('--cpu-ratio', type=float, default=2.0, help='Allowed CPU per sample growth factor')
+    parser.add_argument('--seed', type=int, default=None, help='Random seed for the fault injection')
+    parser.add_argument('--root', help='Fake root to use (default: temporary, removed afterwards)')
+    args = parser.parse_args()
+
+    if args.warmup + 2 * args.window > args.duration:
+        print('Error: --duration must cover --warmup and two windows', file=sys.stderr)
+        return 2
+    binary = os.path.abspath(args.binary)
+    if not os.access(binary, os.X_OK):
+        print('Error: %s is not executable' % binary, file=sys.stderr)
+        return 2
+
+    # /var/run is a tmpfs on the router; a disk-backed root slows the state file renames
+    tmpfs = '/dev/shm' if os.path.isdir('/dev/shm') else None
+    root = os.path.abspath(args.root) if args.root else tempfile.mkdtemp(prefix='quectel-soak.', dir=tmpfs)
+    make_root(root, args.interval)
+
+    modem = Modem(root, args)
+    modem.start()
+    time.sleep(0.2)
+
+    env = dict(os.environ, QUECTEL_ROOT=root, QUECTEL_TIME_SCALE=str(args.scale))
+    log = open(os.path.join(root, 'soak.log'), 'w')
+    daemon = subprocess.Popen([binary, 'daemon'], env=env, stdout=log, stderr=subprocess.STDOUT)
+
+    samples = []
+    start = time.monotonic()
+    next_config = start + args.config_every
+    variant = 0
+    exited = None
+
+    try:
+        while time.monotonic() - start < args.duration:
+            time.sleep(1)
+            if daemon.poll() is not None:
+                exited = daemon.returncode
+                break
+            now = time.monotonic()
+            if args.config_every > 0 and now >= next_config:
+                variant = (variant + 1) % len(CONFIG_VARIANTS)
+                write_config(root, CONFIG_VARIANTS[variant], args.interval)
+                next_config = now + args.config_every
+            try:
+                fds, rss, cpu = proc_usage(daemon.pid)
+            except OSError:
+                continue
+            samples.append({'t': now - start, 'fds': fds, 'rss': rss, 'cpu': cpu,
+                            'requests': modem.snapshot()['requests']})
+    finally:
+        if daemon.poll() is None:
+            daemon.send_signal(signal.SIGTERM)
+            try:
+                daemon.wait(timeout=10)
+            except subprocess.TimeoutExpired:
+                daemon.kill()
+        modem.stop.set()
+        modem.join(timeout=2)
+        log.close()
+
+    counts = modem.snapshot()
+    print('Modem: %(requests)d requests, %(answered)d answered, %(timeouts)d timeouts, '
+          '%(garbage)d garbage, %(disconnects)d disconnects' % counts)
+
+    failures = []
+    if exited is not None:
+        failures.append('daemon exited with status %d after %.0f s' % (exited, time.monotonic() - start))
+    else:
+        base = window(samples, args.warmup, args.warmup + args.window)
+        last = window(samples, args.duration - args.window, args.duration)
+        if len(base) < 2 or len(last) < 2:
+            failures.append('not enough resource samples')
+        else:
+            b, l = summarize(base), summarize(last)
+            print('Baseline: fds=%d rss=%d kB cpu=%.3f ms/sample (%d samples)' %
+                  (b['fds'], b['rss'], b['cpu_per_sample'], b['requests']))
+            print('Final:    fds=%d rss=%d kB cpu=%.3f ms/sample (%d samples)' %
+                  (l['fds'], l['rss'], l['cpu_per_sample'], l['requests']))
+            if l['requests'] == 0:
+                failures.append('no samples in the final window')
+            if l['fds'] > b['fds'] + args.fd_slack:
+                failures.append('open fds grew from %d to %d' % (b['fds'], l['fds']))
+            if l['rss'] > b['rss'] + args.rss_slack:
+                failures.append('RSS grew from %d kB to %d kB' % (b['rss'], l['rss']))
+            # One clock tick of slack for idle windows
+            tick_ms = 1000.0 / os.sysconf('SC_CLK_TCK')
+            cpu_limit = b['cpu_per_sample'] * args.cpu_ratio + tick_ms / max(l['requests'], 1)
+            if l['cpu_per_sample'] > cpu_limit:
+                failures.append('CPU per sample grew from %.3f ms to %.3f ms' %
+                                (b['cpu_per_sample'], l['cpu_per_sample']))
+
+    for failure in failures:
+        print('FAIL: %s' % failure)
+    if failures:
+        print('Daemon output kept in %s' % os.path.join(root, 'soak.log'))
+        return 1
+
+    print('PASS')
+    if not args.root:
+        shutil.rmtree(root, ignore_errors=True)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
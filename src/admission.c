@@ -0,0 +1,225 @@
+/**
+ * @file admission.c
+ * @brief Thermal admission control for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file decides whether a heavy modem operation may start. A rising
+ * trend is projected over the operation's duration; if the temperature
+ * stays below temp_max - admission_margin the operation is admitted.
+ * Otherwise a falling trend gives the time until the limit is reached
+ * again (defer), and a modem at temp_max that is not cooling, or at
+ * temp_crit, is denied.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/state.h"
+#include "include/admission.h"
+
+/* ============================================================================
+ * STATE
+ * ============================================================================ */
+
+static int g_margin = 0;          /* m°C below temp_max */
+static int g_stale = ADMISSION_STALE_MIN;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * defer - Fill a defer answer
+ * @out: Answer
+ * @reason: Reason keyword
+ * @until: Daemon clock to retry at
+ */
+static void defer(admission_t *out, const char *reason, time_t until)
+{
+    out->decision = ADMISSION_DEFER;
+    out->reason = reason;
+    out->until = until;
+}
+
+/**
+ * deny - Fill a deny answer
+ */
+static void deny(admission_t *out, const char *reason)
+{
+    out->decision = ADMISSION_DENY;
+    out->reason = reason;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * admission_configure - Apply admission_margin and the staleness limit
+ * @cfg: Configuration
+ */
+void admission_configure(const config_t *cfg)
+{
+    int interval = cfg->interval_max > cfg->interval ? cfg->interval_max : cfg->interval;
+
+    g_margin = cfg->admission_margin * 1000;
+    g_stale = 3 * interval;
+    if (g_stale < ADMISSION_STALE_MIN) {
+        g_stale = ADMISSION_STALE_MIN;
+    }
+}
+
+/**
+ * admission_decide - Decide whether a heavy operation may start now
+ * @h: Published headroom
+ * @recovering: true while the modem recovery ladder is running
+ * @duration: Expected operation length in seconds
+ * @now: Daemon clock
+ * @out: Filled with the answer
+ */
+void admission_decide(const headroom_t *h, bool recovering, int duration, time_t now,
+                      admission_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->limit_mdeg = headroom_temp_max() - g_margin;
+
+    if (h->score < 0) {
+        deny(out, "no-data");
+        return;
+    }
+    if (h->level == HEADROOM_LEVEL_CRITICAL) {
+        deny(out, "critical");
+        return;
+    }
+    /* The AT processor is busy with the recovery; a scan would only delay it */
+    if (recovering) {
+        defer(out, "recovering", now + ADMISSION_RETRY_SEC);
+        return;
+    }
+    if (now - h->updated > g_stale) {
+        deny(out, "stale");
+        return;
+    }
+
+    // Only a rising trend is projected, as for the headroom score
+    int rise = h->trend > 0 ? (int)((long long)h->trend * duration / 60) : 0;
+    out->projected_mdeg = h->temp_mdeg + rise;
+
+    if (out->projected_mdeg <= out->limit_mdeg) {
+        out->decision = ADMISSION_ADMIT;
+        out->reason = "ok";
+        return;
+    }
+
+    if (h->trend > 0) {
+        // Below the limit now, but the operation would end above it
+        if (h->temp_mdeg < headroom_temp_max()) {
+            defer(out, "rising", now + ADMISSION_RETRY_SEC);
+        } else {
+            deny(out, "hot");
+        }
+        return;
+    }
+
+    if (h->trend <= -ADMISSION_MIN_COOLING) {
+        long long wait = ((long long)(h->temp_mdeg - out->limit_mdeg) * 60 + (-h->trend - 1)) / -h->trend;
+        if (wait <= ADMISSION_DEFER_MAX) {
+            defer(out, "cooling", now + (wait > 0 ? wait : 1));
+            return;
+        }
+    }
+
+    if (h->temp_mdeg < headroom_temp_max()) {
+        defer(out, "warm", now + ADMISSION_RETRY_SEC);
+    } else {
+        deny(out, "hot");
+    }
+}
+
+/**
+ * admission_name - Name of a decision
+ * @decision: admission_decision_t
+ */
+const char *admission_name(int decision)
+{
+    static const char *const names[] = { "admit", "defer", "deny" };
+
+    if (decision < ADMISSION_ADMIT || decision > ADMISSION_DENY) {
+        return "unknown";
+    }
+    return names[decision];
+}
+
+/**
+ * admission_format_json - Format an answer as a JSON object
+ * @a: Answer
+ * @h: Headroom the answer is based on
+ * @now: Daemon clock
+ * @buf: Output buffer
+ * @size: Size of buf
+ */
+int admission_format_json(const admission_t *a, const headroom_t *h, time_t now,
+                          char *buf, size_t size)
+{
+    long long retry_after = a->decision == ADMISSION_DEFER ? (long long)(a->until - now) : 0;
+
+    return snprintf(buf, size,
+                    "{\"decision\": \"%s\", \"reason\": \"%s\", \"until\": %lld, \"retry_after\": %lld, "
+                    "\"temperature\": %d, \"projected\": %d, \"limit\": %d, \"trend\": %d, "
+                    "\"headroom\": %d, \"source\": \"%s\"}\n",
+                    admission_name(a->decision), a->reason, (long long)a->until, retry_after,
+                    h->temp_mdeg, a->projected_mdeg, a->limit_mdeg, h->trend,
+                    h->score, h->estimated ? "estimated" : "modem");
+}
+
+/**
+ * admission_mode - Admit subcommand, answered from the daemon's state file
+ * @cfg: Configuration
+ * @duration: Expected operation length in seconds
+ * @json: Output as JSON
+ *
+ * Return: 0 admit, ADMISSION_EXIT_DEFER defer, 1 deny
+ */
+int admission_mode(const config_t *cfg, int duration, bool json)
+{
+    char value[STATE_VALUE_LEN];
+    admission_t a;
+    time_t now = sys_time();
+
+    headroom_configure(cfg);
+    admission_configure(cfg);
+
+    // The state file is left behind by a crashed daemon, only trust a live one
+    if (check_daemon_running() == 1) {
+        headroom_resume();
+    }
+    const headroom_t *h = headroom_get();
+    bool recovering = state_read("recovery_step", value, sizeof(value)) == 0 &&
+                      strcmp(value, "none") != 0;
+
+    admission_decide(h, recovering, duration, now, &a);
+
+    if (json) {
+        char buf[512];
+        admission_format_json(&a, h, now, buf, sizeof(buf));
+        fputs(buf, stdout);
+    } else if (a.decision == ADMISSION_DEFER) {
+        printf("defer %lld s (%s)\n", (long long)(a.until - now), a.reason);
+    } else {
+        printf("%s (%s)\n", admission_name(a.decision), a.reason);
+    }
+
+    switch (a.decision) {
+    case ADMISSION_ADMIT:
+        return 0;
+    case ADMISSION_DEFER:
+        return ADMISSION_EXIT_DEFER;
+    default:
+        return 1;
+    }
+}
@@ -0,0 +1,537 @@
+/**
+ * @file atport.c
+ * @brief AT port pool for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the daemon's AT port pool. The ports are kept in
+ * order of preference (serial_port first, then the at_port list). The
+ * first working port is active, the next one is held open as a warm
+ * standby. When the active port times out or errors, the command is
+ * retried on the standby right away, so a wedged or busy tty costs one
+ * AT timeout instead of a reconnect backoff cycle.
+ *
+ * Every port has a health score that decays on failures and recovers on
+ * successful transactions; the standby is probed periodically so its
+ * score stays current, and a preferred port only takes over again once
+ * it has proven healthy.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/serial.h"
+#include "include/system.h"
+#include "include/atport.h"
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define PROBE_COMMAND "AT\r"
+#define PROBE_RESPONSE_LEN 128
+
+typedef struct {
+    char path[CONFIG_STRING_LEN];
+    int fd;
+    int health;                  /* 0-100, recovers on success, halves on failure */
+    int consecutive_failures;
+    unsigned long ok;
+    unsigned long failures;
+    time_t retry_at;             /* Earliest reopen while other ports work */
+    int retry_delay;
+} atport_t;
+
+static atport_t g_ports[MAX_AT_PORTS];
+static int g_port_count = 0;
+static speed_t g_baud_rate = 0;
+static int g_active = -1;
+static int g_standby = -1;
+static int g_probe_counter = 0;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * port_init - Reset a port entry
+ */
+static void port_init(atport_t *p, const char *path)
+{
+    memset(p, 0, sizeof(*p));
+    snprintf(p->path, sizeof(p->path), "%s", path);
+    p->fd = -1;
+    p->health = ATPORT_HEALTH_MAX;
+    p->retry_delay = SERIAL_INITIAL_RECONNECT_DELAY;
+}
+
+/**
+ * port_close - Close a port and drop its role
+ */
+static void port_close(int i)
+{
+    if (g_ports[i].fd >= 0) {
+        close_serial_port(g_ports[i].fd);
+        g_ports[i].fd = -1;
+    }
+    if (g_active == i) {
+        g_active = -1;
+    }
+    if (g_standby == i) {
+        g_standby = -1;
+    }
+}
+
+/**
+ * port_schedule_retry - Delay the next reopen of a port with exponential backoff
+ */
+static void port_schedule_retry(atport_t *p)
+{
+    p->retry_at = sys_time() + p->retry_delay;
+    p->retry_delay *= 2;
+    if (p->retry_delay > SERIAL_MAX_RECONNECT_DELAY) {
+        p->retry_delay = SERIAL_MAX_RECONNECT_DELAY;
+    }
+}
+
+/**
+ * port_try_open - Open a port with the configured baud rate
+ *
+ * Return: 0 on success, -1 on error (retry scheduled)
+ */
+static int port_try_open(int i)
+{
+    atport_t *p = &g_ports[i];
+
+    p->fd = init_serial_port(p->path, g_baud_rate);
+    if (p->fd < 0) {
+        logging_debug("AT port %s open failed: %s", p->path, strerror(errno));
+        port_schedule_retry(p);
+        return -1;
+    }
+
+    p->consecutive_failures = 0;
+    p->retry_delay = SERIAL_INITIAL_RECONNECT_DELAY;
+    return 0;
+}
+
+/**
+ * port_success - Account a successful transaction
+ */
+static void port_success(atport_t *p)
+{
+    p->ok++;
+    p->consecutive_failures = 0;
+    p->health += (ATPORT_HEALTH_MAX - p->health + 3) / 4;
+}
+
+/**
+ * response_ok - Check for a final OK result code
+ *
+ * read_modem_response() returns the partial response on a timeout, so an
+ * echo of the command or garbage alone does not prove the port works.
+ */
+static bool response_ok(const char *response)
+{
+    return strstr(response, "\nOK") || strstr(response, "\rOK");
+}
+
+/**
+ * port_failure - Account a failed transaction, closing the port if it keeps failing
+ */
+static void port_failure(int i)
+{
+    atport_t *p = &g_ports[i];
+
+    p->failures++;
+    p->health /= 2;
+    if (++p->consecutive_failures >= ATPORT_MAX_FAILURES) {
+        logging_warning("AT port %s failed %d times in a row, closing it",
+                       p->path, p->consecutive_failures);
+        port_close(i);
+        port_schedule_retry(p);
+    }
+}
+
+/**
+ * find_port - Index of a configured port path, -1 if not configured
+ */
+static int find_port(const char *path)
+{
+    for (int i = 0; i < g_port_count; i++) {
+        if (strcmp(g_ports[i].path, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * PORT POOL FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Apply the configured port list and baud rate
+ *
+ * @param cfg Configuration with at_ports and baud_rate
+ */
+void atport_configure(const config_t *cfg)
+{
+    atport_t old[MAX_AT_PORTS];
+    int old_count = g_port_count;
+    const char *old_active = NULL, *old_standby = NULL;
+    bool baud_changed = (old_count > 0 && cfg->baud_rate != g_baud_rate);
+
+    memcpy(old, g_ports, sizeof(old));
+    if (g_active >= 0) {
+        old_active = old[g_active].path;
+    }
+    if (g_standby >= 0) {
+        old_standby = old[g_standby].path;
+    }
+
+    g_port_count = 0;
+    g_active = -1;
+    g_standby = -1;
+    g_baud_rate = cfg->baud_rate;
+
+    for (int i = 0; i < cfg->at_port_count && i < MAX_AT_PORTS; i++) {
+        atport_t *p = &g_ports[g_port_count++];
+        port_init(p, cfg->at_ports[i]);
+
+        /* Keep descriptor and health of ports that stay configured */
+        for (int j = 0; j < old_count; j++) {
+            if (strcmp(old[j].path, p->path) == 0) {
+                *p = old[j];
+                old[j].fd = -1;
+                if (baud_changed && p->fd >= 0) {
+                    close_serial_port(p->fd);
+                    p->fd = -1;
+                }
+                break;
+            }
+        }
+
+        if (p->fd >= 0 && old_active && strcmp(p->path, old_active) == 0) {
+            g_active = g_port_count - 1;
+        } else if (p->fd >= 0 && old_standby && strcmp(p->path, old_standby) == 0) {
+            g_standby = g_port_count - 1;
+        }
+    }
+
+    /* Close ports that were removed from the configuration */
+    for (int j = 0; j < old_count; j++) {
+        if (old[j].fd >= 0) {
+            close_serial_port(old[j].fd);
+        }
+    }
+
+    if (baud_changed || (old_count > 0 && old_active && g_active < 0)) {
+        logging_info("Serial configuration changed, reopening AT ports");
+    }
+}
+
+/**
+ * Open the active port and the warm standby
+ *
+ * @return 0 if an active port is open, -1 if no port could be opened
+ */
+int atport_open(void)
+{
+    bool none_open = (g_active < 0 && g_standby < 0);
+    time_t now = sys_time();
+
+    /* The standby takes over if the active port was closed */
+    if (g_active < 0 && g_standby >= 0) {
+        g_active = g_standby;
+        g_standby = -1;
+        logging_info("AT port %s is now active", g_ports[g_active].path);
+    }
+
+    /* With nothing open, try all ports; the caller paces the retries */
+    for (int i = 0; g_active < 0 && i < g_port_count; i++) {
+        atport_t *p = &g_ports[i];
+        if (p->fd < 0 && ((!none_open && now < p->retry_at) || port_try_open(i) != 0)) {
+            continue;
+        }
+        g_active = i;
+        logging_info("AT port %s opened as active port", p->path);
+    }
+
+    if (g_active < 0) {
+        return -1;
+    }
+
+    /* Warm standby: the most preferred other port that can be opened */
+    for (int i = 0; i < g_port_count; i++) {
+        atport_t *p = &g_ports[i];
+        if (i == g_active) {
+            continue;
+        }
+        if (i == g_standby) {
+            break;
+        }
+        if (p->fd < 0 && (now < p->retry_at || port_try_open(i) != 0)) {
+            continue;
+        }
+        g_standby = i;
+        g_probe_counter = 0;
+        logging_info("AT port %s opened as warm standby", p->path);
+        break;
+    }
+
+    /* Release ports that lost their role */
+    for (int i = 0; i < g_port_count; i++) {
+        if (i != g_active && i != g_standby && g_ports[i].fd >= 0) {
+            port_close(i);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Check whether an active port is open
+ *
+ * @return true if AT commands can be sent
+ */
+bool atport_connected(void)
+{
+    return g_active >= 0;
+}
+
+/**
+ * Send an AT command, failing over to the standby if the active port fails
+ *
+ * @param command AT command including the trailing CR
+ * @param response Response buffer
+ * @param response_len Size of the response buffer
+ * @return Number of bytes in response, -1 if no port answered with OK
+ */
+int atport_command(const char *command, char *response, size_t response_len)
+{
+    bool failed_over = false;
+
+    while (g_active >= 0) {
+        int i = g_active;
+        int n = send_at_command(g_ports[i].fd, command, response, response_len);
+        if (n > 0 && response_ok(response)) {
+            port_success(&g_ports[i]);
+            return n;
+        }
+
+        port_failure(i);
+        if (g_standby < 0 || failed_over || shutdown_requested) {
+            return -1;
+        }
+
+        /* Retry on the warm standby; the failed port becomes standby if still open */
+        logging_warning("AT port %s not responding, failing over to %s",
+                       g_ports[i].path, g_ports[g_standby].path);
+        g_active = g_standby;
+        g_standby = (g_ports[i].fd >= 0) ? i : -1;
+        g_probe_counter = 0;
+        failed_over = true;
+    }
+
+    errno = ENODEV;
+    return -1;
+}
+
+/**
+ * Send an AT command through a port other than the active one
+ *
+ * @param command AT command including the trailing CR
+ * @param response Response buffer
+ * @param response_len Size of the response buffer
+ * @return Number of bytes in response, -1 if no port answered
+ */
+int atport_command_other(const char *command, char *response, size_t response_len)
+{
+    int n;
+
+    if (g_standby >= 0) {
+        n = send_at_command(g_ports[g_standby].fd, command, response, response_len);
+        if (n > 0) {
+            logging_debug("Command sent through standby AT port %s", g_ports[g_standby].path);
+            return n;
+        }
+    }
+
+    /* Ports without a role are opened for this one command */
+    for (int i = 0; i < g_port_count; i++) {
+        if (i == g_active || i == g_standby) {
+            continue;
+        }
+        int fd = init_serial_port(g_ports[i].path, g_baud_rate);
+        if (fd < 0) {
+            continue;
+        }
+        n = send_at_command(fd, command, response, response_len);
+        close_serial_port(fd);
+        if (n > 0) {
+            logging_debug("Command sent through AT port %s", g_ports[i].path);
+            return n;
+        }
+    }
+
+    if (g_active >= 0) {
+        n = send_at_command(g_ports[g_active].fd, command, response, response_len);
+        if (n > 0) {
+            return n;
+        }
+    }
+
+    errno = ENODEV;
+    return -1;
+}
+
+/**
+ * Per-sample housekeeping: probe the standby and fail back
+ */
+void atport_maintain(void)
+{
+    if (g_standby < 0) {
+        return;
+    }
+
+    if (++g_probe_counter >= ATPORT_PROBE_INTERVAL) {
+        char response[PROBE_RESPONSE_LEN];
+        g_probe_counter = 0;
+
+        if (send_at_command(g_ports[g_standby].fd, PROBE_COMMAND, response, sizeof(response)) > 0 &&
+            response_ok(response)) {
+            port_success(&g_ports[g_standby]);
+        } else {
+            logging_debug("Standby AT port %s did not answer probe", g_ports[g_standby].path);
+            port_failure(g_standby);
+        }
+    }
+
+    /* Move back to a preferred port once it has proven healthy */
+    if (g_standby >= 0 && g_standby < g_active &&
+        g_ports[g_standby].health >= ATPORT_HEALTH_FAILBACK) {
+        logging_info("AT port %s healthy again, switching back from %s",
+                    g_ports[g_standby].path, g_ports[g_active].path);
+        int previous = g_active;
+        g_active = g_standby;
+        g_standby = previous;
+        g_probe_counter = 0;
+    }
+}
+
+/**
+ * Close all ports
+ */
+void atport_close_all(void)
+{
+    for (int i = 0; i < g_port_count; i++) {
+        port_close(i);
+    }
+}
+
+/**
+ * Log per-port health and counters
+ */
+void atport_log_health(void)
+{
+    for (int i = 0; i < g_port_count; i++) {
+        const atport_t *p = &g_ports[i];
+        const char *role = (i == g_active) ? "active" : (i == g_standby) ? "standby" : "closed";
+        logging_info("AT port %s: %s, health=%d, ok=%lu, failed=%lu",
+                    p->path, role, p->health, p->ok, p->failures);
+    }
+}
+
+/* ============================================================================
+ * RE-EXEC HANDOFF FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Describe the open ports for a re-exec handoff
+ *
+ * @param state Filled with port paths, descriptors and health
+ * @return Number of open ports
+ */
+int atport_export(handoff_ports_t *state)
+{
+    int open_ports = 0;
+
+    memset(state, 0, sizeof(*state));
+    state->baud_rate = (uint32_t)g_baud_rate;
+    state->active = g_active;
+    state->standby = g_standby;
+
+    for (int i = 0; i < g_port_count && i < HANDOFF_MAX_PORTS; i++) {
+        handoff_port_t *hp = &state->ports[state->count++];
+        hp->fd = g_ports[i].fd;
+        hp->health = g_ports[i].health;
+        memcpy(hp->port, g_ports[i].path, sizeof(hp->port));
+        hp->port[sizeof(hp->port) - 1] = '\0';
+        if (hp->fd >= 0) {
+            open_ports++;
+        }
+    }
+
+    return open_ports;
+}
+
+/**
+ * Take over ports from a previous image
+ *
+ * @param state Port state handed over by the previous image
+ */
+void atport_import(const handoff_ports_t *state)
+{
+    for (uint32_t i = 0; i < state->count && i < HANDOFF_MAX_PORTS; i++) {
+        const handoff_port_t *hp = &state->ports[i];
+        char path[sizeof(hp->port) + 1];
+
+        memcpy(path, hp->port, sizeof(hp->port));
+        path[sizeof(hp->port)] = '\0';
+
+        int idx = find_port(path);
+        if (idx >= 0) {
+            g_ports[idx].health = hp->health;
+        }
+
+        if (hp->fd < 0 || fcntl(hp->fd, F_GETFD) < 0) {
+            continue;
+        }
+
+        if (idx < 0 || g_ports[idx].fd >= 0 || state->baud_rate != (uint32_t)g_baud_rate) {
+            close(hp->fd);
+            logging_info("Serial configuration changed, not reusing %s", path);
+            continue;
+        }
+
+        if (serial_adopt(hp->fd, path) != 0) {
+            close(hp->fd);
+            logging_warning("Cannot take over %s: %s", path, strerror(errno));
+            continue;
+        }
+
+        fcntl(hp->fd, F_SETFD, FD_CLOEXEC);
+        g_ports[idx].fd = hp->fd;
+        if ((int32_t)i == state->active) {
+            g_active = idx;
+        } else if ((int32_t)i == state->standby) {
+            g_standby = idx;
+        } else {
+            g_standby = (g_standby < 0) ? idx : g_standby;
+        }
+        logging_info("Serial port %s taken over from previous image", path);
+    }
+
+    /* The standby keeps working even if the active port was dropped */
+    if (g_active < 0 && g_standby >= 0) {
+        g_active = g_standby;
+        g_standby = -1;
+    }
+}
@@ -0,0 +1,253 @@
+/**
+ * @file bench.c
+ * @brief AT round-trip benchmark for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the bench subcommand. It runs timed AT and AT+QTEMP
+ * transactions through the same serial code the daemon uses and reports
+ * latency percentiles, response sizes, timeouts and throughput per baud
+ * rate, so a slow thermal reaction can be attributed to the modem firmware,
+ * the USB link or the serial settings.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "include/logging.h"
+#include "include/config.h"
+#include "include/common.h"
+#include "include/serial.h"
+#include "include/system.h"
+#include "include/bench.h"
+
+/* ============================================================================
+ * CONSTANTS & DATA STRUCTURES
+ * ============================================================================ */
+
+#define MAX_RESPONSE 1024
+
+/* Baud rates accepted by config_parse_baud_rate() */
+static const char *const bench_baud_rates[] = { "9600", "19200", "38400", "57600", "115200" };
+
+/* Commands under test: a bare AT measures the link, AT+QTEMP the firmware */
+static const char *const bench_commands[] = { "AT\r", "AT+QTEMP\r" };
+static const char *const bench_command_names[] = { "AT", "AT+QTEMP" };
+
+/* Results of one command at one baud rate */
+typedef struct {
+    const char *baud;
+    const char *command;
+    int ok;                      /* Transactions answered with OK */
+    int timeouts;                /* Transactions without a final result code */
+    int errors;                  /* ERROR responses and I/O failures */
+    int skipped;                 /* Not run after too many timeouts */
+    long p50_us, p90_us, p99_us, max_us;
+    double bytes_per_response;
+    double transactions_per_sec;
+    double bytes_per_sec;
+} bench_result_t;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * elapsed_us - Microseconds between two monotonic timestamps
+ */
+static long elapsed_us(const struct timespec *start, const struct timespec *end)
+{
+    return (long)(end->tv_sec - start->tv_sec) * 1000000L +
+           (end->tv_nsec - start->tv_nsec) / 1000L;
+}
+
+/**
+ * compare_long - qsort comparator for latencies
+ */
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *)a;
+    long y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * percentile - Nearest-rank percentile of a sorted array
+ */
+static long percentile(const long *sorted, int n, int pct)
+{
+    if (n == 0) {
+        return 0;
+    }
+    int rank = (pct * n + 99) / 100;
+    return sorted[(rank > 0 ? rank : 1) - 1];
+}
+
+/**
+ * bench_command - Run @count transactions of one command
+ * @fd: Open serial port
+ * @cmd_index: Index into bench_commands
+ * @count: Number of transactions
+ * @latencies: Scratch array of @count entries
+ * @res: Result to fill in
+ */
+static void bench_command(int fd, int cmd_index, int count, long *latencies, bench_result_t *res)
+{
+    char response[MAX_RESPONSE];
+    long total_bytes = 0;
+    long total_us = 0;
+    int consecutive_timeouts = 0;
+
+    res->command = bench_command_names[cmd_index];
+
+    for (int i = 0; i < count && !shutdown_requested; i++) {
+        struct timespec start, end;
+
+        errno = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int n = send_at_command(fd, bench_commands[cmd_index], response, sizeof(response));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        long us = elapsed_us(&start, &end);
+
+        if (n > 0 && (strstr(response, "\nOK") || strstr(response, "\rOK"))) {
+            latencies[res->ok++] = us;
+            total_bytes += n;
+            total_us += us;
+            consecutive_timeouts = 0;
+        } else if (n >= 0 && errno == ETIMEDOUT) {
+            res->timeouts++;
+            if (++consecutive_timeouts >= BENCH_MAX_TIMEOUTS) {
+                res->skipped = count - i - 1;
+                logging_warning("%d consecutive timeouts at %s baud, skipping remaining %s transactions",
+                               consecutive_timeouts, res->baud, res->command);
+                break;
+            }
+        } else {
+            res->errors++;
+            consecutive_timeouts = 0;
+        }
+    }
+
+    qsort(latencies, res->ok, sizeof(long), compare_long);
+    res->p50_us = percentile(latencies, res->ok, 50);
+    res->p90_us = percentile(latencies, res->ok, 90);
+    res->p99_us = percentile(latencies, res->ok, 99);
+    res->max_us = res->ok ? latencies[res->ok - 1] : 0;
+    if (res->ok > 0) {
+        res->bytes_per_response = (double)total_bytes / res->ok;
+        res->transactions_per_sec = res->ok * 1e6 / total_us;
+        res->bytes_per_sec = total_bytes * 1e6 / total_us;
+    }
+}
+
+/**
+ * print_results - Print benchmark results as a table or JSON
+ */
+static void print_results(const char *port, int count, const bench_result_t *results, int n, bool json)
+{
+    if (json) {
+        printf("{\n");
+        printf("  \"port\": \"%s\",\n", port);
+        printf("  \"count\": %d,\n", count);
+        printf("  \"results\": [\n");
+        for (int i = 0; i < n; i++) {
+            const bench_result_t *r = &results[i];
+            printf("    {\"baud\": %s, \"command\": \"%s\", \"ok\": %d, \"timeouts\": %d, "
+                   "\"errors\": %d, \"skipped\": %d, \"p50_us\": %ld, \"p90_us\": %ld, "
+                   "\"p99_us\": %ld, \"max_us\": %ld, \"bytes_per_response\": %.1f, "
+                   "\"transactions_per_sec\": %.1f, \"bytes_per_sec\": %.0f}%s\n",
+                   r->baud, r->command, r->ok, r->timeouts, r->errors, r->skipped,
+                   r->p50_us, r->p90_us, r->p99_us, r->max_us, r->bytes_per_response,
+                   r->transactions_per_sec, r->bytes_per_sec, (i + 1 < n) ? "," : "");
+        }
+        printf("  ]\n");
+        printf("}\n");
+        return;
+    }
+
+    printf("Benchmark: %s, %d transactions per command\n\n", port, count);
+    printf("%-7s %-9s %4s %4s %4s %8s %8s %8s %8s %7s %7s %8s\n",
+           "Baud", "Command", "OK", "T/O", "Err", "p50 ms", "p90 ms", "p99 ms", "max ms",
+           "B/resp", "tx/s", "B/s");
+    for (int i = 0; i < n; i++) {
+        const bench_result_t *r = &results[i];
+        printf("%-7s %-9s %4d %4d %4d %8.2f %8.2f %8.2f %8.2f %7.1f %7.1f %8.0f%s\n",
+               r->baud, r->command, r->ok, r->timeouts, r->errors,
+               r->p50_us / 1000.0, r->p90_us / 1000.0, r->p99_us / 1000.0, r->max_us / 1000.0,
+               r->bytes_per_response, r->transactions_per_sec, r->bytes_per_sec,
+               r->skipped ? " (skipped)" : "");
+    }
+}
+
+/* ============================================================================
+ * BENCH MODE IMPLEMENTATION
+ * ============================================================================ */
+
+/**
+ * Bench mode - measure AT round-trip performance
+ *
+ * @param port Serial port to benchmark
+ * @param baud_rate Single baud rate to test, or 0 to sweep all supported rates
+ * @param count Transactions per command and baud rate
+ * @param json Output results as JSON
+ * @return 0 on success, 1 on error
+ */
+int bench_mode(const char *port, speed_t baud_rate, int count, bool json)
+{
+    const int num_bauds = (int)(sizeof(bench_baud_rates) / sizeof(bench_baud_rates[0]));
+    const int num_cmds = (int)(sizeof(bench_commands) / sizeof(bench_commands[0]));
+    bench_result_t results[sizeof(bench_baud_rates) / sizeof(bench_baud_rates[0]) *
+                           sizeof(bench_commands) / sizeof(bench_commands[0])];
+    int num_results = 0;
+    int ret = 0;
+
+    long *latencies = calloc((size_t)count, sizeof(long));
+    if (!latencies) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+
+    if (request_daemon_pause(BENCH_PAUSE_TIMEOUT) != 0) {
+        fprintf(stderr, "Error: Could not pause the daemon, serial port is in use\n");
+        free(latencies);
+        return 1;
+    }
+
+    for (int b = 0; b < num_bauds && !shutdown_requested; b++) {
+        speed_t speed;
+        if (config_parse_baud_rate(bench_baud_rates[b], &speed) != 0 ||
+            (baud_rate != 0 && speed != baud_rate)) {
+            continue;
+        }
+
+        int fd = init_serial_port(port, speed);
+        if (fd < 0) {
+            fprintf(stderr, "Error: Cannot open %s at %s baud: %s\n",
+                    port, bench_baud_rates[b], strerror(errno));
+            ret = 1;
+            break;
+        }
+
+        for (int c = 0; c < num_cmds && !shutdown_requested; c++) {
+            bench_result_t *res = &results[num_results++];
+            memset(res, 0, sizeof(*res));
+            res->baud = bench_baud_rates[b];
+            bench_command(fd, c, count, latencies, res);
+        }
+
+        close_serial_port(fd);
+    }
+
+    release_daemon_pause();
+    free(latencies);
+
+    if (num_results > 0) {
+        print_results(port, count, results, num_results, json);
+    }
+
+    return ret;
+}
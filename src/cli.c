@@ -79,8 +79,8 @@ int cli_mode(char *temp_str, size_t temp_size)
         logging_debug("Daemon is running, attempting to read from daemon interfaces...");
         
         // Try to read from main sysfs interface first (primary interface)
-        if (access("/sys/kernel/quectel_rm520n_thermal/temp", R_OK) == 0) {
-            FILE *temp_fp = fopen("/sys/kernel/quectel_rm520n_thermal/temp", "r");
+        if (sys_access("/sys/kernel/quectel_rm520n_thermal/temp", R_OK) == 0) {
+            FILE *temp_fp = sys_fopen("/sys/kernel/quectel_rm520n_thermal/temp", "r");
             if (temp_fp) {
                 if (fgets(temp_str, temp_size, temp_fp) != NULL) {
                     STRIP_NEWLINE(temp_str);
@@ -107,7 +107,7 @@ int cli_mode(char *temp_str, size_t temp_size)
         if (find_quectel_hwmon_path(hwmon_path, sizeof(hwmon_path)) == 0) {
             logging_debug("Found hwmon path: %s", hwmon_path);
 
-            FILE *temp_fp = fopen(hwmon_path, "r");
+            FILE *temp_fp = sys_fopen(hwmon_path, "r");
             if (temp_fp) {
                 if (fgets(temp_str, temp_size, temp_fp) != NULL) {
                     STRIP_NEWLINE(temp_str);
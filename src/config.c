@@ -16,13 +16,63 @@
 #include <unistd.h>
 #include <errno.h>
 #include <limits.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <uci.h>
 
 /* Interval range limits */
 #define INTERVAL_MIN 1      /* Minimum 1 second */
 #define INTERVAL_MAX 3600   /* Maximum 1 hour */
+
+/* Reaction rule limits */
+#define RULE_SECONDS_MAX       86400   /* for, window and cooldown (1 day) */
+#define RULE_DEFAULT_COOLDOWN  60
+#define RULE_DEFAULT_RATE_WINDOW 60    /* Smoothing time of rate rules (s) */
+
+/* Thermal headroom score */
+#define HEADROOM_DEFAULT_SPAN        20000   /* m°C */
+#define HEADROOM_DEFAULT_HORIZON     120     /* s */
+#define HEADROOM_DEFAULT_HYSTERESIS  5       /* points */
+#define HEADROOM_SPAN_MAX            50      /* °C */
+#define ADMISSION_DEFAULT_MARGIN     5       /* °C */
+#define ADMISSION_MARGIN_MAX         30      /* °C */
+#define HEADROOM_HORIZON_MAX         3600    /* s */
+
+/* Time-at-temperature histogram */
+#define HISTOGRAM_DEFAULT_FILE       "/etc/quectel_rm520n_thermal.hist"
+#define HISTOGRAM_DEFAULT_SAVE       3600    /* s, limits flash writes */
+#define HISTOGRAM_SAVE_MIN           300
+#define STRESS_DEFAULT_EA            700     /* meV */
+#define STRESS_DEFAULT_REF           55000   /* m°C */
+#define QUANTILE_DEFAULT_WINDOW      86400   /* s */
+#define QUANTILE_WINDOW_MIN          3600
+#define QUANTILE_WINDOW_MAX          604800  /* 7 days, keeps slot counters in 16 bits */
+#define HISTORY_DEFAULT_SIZE         8640    /* One day at the default interval */
+#define HISTORY_SIZE_MIN             60
+#define HISTORY_SIZE_MAX             100000
+
+/* Modem recovery ladder */
+#define RECOVERY_DEFAULT_REOPEN      30      /* s */
+#define RECOVERY_DEFAULT_RESET       90      /* s, modem reboot */
+#define RECOVERY_DEFAULT_USB         60      /* s */
+#define RECOVERY_DEFAULT_POWER       120     /* s, cold boot */
+#define RECOVERY_TIMEOUT_MIN         5
+#define RECOVERY_TIMEOUT_LIMIT       3600
+
+/* Binary configuration cache (bump the version when a field changes meaning;
+ * layout changes are caught by config_layout_hash()) */
+#define CONFIG_UCI_FILE      "/etc/config/quectel_rm520n_thermal"
+#define CONFIG_CACHE_FILE    "/var/run/quectel_rm520n_thermal.cache"
+#define CONFIG_CACHE_MAGIC   0x434d5251u   /* "QRMC" */
+#define CONFIG_CACHE_VERSION 3
 #include "include/config.h"
 #include "include/logging.h"
+#include "include/system.h"
+#include "include/serial.h"
 
 /* Helper macro for safe string copying with null termination */
 #define SAFE_STRNCPY(dst, src, size) do { \
@@ -30,6 +80,37 @@
     dst[size - 1] = '\0'; \
 } while(0)
 
+/**
+ * Allocate a UCI context bound to the filesystem root prefix
+ * @return UCI context or NULL on allocation failure
+ *
+ * Without QUECTEL_ROOT this is a plain uci_alloc_context(). With a root
+ * prefix set, the config and delta directories are moved below it so the
+ * CLI and daemon read <root>/etc/config instead of the system config.
+ */
+struct uci_context *config_uci_alloc_context(void)
+{
+    struct uci_context *ctx = uci_alloc_context();
+    const char *root = sys_root();
+
+    if (!ctx || root[0] == '\0') {
+        return ctx;
+    }
+
+    char dir[PATH_MAX_LEN];
+    if (snprintf(dir, sizeof(dir), "%s/etc/config", root) >= (int)sizeof(dir) ||
+        uci_set_confdir(ctx, dir) != UCI_OK) {
+        logging_error("Failed to set UCI config directory below %s", root);
+        uci_free_context(ctx);
+        return NULL;
+    }
+    if (snprintf(dir, sizeof(dir), "%s/tmp/.uci", root) < (int)sizeof(dir)) {
+        uci_set_savedir(ctx, dir);
+    }
+
+    return ctx;
+}
+
 /**
  * Validate serial port path for security
  * @param port Serial port path to validate
@@ -37,7 +118,7 @@
  *
  * Validates that the serial port path:
  * - Is not NULL and has minimum length
- * - Starts with /dev/
+ * - Starts with /dev/, or is a well-formed tcp:// or rfc2217:// endpoint
  * - Does not contain path traversal (..)
  * - Does not contain shell metacharacters
  */
@@ -47,6 +128,12 @@ static int validate_serial_port(const char *port)
         return -1;
     }
 
+    /* Network endpoint: host, port and options are checked character by character */
+    if (serial_is_network(port)) {
+        serial_endpoint_t ep;
+        return serial_parse_endpoint(port, &ep);
+    }
+
     /* Must start with /dev/ */
     if (strncmp(port, "/dev/", 5) != 0) {
         return -1;
@@ -65,6 +152,375 @@ static int validate_serial_port(const char *port)
     return 0;
 }
 
+/**
+ * Parse a CPU list into an affinity mask
+ * @param list CPU list such as "1", "0,2" or "0-3"
+ * @param mask Pointer to store the mask (bit N = CPU N)
+ * @return 0 on success, -1 on invalid input
+ */
+static int parse_cpu_list(const char *list, unsigned long *mask)
+{
+    const int max_cpu = (int)(sizeof(*mask) * 8) - 1;
+    unsigned long result = 0;
+    const char *p = list;
+
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p || first < 0 || first > max_cpu) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first || last > max_cpu) {
+                return -1;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            result |= 1UL << cpu;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+
+    if (result == 0) {
+        return -1;
+    }
+    *mask = result;
+    return 0;
+}
+
+/**
+ * Validate board sensor specification
+ * @param spec Sensor specification to validate
+ * @return 0 if valid, -1 if invalid
+ *
+ * Accepts either an absolute sysfs path (must start with /sys/, no path
+ * traversal) or an hwmon device name with optional ":tempN" channel
+ * suffix consisting only of alphanumerics, '_', '-' and ':'.
+ */
+static int validate_board_sensor(const char *spec)
+{
+    if (!spec || *spec == '\0') {
+        return -1;
+    }
+
+    if (spec[0] == '/') {
+        if (strncmp(spec, "/sys/", 5) != 0 || strstr(spec, "..") != NULL) {
+            return -1;
+        }
+        return 0;
+    }
+
+    for (const char *p = spec; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '_' && *p != '-' && *p != ':') {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Validate a USB device name for unbind/rebind
+ * @param name Device name to validate
+ * @return 0 if valid, -1 if invalid
+ *
+ * Accepts names as listed in /sys/bus/usb/devices: bus number, '-' and
+ * dot-separated port numbers (e.g. "2-1" or "1-1.3").
+ */
+static int validate_usb_device(const char *name)
+{
+    const char *p = name;
+
+    if (!isdigit((unsigned char)*p)) {
+        return -1;
+    }
+    while (isdigit((unsigned char)*p)) {
+        p++;
+    }
+    if (*p++ != '-') {
+        return -1;
+    }
+    for (;;) {
+        if (!isdigit((unsigned char)*p)) {
+            return -1;
+        }
+        while (isdigit((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            return 0;
+        }
+        if (*p++ != '.') {
+            return -1;
+        }
+    }
+}
+
+/**
+ * Validate a modem power GPIO
+ * @param spec GPIO specification to validate
+ * @return 0 if valid, -1 if invalid
+ *
+ * Accepts a legacy sysfs GPIO number or the path of a GPIO value file
+ * below /sys/class/gpio/ (no path traversal).
+ */
+static int validate_power_gpio(const char *spec)
+{
+    if (spec[0] == '/') {
+        if (strncmp(spec, "/sys/class/gpio/", 16) != 0 || strstr(spec, "..") != NULL) {
+            return -1;
+        }
+        return 0;
+    }
+
+    for (const char *p = spec; *p; p++) {
+        if (!isdigit((unsigned char)*p)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Add a board sensor entry to the configuration
+ * @param config Configuration structure
+ * @param spec Sensor specification from UCI
+ */
+static void config_add_board_sensor(config_t *config, const char *spec)
+{
+    if (config->board_sensor_count >= MAX_BOARD_SENSORS) {
+        logging_warning("Too many board sensors, ignoring '%s' (max %d)", spec, MAX_BOARD_SENSORS);
+        return;
+    }
+
+    if (validate_board_sensor(spec) != 0) {
+        logging_warning("UCI board_sensor '%s' failed validation, ignoring", spec);
+        return;
+    }
+
+    SAFE_STRNCPY(config->board_sensors[config->board_sensor_count], spec,
+                 sizeof(config->board_sensors[0]));
+    config->board_sensor_count++;
+    logging_debug("UCI board_sensor read: '%s'", spec);
+}
+
+/**
+ * Add an AT port to the ordered failover list
+ * @param config Configuration structure
+ * @param port Serial port path from UCI
+ */
+static void config_add_at_port(config_t *config, const char *port)
+{
+    if (validate_serial_port(port) != 0) {
+        logging_warning("UCI at_port '%s' failed validation, ignoring", port);
+        return;
+    }
+
+    for (int i = 0; i < config->at_port_count; i++) {
+        if (strcmp(config->at_ports[i], port) == 0) {
+            return;  /* serial_port listed again */
+        }
+    }
+
+    if (config->at_port_count >= MAX_AT_PORTS) {
+        logging_warning("Too many AT ports, ignoring '%s' (max %d)", port, MAX_AT_PORTS);
+        return;
+    }
+
+    SAFE_STRNCPY(config->at_ports[config->at_port_count], port, sizeof(config->at_ports[0]));
+    config->at_port_count++;
+    logging_debug("UCI at_port read: '%s'", port);
+}
+
+/**
+ * Parse a decimal value into thousandths
+ * @param str Value such as "70", "-2.5" or "0.25"
+ * @param milli Pointer to store the value * 1000
+ * @return 0 on success, -1 on invalid input
+ */
+static int parse_milli(const char *str, int *milli)
+{
+    char *endptr;
+    errno = 0;
+    double value = strtod(str, &endptr);
+
+    if (errno != 0 || endptr == str || *endptr != '\0' ||
+        !(value > -1000000.0 && value < 1000000.0)) {
+        return -1;
+    }
+
+    *milli = (int)(value * 1000.0 + (value < 0 ? -0.5 : 0.5));
+    return 0;
+}
+
+/**
+ * Parse a rule duration option
+ * @param ctx UCI context
+ * @param section Rule section
+ * @param option Option name
+ * @param seconds Pointer to the value (left unchanged if the option is unset)
+ * @return 0 on success or if unset, -1 on invalid input
+ */
+static int config_rule_seconds(struct uci_context *ctx, struct uci_section *section,
+                               const char *option, int *seconds)
+{
+    const char *str = uci_lookup_option_string(ctx, section, option);
+    if (!str) {
+        return 0;
+    }
+
+    char *endptr;
+    errno = 0;
+    long tmp = strtol(str, &endptr, 10);
+    if (errno != 0 || endptr == str || *endptr != '\0' || tmp < 0 || tmp > RULE_SECONDS_MAX) {
+        return -1;
+    }
+
+    *seconds = (int)tmp;
+    return 0;
+}
+
+/**
+ * Parse an integer option of the settings section
+ * @param ctx UCI context
+ * @param section Settings section
+ * @param option Option name
+ * @param min Smallest accepted value
+ * @param max Largest accepted value
+ * @param value Pointer to the value (left at its default if unset or invalid)
+ * @return 0 on success or if unset, -1 on invalid input (logged)
+ */
+static int config_int_option(struct uci_context *ctx, struct uci_section *section,
+                             const char *option, int min, int max, int *value)
+{
+    const char *str = uci_lookup_option_string(ctx, section, option);
+    if (!str) {
+        return 0;
+    }
+
+    char *endptr;
+    errno = 0;
+    long tmp = strtol(str, &endptr, 10);
+    if (errno != 0 || endptr == str || *endptr != '\0' || tmp < min || tmp > max) {
+        logging_warning("Invalid %s '%s' (must be %d-%d), using default: %d",
+                       option, str, min, max, *value);
+        return -1;
+    }
+
+    *value = (int)tmp;
+    return 0;
+}
+
+/**
+ * Add a reaction rule from a UCI 'rule' section
+ * @param config Configuration structure
+ * @param ctx UCI context
+ * @param section Rule section
+ *
+ * Invalid rules are logged and skipped as a whole, so a typo never turns a
+ * rule into one that fires on every sample.
+ */
+static void config_add_rule(config_t *config, struct uci_context *ctx, struct uci_section *section)
+{
+    static const char *const metrics[] = { "temp", "modem", "ap", "pa", "rate", "headroom" };
+    rule_config_t rule = {
+        .metric = RULE_METRIC_TEMP,
+        .cooldown = RULE_DEFAULT_COOLDOWN
+    };
+
+    const char *name = uci_lookup_option_string(ctx, section, "name");
+    snprintf(rule.name, sizeof(rule.name), "%s", name ? name : section->e.name);
+
+    const char *enabled = uci_lookup_option_string(ctx, section, "enabled");
+    if (enabled && strcmp(enabled, "0") == 0) {
+        logging_debug("Rule '%s' disabled", rule.name);
+        return;
+    }
+
+    if (config->rule_count >= MAX_RULES) {
+        logging_warning("Too many rules, ignoring '%s' (max %d)", rule.name, MAX_RULES);
+        return;
+    }
+
+    const char *metric = uci_lookup_option_string(ctx, section, "metric");
+    if (metric) {
+        size_t i;
+        for (i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+            if (strcmp(metric, metrics[i]) == 0) {
+                break;
+            }
+        }
+        if (i == sizeof(metrics) / sizeof(metrics[0])) {
+            logging_warning("Rule '%s': unknown metric '%s', ignoring rule", rule.name, metric);
+            return;
+        }
+        rule.metric = (int)i;
+    }
+
+    const char *above = uci_lookup_option_string(ctx, section, "above");
+    const char *below = uci_lookup_option_string(ctx, section, "below");
+    if ((above != NULL) == (below != NULL)) {
+        logging_warning("Rule '%s': exactly one of 'above' or 'below' is required, ignoring rule", rule.name);
+        return;
+    }
+    rule.above = (above != NULL);
+    if (parse_milli(above ? above : below, &rule.threshold) != 0) {
+        logging_warning("Rule '%s': invalid threshold '%s', ignoring rule", rule.name, above ? above : below);
+        return;
+    }
+
+    const char *hysteresis = uci_lookup_option_string(ctx, section, "hysteresis");
+    if (hysteresis && (parse_milli(hysteresis, &rule.hysteresis) != 0 || rule.hysteresis < 0)) {
+        logging_warning("Rule '%s': invalid hysteresis '%s', ignoring rule", rule.name, hysteresis);
+        return;
+    }
+
+    if (rule.metric == RULE_METRIC_RATE) {
+        rule.window = RULE_DEFAULT_RATE_WINDOW;
+    }
+    if (config_rule_seconds(ctx, section, "for", &rule.duration) != 0 ||
+        config_rule_seconds(ctx, section, "window", &rule.window) != 0 ||
+        config_rule_seconds(ctx, section, "cooldown", &rule.cooldown) != 0) {
+        logging_warning("Rule '%s': invalid for/window/cooldown (0-%d s), ignoring rule",
+                        rule.name, RULE_SECONDS_MAX);
+        return;
+    }
+
+    const char *count = uci_lookup_option_string(ctx, section, "count");
+    if (count) {
+        char *endptr;
+        long tmp = strtol(count, &endptr, 10);
+        if (endptr == count || *endptr != '\0' || tmp < 1 || tmp > RULE_COUNT_MAX || rule.window < 1) {
+            logging_warning("Rule '%s': 'count' must be 1-%d and needs a 'window', ignoring rule",
+                            rule.name, RULE_COUNT_MAX);
+            return;
+        }
+        rule.count = (int)tmp;
+    }
+
+    const char *action = uci_lookup_option_string(ctx, section, "action");
+    if (action) {
+        snprintf(rule.action, sizeof(rule.action), "%s", action);
+    }
+    const char *clear_action = uci_lookup_option_string(ctx, section, "clear_action");
+    if (clear_action) {
+        snprintf(rule.clear_action, sizeof(rule.clear_action), "%s", clear_action);
+    }
+
+    config->rules[config->rule_count++] = rule;
+    logging_debug("UCI rule read: '%s' (%s %s %d)", rule.name, metrics[rule.metric],
+                  rule.above ? ">" : "<", rule.threshold);
+}
+
 /**
  * Set default configuration values
  * @param config Configuration structure to initialize
@@ -73,14 +529,41 @@ void config_set_defaults(config_t *config)
 {
     if (!config) return;
 
+    /* Zero everything so unused bytes compare and checksum deterministically */
+    memset(config, 0, sizeof(*config));
+
     SAFE_STRNCPY(config->serial_port, "/dev/ttyUSB2", sizeof(config->serial_port));
+    snprintf(config->at_ports[0], sizeof(config->at_ports[0]), "%s", config->serial_port);
+    config->at_port_count = 1;
     config->interval = 10;
     config->baud_rate = B115200;
     SAFE_STRNCPY(config->error_value, "N/A", sizeof(config->error_value));
     SAFE_STRNCPY(config->log_level, "info", sizeof(config->log_level));
+    config->log_async = 0;
     SAFE_STRNCPY(config->temp_modem_prefix, "modem-ambient-usr", sizeof(config->temp_modem_prefix));
     SAFE_STRNCPY(config->temp_ap_prefix, "cpuss-0-usr", sizeof(config->temp_ap_prefix));
     SAFE_STRNCPY(config->temp_pa_prefix, "modem-lte-sub6-pa1", sizeof(config->temp_pa_prefix));
+    config->board_sensor_count = 0;
+    config->board_agree_delta = 2000;
+    config->interval_max = 0;
+    config->realtime = 0;
+    config->rt_priority = 10;
+    config->cpu_affinity = 0;
+    config->headroom_span = HEADROOM_DEFAULT_SPAN;
+    config->headroom_horizon = HEADROOM_DEFAULT_HORIZON;
+    config->headroom_hysteresis = HEADROOM_DEFAULT_HYSTERESIS;
+    config->admission_margin = ADMISSION_DEFAULT_MARGIN;
+    SAFE_STRNCPY(config->histogram_file, HISTOGRAM_DEFAULT_FILE, sizeof(config->histogram_file));
+    config->histogram_save = HISTOGRAM_DEFAULT_SAVE;
+    config->stress_ea = STRESS_DEFAULT_EA;
+    config->stress_ref = STRESS_DEFAULT_REF;
+    config->quantile_window = QUANTILE_DEFAULT_WINDOW;
+    config->history_size = HISTORY_DEFAULT_SIZE;
+    config->recovery_reopen_timeout = RECOVERY_DEFAULT_REOPEN;
+    config->recovery_reset_timeout = RECOVERY_DEFAULT_RESET;
+    config->recovery_usb_timeout = RECOVERY_DEFAULT_USB;
+    config->recovery_power_timeout = RECOVERY_DEFAULT_POWER;
+    config->power_gpio_active_low = 0;
 }
 
 /**
@@ -147,18 +630,260 @@ int config_parse_baud_rate(const char *baud_str, speed_t *baud_rate)
 }
 
 /**
- * Read configuration from UCI
+ * Copy a temperature threshold option
+ * @param ctx UCI context
+ * @param section UCI section
+ * @param option Option name
+ * @param buffer Destination (left empty if the option is not set)
+ * @param size Size of the destination buffer
+ */
+static void config_read_threshold(struct uci_context *ctx, struct uci_section *section,
+                                  const char *option, char *buffer, size_t size)
+{
+    const char *value = uci_lookup_option_string(ctx, section, option);
+    if (value) {
+        SAFE_STRNCPY(buffer, value, size);
+    }
+}
+
+/* ============================================================================
+ * CONFIGURATION CACHE
+ * ============================================================================ */
+
+/* On-disk cache header, followed by the raw config_t */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t config_size;        /* sizeof(config_t) of the writer */
+    uint32_t crc;                /* CRC32 of the config_t payload */
+    uint32_t layout;             /* config_layout_hash() of the writer */
+    uint32_t reserved;
+    int64_t src_mtime_sec;       /* Source UCI file identity */
+    int64_t src_mtime_nsec;
+    int64_t src_size;
+    uint64_t src_ino;
+} config_cache_header_t;
+
+/**
+ * Compute a CRC32 (IEEE 802.3, reflected) checksum
+ * @param data Data to checksum
+ * @param len Length in bytes
+ * @return CRC32 value
+ *
+ * Also used for the other state files the daemon writes.
+ */
+uint32_t config_crc32(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    uint32_t crc = 0xffffffffu;
+
+    while (len--) {
+        crc ^= *p++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/* Offset and size of a field, for config_layout_hash() */
+#define CONFIG_FIELD(type, field) \
+    (uint32_t)offsetof(type, field), (uint32_t)sizeof(((type *)0)->field)
+
+/**
+ * Hash the layout of config_t
+ * @return CRC32 over the offset and size of every field
+ *
+ * Catches reordered, resized, added or removed fields that keep
+ * sizeof(config_t) unchanged. New fields must be added to the list.
+ */
+static uint32_t config_layout_hash(void)
+{
+    static const uint32_t layout[] = {
+        CONFIG_FIELD(config_t, serial_port),
+        CONFIG_FIELD(config_t, at_ports),
+        CONFIG_FIELD(config_t, at_port_count),
+        CONFIG_FIELD(config_t, interval),
+        CONFIG_FIELD(config_t, baud_rate),
+        CONFIG_FIELD(config_t, error_value),
+        CONFIG_FIELD(config_t, log_level),
+        CONFIG_FIELD(config_t, log_async),
+        CONFIG_FIELD(config_t, temp_modem_prefix),
+        CONFIG_FIELD(config_t, temp_ap_prefix),
+        CONFIG_FIELD(config_t, temp_pa_prefix),
+        CONFIG_FIELD(config_t, board_sensors),
+        CONFIG_FIELD(config_t, board_sensor_count),
+        CONFIG_FIELD(config_t, board_agree_delta),
+        CONFIG_FIELD(config_t, interval_max),
+        CONFIG_FIELD(config_t, realtime),
+        CONFIG_FIELD(config_t, rt_priority),
+        CONFIG_FIELD(config_t, cpu_affinity),
+        CONFIG_FIELD(config_t, http_listen),
+        CONFIG_FIELD(config_t, temp_min),
+        CONFIG_FIELD(config_t, temp_max),
+        CONFIG_FIELD(config_t, temp_crit),
+        CONFIG_FIELD(config_t, temp_default),
+        CONFIG_FIELD(config_t, headroom_span),
+        CONFIG_FIELD(config_t, headroom_horizon),
+        CONFIG_FIELD(config_t, headroom_hysteresis),
+        CONFIG_FIELD(config_t, admission_margin),
+        CONFIG_FIELD(config_t, histogram_file),
+        CONFIG_FIELD(config_t, histogram_save),
+        CONFIG_FIELD(config_t, stress_ea),
+        CONFIG_FIELD(config_t, stress_ref),
+        CONFIG_FIELD(config_t, quantile_window),
+        CONFIG_FIELD(config_t, history_size),
+        CONFIG_FIELD(config_t, recovery_reopen_timeout),
+        CONFIG_FIELD(config_t, recovery_reset_timeout),
+        CONFIG_FIELD(config_t, recovery_usb_timeout),
+        CONFIG_FIELD(config_t, recovery_power_timeout),
+        CONFIG_FIELD(config_t, usb_device),
+        CONFIG_FIELD(config_t, power_gpio),
+        CONFIG_FIELD(config_t, power_gpio_active_low),
+        CONFIG_FIELD(config_t, rules),
+        CONFIG_FIELD(config_t, rule_count),
+        CONFIG_FIELD(rule_config_t, name),
+        CONFIG_FIELD(rule_config_t, metric),
+        CONFIG_FIELD(rule_config_t, above),
+        CONFIG_FIELD(rule_config_t, threshold),
+        CONFIG_FIELD(rule_config_t, hysteresis),
+        CONFIG_FIELD(rule_config_t, duration),
+        CONFIG_FIELD(rule_config_t, count),
+        CONFIG_FIELD(rule_config_t, window),
+        CONFIG_FIELD(rule_config_t, cooldown),
+        CONFIG_FIELD(rule_config_t, action),
+        CONFIG_FIELD(rule_config_t, clear_action)
+    };
+
+    return config_crc32(layout, sizeof(layout));
+}
+
+/**
+ * Fill the source identity fields of a cache header
+ * @param hdr Header to fill
+ * @param src_st stat() of the UCI source file
+ */
+static void config_cache_identity(config_cache_header_t *hdr, const struct stat *src_st)
+{
+    hdr->src_mtime_sec = (int64_t)src_st->st_mtim.tv_sec;
+    hdr->src_mtime_nsec = (int64_t)src_st->st_mtim.tv_nsec;
+    hdr->src_size = (int64_t)src_st->st_size;
+    hdr->src_ino = (uint64_t)src_st->st_ino;
+}
+
+/**
+ * Load the configuration from the binary cache
+ * @param config Configuration structure to populate
+ * @param src_st stat() of the UCI source file
+ * @return 0 on cache hit, -1 if the cache is missing, stale or invalid
+ *
+ * The cache is mapped read-only and only accepted if it was written by this
+ * build (magic, version, config_t size and layout), for the current source file
+ * (mtime, size, inode) and its payload checksum matches.
+ */
+static int config_cache_load(config_t *config, const struct stat *src_st)
+{
+    const size_t total = sizeof(config_cache_header_t) + sizeof(config_t);
+    struct stat st;
+
+    int fd = sys_open(CONFIG_CACHE_FILE, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* Only trust caches written by root or by ourselves */
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != total ||
+        (st.st_uid != 0 && st.st_uid != geteuid())) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, total, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    const config_cache_header_t *hdr = map;
+    const config_t *cached = (const config_t *)(hdr + 1);
+    config_cache_header_t expect = {0};
+    config_cache_identity(&expect, src_st);
+
+    int valid = hdr->magic == CONFIG_CACHE_MAGIC &&
+                hdr->version == CONFIG_CACHE_VERSION &&
+                hdr->config_size == sizeof(config_t) &&
+                hdr->layout == config_layout_hash() &&
+                hdr->src_mtime_sec == expect.src_mtime_sec &&
+                hdr->src_mtime_nsec == expect.src_mtime_nsec &&
+                hdr->src_size == expect.src_size &&
+                hdr->src_ino == expect.src_ino &&
+                hdr->crc == config_crc32(cached, sizeof(config_t));
+
+    if (valid) {
+        memcpy(config, cached, sizeof(config_t));
+    }
+    munmap(map, total);
+
+    return valid ? 0 : -1;
+}
+
+/**
+ * Store the validated configuration in the binary cache
+ * @param config Validated configuration
+ * @param src_st stat() of the UCI source file it was parsed from
+ *
+ * Written to a temporary file and renamed into place, so readers never see
+ * a partial cache. Failures are not fatal (e.g. CLI run as non-root).
+ */
+static void config_cache_store(const config_t *config, const struct stat *src_st)
+{
+    char tmp_path[PATH_MAX_LEN];
+    config_cache_header_t hdr = {
+        .magic = CONFIG_CACHE_MAGIC,
+        .version = CONFIG_CACHE_VERSION,
+        .config_size = sizeof(config_t),
+        .crc = config_crc32(config, sizeof(config_t)),
+        .layout = config_layout_hash()
+    };
+    config_cache_identity(&hdr, src_st);
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%d", CONFIG_CACHE_FILE, (int)getpid()) >= (int)sizeof(tmp_path)) {
+        return;
+    }
+
+    int fd = sys_open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        logging_debug("Cannot write configuration cache: %s", strerror(errno));
+        return;
+    }
+
+    int ok = write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+             write(fd, config, sizeof(*config)) == (ssize_t)sizeof(*config);
+    close(fd);
+
+    if (!ok || sys_rename(tmp_path, CONFIG_CACHE_FILE) != 0) {
+        logging_debug("Failed to update configuration cache");
+        sys_unlink(tmp_path);
+        return;
+    }
+    logging_debug("Configuration cache updated");
+}
+
+/* ============================================================================
+ * CONFIGURATION READING
+ * ============================================================================ */
+
+/**
+ * Parse and validate configuration from UCI
  * @param config Configuration structure to populate
  * @return 0 on success, -1 on failure
  */
-int config_read_uci(config_t *config)
+static int config_parse_uci(config_t *config)
 {
-    if (!config) return -1;
-    
     // Set defaults first
     config_set_defaults(config);
     
-    struct uci_context *ctx = uci_alloc_context();
+    struct uci_context *ctx = config_uci_alloc_context();
     if (!ctx) {
         logging_debug("Failed to allocate UCI context");
         return -1;
@@ -194,6 +919,21 @@ int config_read_uci(config_t *config)
         } else {
             logging_debug("UCI serial_port not found, using default: '%s'", config->serial_port);
         }
+
+        // Read standby AT ports; serial_port is always the preferred one
+        snprintf(config->at_ports[0], sizeof(config->at_ports[0]), "%s", config->serial_port);
+        config->at_port_count = 1;
+        struct uci_option *at_port_opt = uci_lookup_option(ctx, section, "at_port");
+        if (at_port_opt) {
+            if (at_port_opt->type == UCI_TYPE_LIST) {
+                struct uci_element *e;
+                uci_foreach_element(&at_port_opt->v.list, e) {
+                    config_add_at_port(config, e->name);
+                }
+            } else if (at_port_opt->type == UCI_TYPE_STRING) {
+                config_add_at_port(config, at_port_opt->v.string);
+            }
+        }
         
         // Read interval with proper validation
         const char *interval_str = uci_lookup_option_string(ctx, section, "interval");
@@ -240,6 +980,11 @@ int config_read_uci(config_t *config)
             SAFE_STRNCPY(config->log_level, log_level_str, sizeof(config->log_level));
         }
 
+        const char *log_async_str = uci_lookup_option_string(ctx, section, "log_async");
+        if (log_async_str) {
+            config->log_async = (strcmp(log_async_str, "1") == 0);
+        }
+
         // Read temperature prefixes
         const char *modem_prefix = uci_lookup_option_string(ctx, section, "temp_modem_prefix");
         if (modem_prefix) {
@@ -255,10 +1000,207 @@ int config_read_uci(config_t *config)
         if (pa_prefix) {
             SAFE_STRNCPY(config->temp_pa_prefix, pa_prefix, sizeof(config->temp_pa_prefix));
         }
+
+        // Read temperature thresholds (°C strings, validated when applied)
+        config_read_threshold(ctx, section, "temp_min", config->temp_min, sizeof(config->temp_min));
+        config_read_threshold(ctx, section, "temp_max", config->temp_max, sizeof(config->temp_max));
+        config_read_threshold(ctx, section, "temp_crit", config->temp_crit, sizeof(config->temp_crit));
+        config_read_threshold(ctx, section, "temp_default", config->temp_default, sizeof(config->temp_default));
+
+        // Read board sensors used for fallback estimation (list or single option)
+        struct uci_option *board_opt = uci_lookup_option(ctx, section, "board_sensor");
+        if (board_opt) {
+            if (board_opt->type == UCI_TYPE_LIST) {
+                struct uci_element *e;
+                uci_foreach_element(&board_opt->v.list, e) {
+                    config_add_board_sensor(config, e->name);
+                }
+            } else if (board_opt->type == UCI_TYPE_STRING) {
+                config_add_board_sensor(config, board_opt->v.string);
+            }
+        }
+
+        // Read agreement tolerance between modem and board estimate (°C)
+        int agree_delta = config->board_agree_delta / 1000;
+        if (config_int_option(ctx, section, "board_agree_delta", 0, 20, &agree_delta) == 0) {
+            config->board_agree_delta = agree_delta * 1000;
+        }
+
+        // Read relaxed polling interval (0 disables adaptive polling)
+        const char *interval_max_str = uci_lookup_option_string(ctx, section, "interval_max");
+        if (interval_max_str) {
+            char *endptr;
+            errno = 0;
+            long tmp = strtol(interval_max_str, &endptr, 10);
+            if (errno != 0 || endptr == interval_max_str || *endptr != '\0' ||
+                (tmp != 0 && (tmp < config->interval || tmp > INTERVAL_MAX))) {
+                logging_warning("Invalid interval_max '%s' (must be 0 or %d-%d), adaptive polling disabled",
+                               interval_max_str, config->interval, INTERVAL_MAX);
+            } else {
+                config->interval_max = (int)tmp;
+            }
+        }
+
+        // Read real-time sampling options
+        const char *realtime_str = uci_lookup_option_string(ctx, section, "realtime");
+        if (realtime_str) {
+            config->realtime = (strcmp(realtime_str, "1") == 0);
+        }
+
+        config_int_option(ctx, section, "rt_priority", 1, 99, &config->rt_priority);
+
+        const char *affinity_str = uci_lookup_option_string(ctx, section, "cpu_affinity");
+        if (affinity_str && *affinity_str) {
+            if (parse_cpu_list(affinity_str, &config->cpu_affinity) != 0) {
+                logging_warning("Invalid cpu_affinity '%s', not pinning to CPUs", affinity_str);
+                config->cpu_affinity = 0;
+            }
+        }
+
+        // Read thermal headroom options
+        int span = config->headroom_span / 1000;
+        if (config_int_option(ctx, section, "headroom_span", 1, HEADROOM_SPAN_MAX, &span) == 0) {
+            config->headroom_span = span * 1000;
+        }
+        config_int_option(ctx, section, "headroom_horizon", 0, HEADROOM_HORIZON_MAX, &config->headroom_horizon);
+        config_int_option(ctx, section, "headroom_hysteresis", 0, 50, &config->headroom_hysteresis);
+        config_int_option(ctx, section, "admission_margin", 0, ADMISSION_MARGIN_MAX, &config->admission_margin);
+
+        // Read time-at-temperature histogram options
+        const char *hist_file_str = uci_lookup_option_string(ctx, section, "histogram_file");
+        if (hist_file_str) {
+            if (hist_file_str[0] && hist_file_str[0] != '/') {
+                logging_warning("Invalid histogram_file '%s' (must be an absolute path), using default: %s",
+                               hist_file_str, config->histogram_file);
+            } else {
+                SAFE_STRNCPY(config->histogram_file, hist_file_str, sizeof(config->histogram_file));
+            }
+        }
+
+        config_int_option(ctx, section, "histogram_save", HISTOGRAM_SAVE_MIN, RULE_SECONDS_MAX,
+                          &config->histogram_save);
+
+        const char *ea_str = uci_lookup_option_string(ctx, section, "stress_ea");
+        if (ea_str) {
+            int ea_mev;
+            if (parse_milli(ea_str, &ea_mev) != 0 || ea_mev < 100 || ea_mev > 2000) {
+                logging_warning("Invalid stress_ea '%s' (must be 0.1-2.0 eV), using default: %.2f",
+                               ea_str, config->stress_ea / 1000.0);
+            } else {
+                config->stress_ea = ea_mev;
+            }
+        }
+
+        const char *ref_str = uci_lookup_option_string(ctx, section, "stress_ref");
+        if (ref_str) {
+            int ref_mdeg;
+            if (parse_milli(ref_str, &ref_mdeg) != 0 || ref_mdeg < 0 || ref_mdeg > 125000) {
+                logging_warning("Invalid stress_ref '%s' (must be 0-125), using default: %d",
+                               ref_str, config->stress_ref / 1000);
+            } else {
+                config->stress_ref = ref_mdeg;
+            }
+        }
+
+        config_int_option(ctx, section, "quantile_window", QUANTILE_WINDOW_MIN, QUANTILE_WINDOW_MAX,
+                          &config->quantile_window);
+
+        // 0 disables the history; below HISTORY_SIZE_MIN the ring would be useless
+        int history_size = config->history_size;
+        if (config_int_option(ctx, section, "history_size", 0, HISTORY_SIZE_MAX, &history_size) == 0) {
+            if (history_size != 0 && history_size < HISTORY_SIZE_MIN) {
+                logging_warning("Invalid history_size '%d' (must be 0 or %d-%d), using default: %d",
+                               history_size, HISTORY_SIZE_MIN, HISTORY_SIZE_MAX, config->history_size);
+            } else {
+                config->history_size = history_size;
+            }
+        }
+
+        // Read modem recovery ladder options
+        config_int_option(ctx, section, "recovery_reopen_timeout", RECOVERY_TIMEOUT_MIN, RECOVERY_TIMEOUT_LIMIT,
+                          &config->recovery_reopen_timeout);
+        config_int_option(ctx, section, "recovery_reset_timeout", RECOVERY_TIMEOUT_MIN, RECOVERY_TIMEOUT_LIMIT,
+                          &config->recovery_reset_timeout);
+        config_int_option(ctx, section, "recovery_usb_timeout", RECOVERY_TIMEOUT_MIN, RECOVERY_TIMEOUT_LIMIT,
+                          &config->recovery_usb_timeout);
+        config_int_option(ctx, section, "recovery_power_timeout", RECOVERY_TIMEOUT_MIN, RECOVERY_TIMEOUT_LIMIT,
+                          &config->recovery_power_timeout);
+
+        const char *usb_device_str = uci_lookup_option_string(ctx, section, "usb_device");
+        if (usb_device_str) {
+            if (usb_device_str[0] != '\0' && validate_usb_device(usb_device_str) != 0) {
+                logging_warning("Invalid usb_device '%s' (expected a USB device name like '2-1'), ignoring",
+                               usb_device_str);
+            } else {
+                SAFE_STRNCPY(config->usb_device, usb_device_str, sizeof(config->usb_device));
+            }
+        }
+
+        const char *power_gpio_str = uci_lookup_option_string(ctx, section, "power_gpio");
+        if (power_gpio_str) {
+            if (power_gpio_str[0] != '\0' && validate_power_gpio(power_gpio_str) != 0) {
+                logging_warning("Invalid power_gpio '%s' (expected a GPIO number or /sys/class/gpio/.../value), ignoring",
+                               power_gpio_str);
+            } else {
+                SAFE_STRNCPY(config->power_gpio, power_gpio_str, sizeof(config->power_gpio));
+            }
+        }
+
+        const char *power_gpio_active_low_str = uci_lookup_option_string(ctx, section, "power_gpio_active_low");
+        if (power_gpio_active_low_str) {
+            config->power_gpio_active_low = (strcmp(power_gpio_active_low_str, "1") == 0);
+        }
+
+        // Read local HTTP endpoint (validated when the daemon binds it)
+        const char *http_listen_str = uci_lookup_option_string(ctx, section, "http_listen");
+        if (http_listen_str) {
+            SAFE_STRNCPY(config->http_listen, http_listen_str, sizeof(config->http_listen));
+        }
     } else {
         logging_debug("UCI section 'settings' not found");
     }
+
+    // Read reaction rules (config rule sections, in file order)
+    struct uci_element *e;
+    uci_foreach_element(&pkg->sections, e) {
+        struct uci_section *rule_section = uci_to_section(e);
+        if (strcmp(rule_section->type, "rule") == 0) {
+            config_add_rule(config, ctx, rule_section);
+        }
+    }
     
     uci_free_context(ctx);
     return 0;
 }
+
+/**
+ * Read configuration from UCI
+ * @param config Configuration structure to populate
+ * @return 0 on success, -1 on failure
+ *
+ * Uses the binary cache under /var/run when it matches the current UCI
+ * file, so the common case costs a stat() and an mmap() instead of a UCI
+ * context, text parsing and validation. The cache is regenerated whenever
+ * the UCI file's mtime, size or inode change.
+ */
+int config_read_uci(config_t *config)
+{
+    if (!config) return -1;
+
+    struct stat src_st;
+    int have_src = (sys_stat(CONFIG_UCI_FILE, &src_st) == 0);
+
+    if (have_src && config_cache_load(config, &src_st) == 0) {
+        logging_debug("Configuration loaded from cache");
+        return 0;
+    }
+
+    if (config_parse_uci(config) != 0) {
+        return -1;
+    }
+
+    if (have_src) {
+        config_cache_store(config, &src_st);
+    }
+    return 0;
+}
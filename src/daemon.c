@@ -16,6 +16,7 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <signal.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <time.h>
 #include "include/logging.h"
@@ -25,6 +26,17 @@
 #include "include/temperature.h"
 #include "include/system.h"
 #include "include/uci_config.h"
+#include "include/fusion.h"
+#include "include/handoff.h"
+#include "include/http.h"
+#include "include/atport.h"
+#include "include/rules.h"
+#include "include/headroom.h"
+#include "include/state.h"
+#include "include/histogram.h"
+#include "include/history.h"
+#include "include/recovery.h"
+#include "include/admission.h"
 
 /* External variables from main.c */
 extern config_t config;
@@ -36,15 +48,13 @@ extern config_t config;
 #define MAX_RESPONSE 1024
 #define AT_COMMAND "AT+QTEMP\r"
 
-/* Global file descriptor for emergency cleanup */
-static int g_serial_fd = -1;
-
 /* Error tracking statistics */
 typedef struct {
     unsigned long serial_errors;       /* Serial port open/communication failures */
     unsigned long at_command_errors;   /* AT command send failures */
     unsigned long parse_errors;        /* Temperature parsing failures */
     unsigned long successful_reads;    /* Successful temperature reads */
+    unsigned long estimated_writes;    /* Board-sensor estimates published */
     unsigned long total_iterations;    /* Total monitoring iterations */
 } daemon_stats_t;
 
@@ -57,6 +67,40 @@ static time_t g_daemon_start_time = 0;
 static char g_thermal_zone_path[PATH_MAX_LEN] = {0};
 static int g_thermal_zone_cached = 0;
 
+/* Hwmon sink path, discovered once at startup */
+static char g_hwmon_path[PATH_MAX_LEN] = {0};
+static int g_hwmon_available = 0;
+
+/* Board sensor agreement state for adaptive polling */
+static bool g_sources_agree = false;
+static int g_agree_board_mdeg = 0;
+
+/* Last published source, to avoid rewriting temp_source every sample */
+static int g_last_estimated = -1;
+
+/* Last published sample, served by the HTTP endpoint */
+static http_sample_t g_sample = {0};
+
+/* Serial port released to another tool (bench) */
+static bool g_paused = false;
+
+/* Next sampling deadline on the real monotonic clock (tv_sec 0 = unset) */
+static struct timespec g_next_deadline = {0};
+
+/* Wakeup lateness within the current statistics window */
+typedef struct {
+    unsigned long samples;       /* Deadlines waited for */
+    unsigned long late;          /* Wakeups later than SAMPLE_LATE_THRESHOLD_US */
+    long max_us;                 /* Worst wakeup lateness */
+    long long sum_us;            /* Sum for the average */
+} lateness_stats_t;
+
+static lateness_stats_t g_lateness = {0};
+
+/* Resource usage at the first statistics window and at the previous one */
+static sys_resources_t g_res_baseline = { .open_fds = -1 };
+static sys_resources_t g_res_last = { .open_fds = -1 };
+
 /* ============================================================================
  * CLEANUP FUNCTIONS
  * ============================================================================ */
@@ -70,14 +114,27 @@ static int g_thermal_zone_cached = 0;
  */
 static void daemon_cleanup(void)
 {
-    // Close serial port if open
-    if (g_serial_fd >= 0) {
-        close(g_serial_fd);
-        g_serial_fd = -1;
+    // Close AT ports if open
+    atport_close_all();
+
+    // Clear a pending pause acknowledgement
+    if (g_paused) {
+        set_daemon_paused(0);
     }
 
+    // Disconnect HTTP clients and remove the socket
+    http_close();
+
+    // Save time-at-temperature counters and drop stale published values
+    histogram_close();
+    history_close();
+    state_remove();
+
     // Release daemon lock
     release_daemon_lock();
+
+    // Write out queued log messages
+    logging_async_stop();
 }
 
 /* ============================================================================
@@ -96,7 +153,7 @@ static int find_modem_thermal_zone(void)
 {
     /* Return cached path if available and still valid */
     if (g_thermal_zone_cached && g_thermal_zone_path[0] != '\0') {
-        if (access(g_thermal_zone_path, W_OK) == 0) {
+        if (sys_access(g_thermal_zone_path, W_OK) == 0) {
             return 0;
         }
         /* Cached path no longer valid, rescan */
@@ -105,7 +162,7 @@ static int find_modem_thermal_zone(void)
         g_thermal_zone_path[0] = '\0';
     }
 
-    DIR *thermal_dir = opendir("/sys/devices/virtual/thermal");
+    DIR *thermal_dir = sys_opendir("/sys/devices/virtual/thermal");
     if (!thermal_dir) {
         return -1;
     }
@@ -122,7 +179,7 @@ static int find_modem_thermal_zone(void)
             continue;
         }
 
-        FILE *type_fp = fopen(type_path, "r");
+        FILE *type_fp = sys_fopen(type_path, "r");
         if (!type_fp) {
             continue;
         }
@@ -167,6 +224,477 @@ static int find_modem_thermal_zone(void)
     return -1;
 }
 
+/* ============================================================================
+ * TEMPERATURE PUBLISHING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * write_sink - Write a temperature value to a single sysfs sink
+ * @path: Sysfs file path
+ * @temp_mdeg: Temperature in m°C
+ *
+ * Avoids TOCTOU races by directly attempting fopen without access() check.
+ *
+ * Return: 0 on success, -1 if the sink is not writable
+ */
+static int write_sink(const char *path, int temp_mdeg)
+{
+    FILE *fp = sys_fopen(path, "w");
+    if (!fp) {
+        return -1;
+    }
+    fprintf(fp, "%d", temp_mdeg);
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * publish_temperature - Write a temperature to the kernel module
+ * @temp_mdeg: Temperature in m°C
+ * @estimated: true if the value is a board-sensor estimate
+ *
+ * The sysfs, hwmon and thermal sensor front-ends share one value in the
+ * kernel module, so the first writable front-end is enough. Also writes
+ * the modem thermal zone and flags the source in the main sysfs interface.
+ */
+static void publish_temperature(int temp_mdeg, bool estimated)
+{
+    // Write to main sysfs interface (primary interface for CLI tool)
+    if (write_sink("/sys/kernel/quectel_rm520n_thermal/temp", temp_mdeg) == 0) {
+        logging_debug("Wrote temperature to main sysfs interface: %d m°C", temp_mdeg);
+    } else if (g_hwmon_available && write_sink(g_hwmon_path, temp_mdeg) == 0) {
+        // Module loaded with enable_sysfs=0
+        logging_debug("Wrote temperature to hwmon interface: %d m°C", temp_mdeg);
+    } else if (write_sink("/sys/devices/platform/soc/soc:quectel-temp-sensor/cur_temp", temp_mdeg) == 0) {
+        logging_debug("Wrote temperature to platform sensor");
+    } else if (write_sink("/sys/devices/platform/quectel_rm520n_temp/cur_temp", temp_mdeg) == 0) {
+        logging_debug("Wrote temperature to platform device");
+    } else {
+        logging_debug("No kernel module interface available");
+    }
+
+    // Flag estimated values so consumers can tell them apart
+    if (g_last_estimated != (int)estimated) {
+        FILE *fp = sys_fopen("/sys/kernel/quectel_rm520n_thermal/temp_source", "w");
+        if (fp) {
+            fputs(estimated ? "estimated" : "modem", fp);
+            fclose(fp);
+            g_last_estimated = (int)estimated;
+        }
+    }
+
+    // Write to thermal zone if available (for DTS integration)
+    // Use cached thermal zone path for performance
+    if (find_modem_thermal_zone() == 0) {
+        if (write_sink(g_thermal_zone_path, temp_mdeg) == 0) {
+            logging_debug("Wrote temperature to modem thermal zone: %s", g_thermal_zone_path);
+        } else {
+            logging_debug("Modem thermal zone temp file not writable: %s", g_thermal_zone_path);
+            /* Invalidate cache so we rescan next time */
+            g_thermal_zone_cached = 0;
+        }
+    }
+
+    // Push to HTTP event streams and waiting long-poll requests
+    g_sample.seq++;
+    g_sample.timestamp = (int64_t)sys_time();
+    g_sample.temp_mdeg = temp_mdeg;
+    g_sample.estimated = estimated;
+    http_publish(&g_sample);
+
+    // Headroom score for traffic steering (file only rewritten on change)
+    headroom_update(temp_mdeg, estimated);
+    state_flush();
+}
+
+/**
+ * publish_stats - Publish the sampling statistics to the state file
+ *
+ * Counters for SNMP and other pollers; the file is rewritten once per
+ * iteration at most.
+ */
+static void publish_stats(void)
+{
+    state_set("iterations", "%lu", g_stats.total_iterations);
+    state_set("successful_reads", "%lu", g_stats.successful_reads);
+    state_set("serial_errors", "%lu", g_stats.serial_errors);
+    state_set("at_errors", "%lu", g_stats.at_command_errors);
+    state_set("parse_errors", "%lu", g_stats.parse_errors);
+    state_set("estimated_writes", "%lu", g_stats.estimated_writes);
+    if (config.log_async) {
+        state_set("log_dropped", "%lu", logging_async_dropped());
+    }
+    state_flush();
+}
+
+/**
+ * publish_sensor - Publish one AT+QTEMP sensor to the state file
+ * @key: State key
+ * @present: Whether the response reported the sensor
+ * @temp: Parsed value in °C
+ *
+ * A sensor missing from the response is published empty, so 0°C stays a
+ * valid reading.
+ */
+static void publish_sensor(const char *key, bool present, int temp)
+{
+    if (present) {
+        state_set(key, "%d", temp);
+    } else {
+        state_set(key, "%s", "");
+    }
+}
+
+/**
+ * publish_estimate - Publish a board-sensor estimate while the AT path is down
+ *
+ * Does nothing if no board sensors are configured or the offset model has
+ * not yet learned enough paired samples.
+ */
+static void publish_estimate(void)
+{
+    int board_mdeg, estimate_mdeg;
+
+    g_sources_agree = false;
+
+    if (!fusion_enabled() || !fusion_read_board(&board_mdeg)) {
+        return;
+    }
+
+    if (!fusion_estimate(board_mdeg, &estimate_mdeg)) {
+        logging_debug("Board sensor model not trained yet, no estimate published");
+        return;
+    }
+
+    publish_temperature(estimate_mdeg, true);
+    g_stats.estimated_writes++;
+    history_record(estimate_mdeg, 0, 0, 0, true);
+
+    rules_sample_t sample = { .temp_mdeg = estimate_mdeg, .estimated = true };
+    rules_evaluate(&sample);
+    logging_debug("Published estimated temperature: %d m°C (board %d m°C)", estimate_mdeg, board_mdeg);
+}
+
+/**
+ * sleep_interval - Sleep one sampling period on an absolute deadline
+ * @seconds: Period on the daemon clock
+ *
+ * Deadlines advance by exactly one period, so processing time does not
+ * make the sampling drift. After a reconnect backoff or a stall longer
+ * than a period the deadline is resynchronized instead of catching up.
+ * The wakeup lateness of every period is recorded for the statistics.
+ */
+static void sleep_interval(int seconds)
+{
+    struct timespec now;
+    /* 64-bit: a 32-bit long holds only 2147 s in microseconds */
+    int64_t period_us = sys_real_usec((int64_t)seconds * 1000000LL);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t ahead_us = (int64_t)(g_next_deadline.tv_sec - now.tv_sec) * 1000000LL +
+                       (g_next_deadline.tv_nsec - now.tv_nsec) / 1000L;
+    if (g_next_deadline.tv_sec == 0 || ahead_us + period_us < 0 || ahead_us > period_us) {
+        g_next_deadline = now;
+    }
+
+    g_next_deadline.tv_sec += (time_t)(period_us / 1000000LL);
+    g_next_deadline.tv_nsec += (long)(period_us % 1000000LL) * 1000L;
+    if (g_next_deadline.tv_nsec >= 1000000000L) {
+        g_next_deadline.tv_sec++;
+        g_next_deadline.tv_nsec -= 1000000000L;
+    }
+
+    long late_us = http_enabled() ? http_wait_until(&g_next_deadline)
+                                  : sys_sleep_until(&g_next_deadline);
+    if (late_us < 0) {
+        return;  /* Interrupted by a signal */
+    }
+
+    g_lateness.samples++;
+    g_lateness.sum_us += late_us;
+    if (late_us > g_lateness.max_us) {
+        g_lateness.max_us = late_us;
+    }
+    if (late_us > SAMPLE_LATE_THRESHOLD_US) {
+        g_lateness.late++;
+        logging_debug("Sample woke up %ld us late", late_us);
+    }
+}
+
+/**
+ * backoff_sleep - Sleep for a reconnect backoff, publishing estimates
+ * @delay: Backoff delay in seconds
+ * @shutdown_flag: Shutdown flag to abort the wait early
+ *
+ * Splits the backoff into sample-interval steps so the thermal zone keeps
+ * receiving board-sensor estimates instead of a stale value and HTTP
+ * clients keep being served.
+ */
+static void backoff_sleep(int delay, volatile sig_atomic_t *shutdown_flag)
+{
+    while (delay > 0 && !(*shutdown_flag)) {
+        publish_estimate();
+        int step = (config.interval < delay) ? config.interval : delay;
+        sleep_interval(step);
+        delay -= step;
+    }
+}
+
+/**
+ * wait_for_next_sample - Wait until the next modem poll is due
+ * @shutdown_flag: Shutdown flag to abort the wait early
+ *
+ * While modem and board readings agree, the modem is polled at the relaxed
+ * interval_max. The board sensors are still checked every regular interval
+ * and the wait ends early as soon as they move beyond the agreement band.
+ */
+static void wait_for_next_sample(volatile sig_atomic_t *shutdown_flag)
+{
+    int interval = config.interval;
+
+    if (!g_sources_agree || config.interval_max <= interval) {
+        sleep_interval(interval);
+        return;
+    }
+
+    int waited = 0;
+    while (waited < config.interval_max && !(*shutdown_flag)) {
+        sleep_interval(interval);
+        waited += interval;
+
+        int board_mdeg;
+        if (!fusion_read_board(&board_mdeg) ||
+            abs(board_mdeg - g_agree_board_mdeg) > config.board_agree_delta) {
+            logging_debug("Board temperature moved, polling modem early");
+            break;
+        }
+    }
+}
+
+/* ============================================================================
+ * REAL-TIME MODE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * apply_realtime - Apply the configured real-time sampling mode
+ * @cfg: Configuration with realtime, rt_priority and cpu_affinity
+ * @was_enabled: Whether real-time mode was active before
+ */
+static void apply_realtime(const config_t *cfg, bool was_enabled)
+{
+    if (!cfg->realtime && !was_enabled) {
+        return;
+    }
+
+    if (sys_set_realtime(cfg->realtime, cfg->rt_priority, cfg->cpu_affinity) == 0) {
+        if (cfg->realtime) {
+            logging_info("Real-time sampling enabled: SCHED_FIFO priority %d, cpu mask 0x%lx, memory locked",
+                        cfg->rt_priority, cfg->cpu_affinity);
+        } else {
+            logging_info("Real-time sampling disabled");
+        }
+    } else {
+        logging_warning("Real-time sampling only partially applied (needs CAP_SYS_NICE and CAP_IPC_LOCK)");
+    }
+}
+
+/**
+ * apply_log_async - Start or stop the asynchronous logging backend
+ * @cfg: Configuration with log_async
+ */
+static void apply_log_async(const config_t *cfg)
+{
+    if (!cfg->log_async) {
+        if (logging_async_active) {
+            logging_async_stop();
+            logging_info("Asynchronous logging disabled");
+        }
+        return;
+    }
+
+    if (logging_async_start() != 0) {
+        logging_warning("Asynchronous logging unavailable: %s", strerror(errno));
+        return;
+    }
+    logging_info("Asynchronous logging enabled (%d message queue)", LOGGING_QUEUE_SLOTS);
+}
+
+/**
+ * log_lateness - Log and reset the sampling lateness of the last window
+ */
+static void log_lateness(void)
+{
+    if (g_lateness.samples == 0) {
+        return;
+    }
+
+    logging_info("Sampling lateness: avg=%lld us, max=%ld us, late=%lu/%lu (>%d ms)",
+                g_lateness.sum_us / (long long)g_lateness.samples, g_lateness.max_us,
+                g_lateness.late, g_lateness.samples, SAMPLE_LATE_THRESHOLD_US / 1000);
+    memset(&g_lateness, 0, sizeof(g_lateness));
+}
+
+/* ============================================================================
+ * RE-EXEC HANDOFF FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * daemon_reexec - Re-execute the daemon, handing over state and descriptors
+ * @state: General daemon state to pass on
+ *
+ * Only returns if the re-exec failed; the daemon then keeps running with
+ * its current state.
+ */
+static void daemon_reexec(const handoff_daemon_t *state)
+{
+    /* Only the handed-over copy counts the re-exec, a failed one leaves state alone */
+    handoff_daemon_t next = *state;
+    next.start_time = (int64_t)g_daemon_start_time;
+    next.lock_fd = get_daemon_lock_fd();
+    next.reexec_count++;
+
+    if (handoff_begin() != 0) {
+        logging_warning("Re-exec failed, continuing with current image");
+        return;
+    }
+
+    int ok = handoff_put(HANDOFF_TLV_DAEMON, &next, sizeof(next)) == 0 &&
+             handoff_put(HANDOFF_TLV_STATS, &g_stats, sizeof(g_stats)) == 0 &&
+             handoff_put(HANDOFF_TLV_SAMPLE, &g_sample, sizeof(g_sample)) == 0 &&
+             handoff_keep_fd(next.lock_fd) == 0;
+
+    if (ok && fusion_enabled()) {
+        ok = handoff_put(HANDOFF_TLV_FUSION, fusion_model(), sizeof(fusion_model_t)) == 0 &&
+             handoff_put(HANDOFF_TLV_BOARD, config.board_sensors, sizeof(config.board_sensors)) == 0;
+    }
+
+    handoff_rules_t rules;
+    rules_export(&rules);
+    if (ok && rules.count > 0) {
+        ok = handoff_put(HANDOFF_TLV_RULES, &rules, sizeof(rules)) == 0;
+    }
+
+    if (ok) {
+        ok = handoff_put(HANDOFF_TLV_HISTOGRAM, histogram_data(), sizeof(histogram_data_t)) == 0 &&
+             handoff_put(HANDOFF_TLV_WINDOW, histogram_window(), sizeof(histogram_window_t)) == 0 &&
+             handoff_put(HANDOFF_TLV_RECOVERY, recovery_state(), sizeof(recovery_state_t)) == 0;
+    }
+
+    handoff_ports_t ports;
+    if (ok && atport_export(&ports) > 0) {
+        ok = handoff_put(HANDOFF_TLV_PORTS, &ports, sizeof(ports)) == 0;
+        for (uint32_t i = 0; ok && i < ports.count; i++) {
+            if (ports.ports[i].fd >= 0) {
+                ok = handoff_keep_fd(ports.ports[i].fd) == 0;
+            }
+        }
+    }
+
+    if (ok) {
+        // The new image starts its own writer thread; flush ours first
+        logging_async_stop();
+        handoff_exec();
+        apply_log_async(&config);
+    }
+
+    // Ports and lock must not leak into rule actions and other children
+    handoff_abort();
+    logging_warning("Re-exec failed, continuing with current image");
+}
+
+/**
+ * daemon_resume - Restore state handed over by a previous image
+ * @state: Filled with the general daemon state
+ *
+ * Return: 0 if the daemon lock was taken over, -1 otherwise
+ */
+static int daemon_resume(handoff_daemon_t *state)
+{
+    if (handoff_get(HANDOFF_TLV_DAEMON, state, sizeof(*state)) != 0 ||
+        adopt_daemon_lock(state->lock_fd) != 0) {
+        handoff_release();
+        return -1;
+    }
+
+    g_daemon_start_time = (time_t)state->start_time;
+    handoff_get(HANDOFF_TLV_STATS, &g_stats, sizeof(g_stats));
+    handoff_get(HANDOFF_TLV_SAMPLE, &g_sample, sizeof(g_sample));
+
+    // Reuse AT ports that are still configured with the same baud rate
+    handoff_ports_t ports;
+    if (handoff_get(HANDOFF_TLV_PORTS, &ports, sizeof(ports)) == 0) {
+        atport_import(&ports);
+    }
+
+    return 0;
+}
+
+/**
+ * daemon_resume_fusion - Restore the board sensor model after fusion_init()
+ *
+ * The model is only kept if the board sensor set did not change.
+ */
+static void daemon_resume_fusion(void)
+{
+    char board_sensors[MAX_BOARD_SENSORS][CONFIG_STRING_LEN];
+    fusion_model_t model;
+
+    if (handoff_get(HANDOFF_TLV_BOARD, board_sensors, sizeof(board_sensors)) == 0 &&
+        memcmp(board_sensors, config.board_sensors, sizeof(board_sensors)) == 0 &&
+        handoff_get(HANDOFF_TLV_FUSION, &model, sizeof(model)) == 0) {
+        *fusion_model() = model;
+        logging_info("Board sensor model restored (%lu samples)", model.samples);
+    }
+}
+
+/* ============================================================================
+ * RESOURCE MONITORING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * check_resources - Log resource usage and warn about growth
+ *
+ * Called with every statistics log. The first call records the baseline;
+ * later calls warn if the number of open file descriptors or the resident
+ * set size grew beyond it, so leaks in the reconnect and reload paths show
+ * up in the log long before the daemon runs out of fds or memory.
+ */
+static void check_resources(void)
+{
+    sys_resources_t res;
+
+    if (sys_resource_usage(&res) < 0) {
+        return;
+    }
+
+    /* HTTP clients come and go, only count the daemon's own descriptors */
+    res.open_fds -= http_client_count();
+
+    if (g_res_baseline.open_fds < 0) {
+        g_res_baseline = res;
+        g_res_last = res;
+        logging_info("Resource baseline: fds=%d, rss=%ld kB, cpu=%lu ms",
+                    res.open_fds, res.rss_kb, res.cpu_ms);
+        return;
+    }
+
+    unsigned long cpu_per_iter_us = (res.cpu_ms - g_res_last.cpu_ms) * 1000UL / STATS_LOG_INTERVAL;
+    logging_info("Resource usage: fds=%d, rss=%ld kB, cpu=%lu us/iteration",
+                res.open_fds, res.rss_kb, cpu_per_iter_us);
+
+    /* The serial port may be closed at either sample, allow one fd of slack */
+    if (res.open_fds > g_res_baseline.open_fds + 1) {
+        logging_warning("Open file descriptors grew from %d to %d",
+                       g_res_baseline.open_fds, res.open_fds);
+    }
+    if (res.rss_kb > g_res_baseline.rss_kb + RESOURCE_RSS_GROWTH_KB) {
+        logging_warning("Resident memory grew from %ld kB to %ld kB",
+                       g_res_baseline.rss_kb, res.rss_kb);
+    }
+
+    g_res_last = res;
+}
+
 /* ============================================================================
  * DAEMON MODE IMPLEMENTATION
  * ============================================================================ */
@@ -186,15 +714,24 @@ static int find_modem_thermal_zone(void)
  */
 int daemon_mode(volatile sig_atomic_t *shutdown_flag)
 {
-    // Check if daemon is already running
-    if (check_daemon_running()) {
+    handoff_daemon_t handoff_state = {0};
+
+    // Ordered AT ports (serial_port first), needed before taking over descriptors
+    atport_configure(&config);
+
+    bool resumed = handoff_receive() && daemon_resume(&handoff_state) == 0;
+
+    // Check if daemon is already running (not when resuming our own re-exec)
+    if (resumed) {
+        // Lock and PID file were taken over, exec() keeps the PID
+    } else if (check_daemon_running()) {
         fprintf(stderr, "Error: Daemon is already running. Use 'status' to check or stop existing instance.\n");
         fprintf(stderr, "Try 'quectel_rm520n_temp --help' for more information\n");
         return 3;
     }
     
     // Acquire daemon lock
-    if (acquire_daemon_lock() < 0) {
+    if (!resumed && acquire_daemon_lock() < 0) {
         fprintf(stderr, "Error: Cannot acquire daemon lock. Another instance may be running.\n");
         fprintf(stderr, "Try 'quectel_rm520n_temp --help' for more information\n");
         return 3;
@@ -210,19 +747,25 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
     // Daemon mode: use syslog output, no stderr
     int log_threshold = config_parse_log_level(config.log_level);
     logging_init(true, false, (log_threshold == LOG_DEBUG), BINARY_NAME);
+    apply_log_async(&config);
 
     // Set up signal handlers for graceful shutdown
     signal(SIGTERM, signal_handler);
     signal(SIGINT, signal_handler);
+    signal(SIGHUP, signal_handler);
+    signal(SIGUSR1, signal_handler);
 
-    // Record daemon start time for uptime metrics
-    g_daemon_start_time = time(NULL);
-
-    logging_info("Daemon started successfully");
+    if (resumed) {
+        logging_info("Daemon resumed after re-exec #%u", handoff_state.reexec_count);
+    } else {
+        // Record daemon start time for uptime metrics
+        g_daemon_start_time = sys_time();
+        logging_info("Daemon started successfully");
+    }
 
     // Check kernel module status
     logging_info("Checking kernel module status...");
-    FILE *modules_fp = fopen("/proc/modules", "r");
+    FILE *modules_fp = sys_fopen("/proc/modules", "r");
     if (modules_fp) {
         char line[MODULE_LINE_LEN];  // Reduced from 256 - module lines are typically short
         while (fgets(line, sizeof(line), modules_fp)) {
@@ -234,7 +777,7 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
     }
     
     // Check platform devices
-    DIR *platform_dir = opendir("/sys/devices/platform");
+    DIR *platform_dir = sys_opendir("/sys/devices/platform");
     if (platform_dir) {
         struct dirent *entry;
         while ((entry = readdir(platform_dir)) != NULL) {
@@ -247,7 +790,7 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
     
     // Check thermal zones (for informational purposes only)
     logging_info("Scanning thermal zones to identify available interfaces...");
-    DIR *thermal_dir = opendir("/sys/devices/virtual/thermal");
+    DIR *thermal_dir = sys_opendir("/sys/devices/virtual/thermal");
     if (thermal_dir) {
         struct dirent *entry;
         while ((entry = readdir(thermal_dir)) != NULL) {
@@ -258,7 +801,7 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
                     continue;
                 }
                 
-                FILE *type_fp = fopen(type_path, "r");
+                FILE *type_fp = sys_fopen(type_path, "r");
                 if (type_fp) {
                     char zone_type[DEVICE_NAME_LEN];
                     if (fgets(zone_type, sizeof(zone_type), type_fp) != NULL) {
@@ -285,22 +828,92 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
     }
     
     // Main daemon loop
-    int serial_reconnect_attempts = 0;
     int reconnect_delay = SERIAL_INITIAL_RECONNECT_DELAY;
-    int failed_cycles = 0;  // Track complete failed reconnect cycles
-    g_serial_fd = -1;  // Use global for emergency cleanup access
 
     // Find hwmon path once (cached for performance)
-    char hwmon_path[PATH_MAX_LEN] = {0};
-    int hwmon_available = (find_quectel_hwmon_path(hwmon_path, sizeof(hwmon_path)) == 0);
-    if (hwmon_available) {
-        logging_info("Hwmon interface available: %s", hwmon_path);
+    g_hwmon_available = (find_quectel_hwmon_path(g_hwmon_path, sizeof(g_hwmon_path)) == 0);
+    if (g_hwmon_available) {
+        logging_info("Hwmon interface available: %s", g_hwmon_path);
     } else {
         logging_warning("Hwmon interface not found, will skip hwmon writes");
     }
 
+    // Opt-in real-time sampling (SCHED_FIFO, CPU pinning, locked memory)
+    apply_realtime(&config, resumed);
+
+    // Opt-in local HTTP endpoint for dashboards (keeps serving the last sample after re-exec)
+    if (http_open(config.http_listen) != 0) {
+        logging_warning("HTTP endpoint disabled");
+    }
+    http_publish(&g_sample);
+
+    // Resolve board sensors for the fallback estimate
+    fusion_init(&config);
+
+    // Reaction rules (active rules and cooldowns survive a re-exec)
+    rules_configure(&config);
+    headroom_configure(&config);
+    admission_configure(&config);
+
+    // Time-at-temperature counters (loaded from file, or taken over on re-exec)
+    histogram_configure(&config);
+
+    // Sample ring for history export (continued from /var/run)
+    history_configure(&config);
+
+    // Recovery ladder for a modem that stops answering
+    recovery_configure(&config);
+    if (resumed) {
+        daemon_resume_fusion();
+        headroom_resume();
+        histogram_data_t histogram;
+        if (handoff_get(HANDOFF_TLV_HISTOGRAM, &histogram, sizeof(histogram)) == 0) {
+            histogram_import(&histogram);
+        }
+        static histogram_window_t window;   /* ~24 KB, kept off the stack */
+        if (handoff_get(HANDOFF_TLV_WINDOW, &window, sizeof(window)) == 0) {
+            histogram_window_import(&window);
+        }
+        handoff_rules_t rules;
+        if (handoff_get(HANDOFF_TLV_RULES, &rules, sizeof(rules)) == 0) {
+            rules_import(&rules);
+        }
+        recovery_state_t recovery;
+        if (handoff_get(HANDOFF_TLV_RECOVERY, &recovery, sizeof(recovery)) == 0) {
+            recovery_import(&recovery);
+        }
+        handoff_release();
+    }
+
     // Check shutdown flag for graceful termination
     while (shutdown_flag && !(*shutdown_flag)) {
+        // Re-exec on SIGHUP (reload/upgrade), handing over state and fds
+        if (reexec_requested) {
+            reexec_requested = 0;
+            logging_info("Re-exec requested");
+            daemon_reexec(&handoff_state);
+        }
+
+        // Collect finished rule actions
+        rules_reap();
+
+        // Yield the serial port while another tool (bench) holds the pause file
+        if (daemon_pause_requested()) {
+            if (!g_paused) {
+                atport_close_all();
+                g_paused = true;
+                set_daemon_paused(1);
+                logging_info("Pause requested, serial port released");
+            }
+            publish_estimate();
+            sleep_interval(config.interval);
+            continue;
+        } else if (g_paused) {
+            g_paused = false;
+            set_daemon_paused(0);
+            logging_info("Pause ended, resuming sampling");
+        }
+
         // Increment iteration counter
         g_stats.total_iterations++;
 
@@ -310,7 +923,7 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
 
         // Update kernel module thresholds from UCI config (if changed)
         static time_t last_config_check = 0;
-        time_t current_time = time(NULL);
+        time_t current_time = sys_time();
         if (current_time - last_config_check >= CONFIG_CHECK_INTERVAL) {
             logging_debug("Checking for UCI config changes...");
 
@@ -325,11 +938,47 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
                 // Check if config actually changed
                 int config_changed = (strcmp(previous_config.serial_port, config.serial_port) != 0) ||
                                     (previous_config.baud_rate != config.baud_rate) ||
+                                    (previous_config.at_port_count != config.at_port_count) ||
+                                    (memcmp(previous_config.at_ports, config.at_ports,
+                                            sizeof(config.at_ports)) != 0) ||
                                     (previous_config.interval != config.interval) ||
                                     (strcmp(previous_config.log_level, config.log_level) != 0) ||
                                     (strcmp(previous_config.temp_modem_prefix, config.temp_modem_prefix) != 0) ||
                                     (strcmp(previous_config.temp_ap_prefix, config.temp_ap_prefix) != 0) ||
-                                    (strcmp(previous_config.temp_pa_prefix, config.temp_pa_prefix) != 0);
+                                    (strcmp(previous_config.temp_pa_prefix, config.temp_pa_prefix) != 0) ||
+                                    (previous_config.board_sensor_count != config.board_sensor_count) ||
+                                    (memcmp(previous_config.board_sensors, config.board_sensors,
+                                            sizeof(config.board_sensors)) != 0) ||
+                                    (previous_config.board_agree_delta != config.board_agree_delta) ||
+                                    (previous_config.interval_max != config.interval_max) ||
+                                    (strcmp(previous_config.temp_min, config.temp_min) != 0) ||
+                                    (strcmp(previous_config.temp_max, config.temp_max) != 0) ||
+                                    (strcmp(previous_config.temp_crit, config.temp_crit) != 0) ||
+                                    (strcmp(previous_config.temp_default, config.temp_default) != 0) ||
+                                    (previous_config.headroom_span != config.headroom_span) ||
+                                    (previous_config.headroom_horizon != config.headroom_horizon) ||
+                                    (previous_config.headroom_hysteresis != config.headroom_hysteresis) ||
+                                    (previous_config.admission_margin != config.admission_margin) ||
+                                    (strcmp(previous_config.histogram_file, config.histogram_file) != 0) ||
+                                    (previous_config.histogram_save != config.histogram_save) ||
+                                    (previous_config.stress_ea != config.stress_ea) ||
+                                    (previous_config.stress_ref != config.stress_ref) ||
+                                    (previous_config.quantile_window != config.quantile_window) ||
+                                    (previous_config.history_size != config.history_size) ||
+                                    (previous_config.recovery_reopen_timeout != config.recovery_reopen_timeout) ||
+                                    (previous_config.recovery_reset_timeout != config.recovery_reset_timeout) ||
+                                    (previous_config.recovery_usb_timeout != config.recovery_usb_timeout) ||
+                                    (previous_config.recovery_power_timeout != config.recovery_power_timeout) ||
+                                    (strcmp(previous_config.usb_device, config.usb_device) != 0) ||
+                                    (strcmp(previous_config.power_gpio, config.power_gpio) != 0) ||
+                                    (previous_config.power_gpio_active_low != config.power_gpio_active_low) ||
+                                    (previous_config.log_async != config.log_async) ||
+                                    (previous_config.realtime != config.realtime) ||
+                                    (previous_config.rt_priority != config.rt_priority) ||
+                                    (previous_config.cpu_affinity != config.cpu_affinity) ||
+                                    (strcmp(previous_config.http_listen, config.http_listen) != 0) ||
+                                    (previous_config.rule_count != config.rule_count) ||
+                                    (memcmp(previous_config.rules, config.rules, sizeof(config.rules)) != 0);
 
                 if (config_changed) {
                     logging_info("UCI configuration changed, updating settings");
@@ -337,21 +986,44 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
                     // If log level changed, update logging threshold
                     if (strcmp(previous_config.log_level, config.log_level) != 0) {
                         int new_threshold = config_parse_log_level(config.log_level);
-                        ulog_threshold(new_threshold);
+                        logging_set_threshold(new_threshold);
                         logging_info("Log level changed to '%s'", config.log_level);
                     }
 
-                    // If serial port or baud rate changed, close current connection
-                    // It will be reopened with new settings on next iteration
-                    if (strcmp(previous_config.serial_port, config.serial_port) != 0 ||
-                        previous_config.baud_rate != config.baud_rate) {
-                        if (g_serial_fd >= 0) {
-                            logging_info("Serial configuration changed, closing current connection");
-                            close(g_serial_fd);
-                            g_serial_fd = -1;
-                        }
+                    if (previous_config.log_async != config.log_async) {
+                        apply_log_async(&config);
                     }
 
+                    // Apply the AT port list; removed ports and all ports on a baud
+                    // rate change are closed and reopened on the next iteration
+                    atport_configure(&config);
+
+                    // Re-apply real-time mode if its settings changed
+                    if (previous_config.realtime != config.realtime ||
+                        previous_config.rt_priority != config.rt_priority ||
+                        previous_config.cpu_affinity != config.cpu_affinity) {
+                        apply_realtime(&config, previous_config.realtime);
+                    }
+
+                    // Rebind the HTTP endpoint if its address changed
+                    if (strcmp(previous_config.http_listen, config.http_listen) != 0 &&
+                        http_open(config.http_listen) != 0) {
+                        logging_warning("HTTP endpoint disabled");
+                    }
+
+                    // Re-resolve board sensors (model resets if the set changed)
+                    fusion_init(&config);
+
+                    // Unchanged rules keep their state and cooldown
+                    rules_configure(&config);
+
+                    // Thresholds may have moved, the score follows on the next sample
+                    headroom_configure(&config);
+                    admission_configure(&config);
+                    histogram_configure(&config);
+                    history_configure(&config);
+                    recovery_configure(&config);
+
                     if (uci_config_mode() == 0) {
                         logging_info("Kernel module thresholds updated from UCI config");
                     } else {
@@ -369,50 +1041,34 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
             last_config_check = current_time;
         }
         
-        // Initialize or reconnect serial port
-        if (g_serial_fd < 0) {
-            g_serial_fd = init_serial_port(loop_config.serial_port, loop_config.baud_rate);
-            if (g_serial_fd < 0) {
-                g_stats.serial_errors++;
-                if (serial_reconnect_attempts < SERIAL_MAX_RECONNECT_ATTEMPTS) {
-                    serial_reconnect_attempts++;
-                    logging_warning("Serial port init failed, retry %d/%d in %d seconds",
-                                   serial_reconnect_attempts, SERIAL_MAX_RECONNECT_ATTEMPTS, reconnect_delay);
-                    sleep(reconnect_delay);
-                    reconnect_delay *= 2; // Exponential backoff
-                    if (reconnect_delay > SERIAL_MAX_RECONNECT_DELAY) {
-                        reconnect_delay = SERIAL_MAX_RECONNECT_DELAY;
-                    }
-                    continue;
-                }
-                // Exhausted reconnect attempts for this cycle
-                failed_cycles++;
-                logging_error("Failed to initialize serial port after %d attempts (cycle %d/%d)",
-                             SERIAL_MAX_RECONNECT_ATTEMPTS, failed_cycles, SERIAL_MAX_FAILED_CYCLES);
-
-                if (failed_cycles >= SERIAL_MAX_FAILED_CYCLES) {
-                    logging_error("Exiting after %d failed reconnect cycles. Check serial port configuration.",
-                                 SERIAL_MAX_FAILED_CYCLES);
-                    release_daemon_lock();
-                    return 1;
-                }
+        // Open the active AT port and its warm standby (reopens failed ports when due)
+        bool was_connected = atport_connected();
+        if (atport_open() != 0) {
+            g_stats.serial_errors++;
 
-                // Reset for next cycle
-                serial_reconnect_attempts = 0;
-                reconnect_delay = SERIAL_INITIAL_RECONNECT_DELAY;
-                continue;
-            } else {
-                logging_info("Serial port initialized successfully");
-                serial_reconnect_attempts = 0;
-                reconnect_delay = SERIAL_INITIAL_RECONNECT_DELAY;
-                // Don't reset failed_cycles here - only reset on successful read
+            // Escalates through the recovery ladder; the daemon never gives up
+            recovery_failure();
+            int delay = recovery_delay(reconnect_delay);
+            logging_warning("Serial port init failed, retry in %d seconds", delay);
+            backoff_sleep(delay, shutdown_flag);
+            reconnect_delay *= 2; // Exponential backoff
+            if (reconnect_delay > SERIAL_MAX_RECONNECT_DELAY) {
+                reconnect_delay = SERIAL_MAX_RECONNECT_DELAY;
             }
+            continue;
+        } else if (!was_connected) {
+            logging_info("Serial port initialized successfully");
+            reconnect_delay = SERIAL_INITIAL_RECONNECT_DELAY;
+            // The outage only ends with a successful read
         }
-        
+
+        // Probe the standby and move back to a preferred port once healthy
+        atport_maintain();
+
         // Read temperature if serial port is available
-        if (g_serial_fd >= 0) {
+        if (atport_connected()) {
             char response[MAX_RESPONSE];
-            if (send_at_command(g_serial_fd, AT_COMMAND, response, sizeof(response)) > 0) {
+            if (atport_command(AT_COMMAND, response, sizeof(response)) > 0) {
                 // Process temperature response
                 size_t resp_len = strlen(response);
                 logging_debug("Raw AT+QTEMP response length: %zu bytes", resp_len);
@@ -428,106 +1084,76 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
                     int best_temp_mdeg;
                     if (!select_best_temperature(modem_temp, ap_temp, pa_temp, &best_temp_mdeg)) {
                         g_stats.parse_errors++;
+                        publish_estimate();
+                        recovery_failure();
                         continue;
                     }
                     
-                    // Increment successful read counter and reset failed cycles
+                    // Increment successful read counter and end a recovery
                     g_stats.successful_reads++;
-                    failed_cycles = 0;  // Reset on successful read
-
-                    // Write to main sysfs interface (primary interface for CLI tool)
-                    // Avoid TOCTOU race by directly attempting fopen without access() check
-                    {
-                        FILE *fp = fopen("/sys/kernel/quectel_rm520n_thermal/temp", "w");
-                        if (fp) {
-                            fprintf(fp, "%d", best_temp_mdeg);
-                            fclose(fp);
-                            logging_debug("Wrote temperature to main sysfs interface: %d m°C", best_temp_mdeg);
-                        } else {
-                            logging_debug("Main sysfs interface not available");
-                        }
-                    }
-                    
-                    // Write to hwmon interface (for system monitoring tools)
-                    // Avoid TOCTOU race by directly attempting fopen without access() check
-                    if (hwmon_available) {
-                        FILE *fp = fopen(hwmon_path, "w");
-                        if (fp) {
-                            fprintf(fp, "%d", best_temp_mdeg);
-                            fclose(fp);
-                            logging_debug("Wrote temperature to hwmon interface: %d m°C", best_temp_mdeg);
-                        } else {
-                            logging_debug("Hwmon interface not writable: %s", hwmon_path);
-                        }
-                    }
-                    
-                    // Write to platform device interface if available
-                    // Avoid TOCTOU race by directly attempting fopen without access() check
-                    char platform_path[PLATFORM_PATH_LEN];  // Reduced from 256 - platform paths are short
-                    if (snprintf(platform_path, sizeof(platform_path), "/sys/devices/platform/quectel_rm520n_temp/cur_temp") >= sizeof(platform_path)) {
-                        logging_warning("Platform path truncated, device write skipped");
-                    } else {
-                        FILE *fp = fopen(platform_path, "w");
-                        if (fp) {
-                            fprintf(fp, "%d", best_temp_mdeg);
-                            fclose(fp);
-                            logging_debug("Wrote temperature to platform device: %s", platform_path);
-                        }
-                    }
-                    
-                    // Write to platform sensor interface if available
-                    // Avoid TOCTOU race by directly attempting fopen without access() check
-                    if (snprintf(platform_path, sizeof(platform_path), "/sys/devices/platform/soc/soc:quectel-temp-sensor/cur_temp") >= sizeof(platform_path)) {
-                        logging_warning("Platform sensor path truncated, sensor write skipped");
+                    recovery_success();
+
+                    publish_temperature(best_temp_mdeg, false);
+
+                    // extract_temp_values() leaves missing sensors at 0, a valid reading;
+                    // rules and histogram bands skip missing sensors
+                    const bool sensor_present[HISTOGRAM_SENSORS] = {
+                        temp_sensor_present(response, loop_config.temp_modem_prefix),
+                        temp_sensor_present(response, loop_config.temp_ap_prefix),
+                        temp_sensor_present(response, loop_config.temp_pa_prefix)
+                    };
+                    const int sensor_mdeg[HISTOGRAM_SENSORS] = {
+                        modem_temp * 1000, ap_temp * 1000, pa_temp * 1000
+                    };
+
+                    rules_sample_t sample = {
+                        .temp_mdeg = best_temp_mdeg,
+                        .modem_mdeg = sensor_mdeg[HISTOGRAM_MODEM],
+                        .ap_mdeg = sensor_mdeg[HISTOGRAM_AP],
+                        .pa_mdeg = sensor_mdeg[HISTOGRAM_PA],
+                        .has_modem = sensor_present[HISTOGRAM_MODEM],
+                        .has_ap = sensor_present[HISTOGRAM_AP],
+                        .has_pa = sensor_present[HISTOGRAM_PA]
+                    };
+                    rules_evaluate(&sample);
+
+                    // Time spent per 1 °C band, per sensor
+                    histogram_update(sensor_mdeg, sensor_present);
+
+                    // Individual sensors in °C (empty if missing from the response)
+                    publish_sensor("temp_modem", sensor_present[HISTOGRAM_MODEM], modem_temp);
+                    publish_sensor("temp_ap", sensor_present[HISTOGRAM_AP], ap_temp);
+                    publish_sensor("temp_pa", sensor_present[HISTOGRAM_PA], pa_temp);
+
+                    history_record(best_temp_mdeg, modem_temp, ap_temp, pa_temp, false);
+
+                    // Learn the board sensor offset and track agreement
+                    int board_mdeg;
+                    if (fusion_enabled() && fusion_read_board(&board_mdeg)) {
+                        g_sources_agree = fusion_sources_agree(best_temp_mdeg, board_mdeg,
+                                                               loop_config.board_agree_delta);
+                        g_agree_board_mdeg = board_mdeg;
+                        fusion_update(best_temp_mdeg, board_mdeg);
                     } else {
-                        FILE *fp = fopen(platform_path, "w");
-                        if (fp) {
-                            fprintf(fp, "%d", best_temp_mdeg);
-                            fclose(fp);
-                            logging_debug("Wrote temperature to platform sensor: %s", platform_path);
-                        }
-                    }
-                    
-                    // Write to thermal zone if available (for DTS integration)
-                    // Use cached thermal zone path for performance
-                    if (find_modem_thermal_zone() == 0) {
-                        FILE *temp_fp = fopen(g_thermal_zone_path, "w");
-                        if (temp_fp) {
-                            fprintf(temp_fp, "%d", best_temp_mdeg);
-                            fclose(temp_fp);
-                            logging_debug("Wrote temperature to modem thermal zone: %s", g_thermal_zone_path);
-                        } else {
-                            logging_debug("Modem thermal zone temp file not writable: %s", g_thermal_zone_path);
-                            /* Invalidate cache so we rescan next time */
-                            g_thermal_zone_cached = 0;
-                        }
+                        g_sources_agree = false;
                     }
                 } else {
                     // Temperature parsing failed
                     g_stats.parse_errors++;
                     logging_warning("Failed to parse temperature from AT response");
+                    publish_estimate();
+
+                    // A modem that answers garbage needs recovery as much as a silent one
+                    recovery_failure();
                 }
             } else {
                 // AT command failed
                 g_stats.at_command_errors++;
                 logging_warning("AT command communication failed");
+                publish_estimate();
 
-                // Handle serial communication errors
-                if (++serial_reconnect_attempts > 3) {
-                    failed_cycles++;
-                    logging_warning("Multiple AT command failures, reopening serial port (cycle %d/%d)",
-                                   failed_cycles, SERIAL_MAX_FAILED_CYCLES);
-                    close(g_serial_fd);
-                    g_serial_fd = -1;
-                    serial_reconnect_attempts = 0;
-
-                    if (failed_cycles >= SERIAL_MAX_FAILED_CYCLES) {
-                        logging_error("Exiting after %d failed communication cycles. Check serial port configuration.",
-                                     SERIAL_MAX_FAILED_CYCLES);
-                        release_daemon_lock();
-                        return 1;
-                    }
-                }
+                // Repeated failures reopen the ports, then escalate
+                recovery_failure();
             }
         }
 
@@ -537,22 +1163,43 @@ int daemon_mode(volatile sig_atomic_t *shutdown_flag)
                 ? (100.0 * g_stats.successful_reads / g_stats.total_iterations)
                 : 0.0;
             logging_info("Daemon statistics: iterations=%lu, successful=%lu (%.1f%%), "
-                        "serial_errors=%lu, at_errors=%lu, parse_errors=%lu",
+                        "serial_errors=%lu, at_errors=%lu, parse_errors=%lu, estimated=%lu",
                         g_stats.total_iterations, g_stats.successful_reads, success_rate,
-                        g_stats.serial_errors, g_stats.at_command_errors, g_stats.parse_errors);
+                        g_stats.serial_errors, g_stats.at_command_errors, g_stats.parse_errors,
+                        g_stats.estimated_writes);
+            if (fusion_enabled()) {
+                fusion_model_t *model = fusion_model();
+                logging_info("Board sensor model: offset=%.1f°C, samples=%lu, sources %s",
+                            model->offset_mdeg / 1000.0, model->samples,
+                            g_sources_agree ? "agree" : "differ");
+            }
+            atport_log_health();
+            rules_log_stats();
+            recovery_log_stats();
+            log_lateness();
+            check_resources();
         }
 
+        publish_stats();
+
         // Wait for next interval (use config instead of loop_config which is out of scope)
-        sleep(config.interval);
+        wait_for_next_sample(shutdown_flag);
     }
 
     // Cleanup
-    if (g_serial_fd >= 0) {
-        close(g_serial_fd);
-        g_serial_fd = -1;
+    atport_close_all();
+
+    if (g_paused) {
+        set_daemon_paused(0);
+        g_paused = false;
     }
 
+    http_close();
+    histogram_close();
+    history_close();
+    state_remove();
     release_daemon_lock();
     logging_info("Daemon shutdown complete");
+    logging_async_stop();
     return 0;
 }
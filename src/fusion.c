@@ -0,0 +1,344 @@
+/**
+ * @file fusion.c
+ * @brief Board sensor fusion for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the board sensor fallback used by the daemon when
+ * the AT path is unavailable (port busy, modem resetting, reconnect backoff).
+ * While modem readings are available, an online offset model between the
+ * modem temperature and one or more board hwmon sensors is learned. When
+ * the AT path goes down, the model turns a board reading into an estimated
+ * modem temperature so the thermal zone never keeps a stale value.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/config.h"
+#include "include/system.h"
+#include "include/fusion.h"
+
+/* ============================================================================
+ * STATE
+ * ============================================================================ */
+
+/* Configured sensor specifications and resolved input paths */
+static char g_board_specs[MAX_BOARD_SENSORS][CONFIG_STRING_LEN];
+static char g_board_paths[MAX_BOARD_SENSORS][PATH_MAX_LEN];
+static int g_board_count = 0;
+static unsigned int g_resolved_mask = 0;   /* Bit i = g_board_paths[i] resolved */
+
+/* Learned offset model */
+static fusion_model_t g_model = {0};
+
+/* ============================================================================
+ * SENSOR RESOLUTION
+ * ============================================================================ */
+
+/**
+ * resolve_board_sensor - Resolve a sensor specification to a temp*_input path
+ * @spec: Absolute sysfs path, hwmon name or "name:tempN"
+ * @path_buf: Buffer to store the resolved path
+ * @buf_size: Size of the buffer
+ *
+ * Return: 0 on success, -1 if no matching hwmon device was found
+ */
+static int resolve_board_sensor(const char *spec, char *path_buf, size_t buf_size)
+{
+    char name[CONFIG_STRING_LEN];
+    const char *channel = "temp1";
+
+    if (spec[0] == '/') {
+        if (snprintf(path_buf, buf_size, "%s", spec) >= (int)buf_size) {
+            return -1;
+        }
+        return 0;
+    }
+
+    SAFE_STRNCPY(name, spec, sizeof(name));
+    char *sep = strchr(name, ':');
+    if (sep) {
+        *sep = '\0';
+        channel = sep + 1;
+    }
+
+    DIR *hwmon_dir = sys_opendir("/sys/class/hwmon");
+    if (!hwmon_dir) {
+        return -1;
+    }
+
+    int found = -1;
+    struct dirent *entry;
+    while ((entry = readdir(hwmon_dir)) != NULL) {
+        char name_path[PATH_MAX_LEN];
+        char dev_name[DEVICE_NAME_LEN];
+
+        if (strncmp(entry->d_name, "hwmon", 5) != 0) {
+            continue;
+        }
+
+        if (snprintf(name_path, sizeof(name_path), "/sys/class/hwmon/%s/name",
+                     entry->d_name) >= (int)sizeof(name_path)) {
+            continue;
+        }
+
+        FILE *fp = sys_fopen(name_path, "r");
+        if (!fp) {
+            continue;
+        }
+        if (fgets(dev_name, sizeof(dev_name), fp) == NULL) {
+            fclose(fp);
+            continue;
+        }
+        fclose(fp);
+        STRIP_NEWLINE(dev_name);
+
+        if (strcmp(dev_name, name) != 0) {
+            continue;
+        }
+
+        if (snprintf(path_buf, buf_size, "/sys/class/hwmon/%s/%s_input",
+                     entry->d_name, channel) < (int)buf_size &&
+            sys_access(path_buf, R_OK) == 0) {
+            found = 0;
+            break;
+        }
+    }
+    closedir(hwmon_dir);
+
+    return found;
+}
+
+/**
+ * resolve_all - (Re)resolve all configured board sensors
+ *
+ * Unresolvable sensors keep an empty path and are skipped on reads. The
+ * board reading is the mean of the resolved set, so the learned offset is
+ * reset when that set changes.
+ *
+ * Return: Number of resolved sensors
+ */
+static int resolve_all(void)
+{
+    int resolved = 0;
+    unsigned int mask = 0;
+
+    for (int i = 0; i < g_board_count; i++) {
+        if (resolve_board_sensor(g_board_specs[i], g_board_paths[i], sizeof(g_board_paths[i])) == 0) {
+            logging_debug("Board sensor '%s' -> %s", g_board_specs[i], g_board_paths[i]);
+            mask |= 1u << i;
+            resolved++;
+        } else {
+            g_board_paths[i][0] = '\0';
+            logging_debug("Board sensor '%s' not found", g_board_specs[i]);
+        }
+    }
+
+    if (g_resolved_mask != 0 && mask != g_resolved_mask && g_model.samples > 0) {
+        logging_info("Board sensor set changed (%d of %d found), relearning offset",
+                    resolved, g_board_count);
+        memset(&g_model, 0, sizeof(g_model));
+    }
+    g_resolved_mask = mask;
+
+    return resolved;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Resolve configured board sensors to hwmon input paths
+ *
+ * @param config Configuration with board sensor list
+ * @return Number of resolved sensors (0 if fusion is disabled)
+ */
+int fusion_init(const config_t *config)
+{
+    int changed = (config->board_sensor_count != g_board_count);
+
+    for (int i = 0; !changed && i < g_board_count; i++) {
+        changed = (strcmp(config->board_sensors[i], g_board_specs[i]) != 0);
+    }
+
+    if (changed) {
+        memset(&g_model, 0, sizeof(g_model));
+        g_resolved_mask = 0;
+        g_board_count = config->board_sensor_count;
+        for (int i = 0; i < g_board_count; i++) {
+            SAFE_STRNCPY(g_board_specs[i], config->board_sensors[i], sizeof(g_board_specs[i]));
+        }
+    }
+
+    if (g_board_count == 0) {
+        return 0;
+    }
+
+    int resolved = resolve_all();
+    if (resolved == 0) {
+        logging_warning("None of the %d configured board sensors could be found", g_board_count);
+    } else {
+        logging_info("Board sensor fallback enabled with %d of %d sensors", resolved, g_board_count);
+    }
+
+    return resolved;
+}
+
+/**
+ * Check if at least one board sensor is configured and resolved
+ *
+ * @return true if board sensors are available
+ */
+bool fusion_enabled(void)
+{
+    for (int i = 0; i < g_board_count; i++) {
+        if (g_board_paths[i][0] != '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Read the board temperature (mean of all resolved board sensors)
+ *
+ * The offset is learned against the mean of the full resolved set, so a
+ * partial reading would shift the board value by the spread between the
+ * sensors; it is rejected instead. The sensor paths are re-resolved once
+ * if a sensor could not be read, since hwmon device numbering may change
+ * when drivers are reloaded.
+ *
+ * @param board_mdeg Pointer to store result in m°C
+ * @return 1 on success, 0 if no board sensor could be read
+ */
+int fusion_read_board(int *board_mdeg)
+{
+    if (!board_mdeg || g_board_count == 0) {
+        return 0;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        long sum = 0;
+        int count = 0;
+        int expected = 0;
+
+        for (int i = 0; i < g_board_count; i++) {
+            if (g_board_paths[i][0] == '\0') {
+                continue;
+            }
+            expected++;
+
+            FILE *fp = sys_fopen(g_board_paths[i], "r");
+            if (!fp) {
+                continue;
+            }
+
+            int value;
+            if (fscanf(fp, "%d", &value) == 1 &&
+                value >= TEMP_ABSOLUTE_MIN && value <= TEMP_ABSOLUTE_MAX) {
+                sum += value;
+                count++;
+            }
+            fclose(fp);
+        }
+
+        if (count > 0 && count == expected) {
+            *board_mdeg = (int)(sum / count);
+            return 1;
+        }
+
+        if (attempt == 0 && resolve_all() == 0) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Feed a paired modem/board sample into the offset model
+ *
+ * The first sample seeds the offset directly; later samples update an
+ * exponentially weighted mean and variance of the residual.
+ *
+ * @param modem_mdeg Modem temperature from AT+QTEMP in m°C
+ * @param board_mdeg Board temperature read at the same time in m°C
+ */
+void fusion_update(int modem_mdeg, int board_mdeg)
+{
+    double diff = (double)(modem_mdeg - board_mdeg);
+
+    if (g_model.samples == 0) {
+        g_model.offset_mdeg = diff;
+        g_model.variance = 0.0;
+    } else {
+        double residual = diff - g_model.offset_mdeg;
+        g_model.offset_mdeg += FUSION_EWMA_WEIGHT * residual;
+        g_model.variance = (1.0 - FUSION_EWMA_WEIGHT) *
+                           (g_model.variance + FUSION_EWMA_WEIGHT * residual * residual);
+    }
+    g_model.samples++;
+
+    logging_debug("Fusion model: modem=%d board=%d offset=%.0f m°C variance=%.0f (n=%lu)",
+                 modem_mdeg, board_mdeg, g_model.offset_mdeg, g_model.variance,
+                 g_model.samples);
+}
+
+/**
+ * Estimate the modem temperature from a board reading
+ *
+ * @param board_mdeg Board temperature in m°C
+ * @param estimate_mdeg Pointer to store the estimate in m°C
+ * @return 1 if the model is trained and an estimate was produced, 0 otherwise
+ */
+int fusion_estimate(int board_mdeg, int *estimate_mdeg)
+{
+    if (!estimate_mdeg || g_model.samples < FUSION_MIN_SAMPLES) {
+        return 0;
+    }
+
+    double offset = g_model.offset_mdeg;
+    long estimate = board_mdeg + (long)(offset + (offset >= 0 ? 0.5 : -0.5));
+    if (estimate < TEMP_ABSOLUTE_MIN || estimate > TEMP_ABSOLUTE_MAX) {
+        return 0;
+    }
+
+    *estimate_mdeg = (int)estimate;
+    return 1;
+}
+
+/**
+ * Check if modem and board-derived readings agree
+ *
+ * @param modem_mdeg Modem temperature in m°C
+ * @param board_mdeg Board temperature in m°C
+ * @param tolerance_mdeg Maximum allowed difference in m°C
+ * @return true if the model is trained and the residual is within tolerance
+ */
+bool fusion_sources_agree(int modem_mdeg, int board_mdeg, int tolerance_mdeg)
+{
+    int estimate;
+
+    if (!fusion_estimate(board_mdeg, &estimate)) {
+        return false;
+    }
+
+    return abs(modem_mdeg - estimate) <= tolerance_mdeg;
+}
+
+/**
+ * Access the offset model (for statistics logging)
+ *
+ * @return Pointer to the live model
+ */
+fusion_model_t *fusion_model(void)
+{
+    return &g_model;
+}
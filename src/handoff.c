@@ -0,0 +1,363 @@
+/**
+ * @file handoff.c
+ * @brief Daemon re-exec state handoff for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the state handoff used when the daemon re-executes
+ * itself on SIGHUP (config reload, binary upgrade). State is written as
+ * type-length-value records into an anonymous memfd that is inherited by
+ * the new image together with the serial port and lock descriptors, so the
+ * new image resumes sampling immediately with the previous statistics.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/handoff.h"
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define HANDOFF_MAX_ARGS 32
+#define HANDOFF_MAX_FDS  (HANDOFF_MAX_PORTS + 1)   /* AT ports and the daemon lock */
+
+/* Blob and record headers */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} handoff_header_t;
+
+typedef struct {
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t len;
+} handoff_record_t;
+
+/* Writer state (memfd being filled before exec) */
+static int g_handoff_fd = -1;
+static int g_kept_fds[HANDOFF_MAX_FDS];    /* Cleared FD_CLOEXEC, restored on abort */
+static int g_kept_count = 0;
+
+/* Reader state (blob received from the previous image) */
+static unsigned char *g_handoff_blob = NULL;
+static size_t g_handoff_size = 0;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * write_all - Write a buffer completely
+ * @fd: File descriptor
+ * @data: Data to write
+ * @len: Length in bytes
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int write_all(int fd, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * abort_handoff - Discard the state collected so far
+ *
+ * Descriptors kept for the new image are made close-on-exec again, so
+ * they do not leak into children started later.
+ */
+static void abort_handoff(void)
+{
+    if (g_handoff_fd >= 0) {
+        close(g_handoff_fd);
+        g_handoff_fd = -1;
+    }
+    for (int i = 0; i < g_kept_count; i++) {
+        int flags = fcntl(g_kept_fds[i], F_GETFD);
+        if (flags >= 0) {
+            fcntl(g_kept_fds[i], F_SETFD, flags | FD_CLOEXEC);
+        }
+    }
+    g_kept_count = 0;
+    unsetenv(HANDOFF_ENV);
+}
+
+/**
+ * read_cmdline - Read the command line of the current process
+ * @buf: Buffer for the NUL-separated arguments
+ * @size: Size of the buffer
+ * @argv: Array to fill with argument pointers (NULL terminated)
+ *
+ * Return: Number of arguments, -1 on error
+ */
+static int read_cmdline(char *buf, size_t size, char **argv)
+{
+    /* Our own process, so always the real /proc */
+    int fd = open("/proc/self/cmdline", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ssize_t len = read(fd, buf, size - 1);
+    close(fd);
+    if (len <= 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+
+    int argc = 0;
+    for (char *p = buf; p < buf + len && argc < HANDOFF_MAX_ARGS; p += strlen(p) + 1) {
+        argv[argc++] = p;
+    }
+    argv[argc] = NULL;
+
+    return argc;
+}
+
+/* ============================================================================
+ * WRITER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Start collecting state for a re-exec
+ *
+ * @return 0 on success, -1 if no memfd could be created
+ */
+int handoff_begin(void)
+{
+    abort_handoff();
+
+    /* No MFD_CLOEXEC: the descriptor must survive exec() */
+    g_handoff_fd = memfd_create("quectel_handoff", 0);
+    if (g_handoff_fd < 0) {
+        logging_error("Cannot create handoff memfd: %s", strerror(errno));
+        return -1;
+    }
+
+    handoff_header_t hdr = { .magic = HANDOFF_MAGIC, .version = HANDOFF_VERSION };
+    if (write_all(g_handoff_fd, &hdr, sizeof(hdr)) < 0) {
+        abort_handoff();
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Append a state record
+ *
+ * @param type Record type
+ * @param data Record payload
+ * @param len Payload length in bytes
+ * @return 0 on success, -1 on error
+ */
+int handoff_put(uint16_t type, const void *data, uint32_t len)
+{
+    if (g_handoff_fd < 0 || (!data && len > 0)) {
+        return -1;
+    }
+
+    handoff_record_t rec = { .type = type, .len = len };
+    if (write_all(g_handoff_fd, &rec, sizeof(rec)) < 0 ||
+        write_all(g_handoff_fd, data, len) < 0) {
+        logging_error("Failed to write handoff record %u: %s", type, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Keep a file descriptor open across exec()
+ *
+ * @param fd File descriptor to inherit
+ * @return 0 on success, -1 on error
+ */
+int handoff_keep_fd(int fd)
+{
+    int flags = fcntl(fd, F_GETFD);
+    if (flags < 0) {
+        return -1;
+    }
+    if (!(flags & FD_CLOEXEC)) {
+        return 0;
+    }
+    if (g_kept_count >= HANDOFF_MAX_FDS) {
+        return -1;
+    }
+    if (fcntl(fd, F_SETFD, flags & ~FD_CLOEXEC) != 0) {
+        return -1;
+    }
+    g_kept_fds[g_kept_count++] = fd;
+    return 0;
+}
+
+/**
+ * Discard the collected state after a failed re-exec
+ *
+ * Closes the memfd and makes the descriptors passed to handoff_keep_fd()
+ * close-on-exec again. Safe to call if nothing was collected.
+ */
+void handoff_abort(void)
+{
+    abort_handoff();
+}
+
+/**
+ * Re-execute the daemon binary with the collected state
+ *
+ * @return Only returns on failure (-1); the collected state is discarded
+ */
+int handoff_exec(void)
+{
+    char cmdline[1024];
+    char *argv[HANDOFF_MAX_ARGS + 1];
+    char fd_str[SMALL_BUFFER_LEN];
+
+    if (g_handoff_fd < 0) {
+        return -1;
+    }
+
+    if (read_cmdline(cmdline, sizeof(cmdline), argv) < 1) {
+        logging_error("Cannot read own command line for re-exec");
+        abort_handoff();
+        return -1;
+    }
+
+    snprintf(fd_str, sizeof(fd_str), "%d", g_handoff_fd);
+    if (setenv(HANDOFF_ENV, fd_str, 1) != 0) {
+        abort_handoff();
+        return -1;
+    }
+
+    /* Absolute argv[0] picks up an upgraded binary, otherwise reuse our image */
+    const char *path = (argv[0][0] == '/') ? argv[0] : "/proc/self/exe";
+    logging_info("Re-executing %s with state handoff", path);
+
+    execv(path, argv);
+
+    logging_error("Re-exec of %s failed: %s", path, strerror(errno));
+    abort_handoff();
+    return -1;
+}
+
+/* ============================================================================
+ * READER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Take over state passed by a previous image
+ *
+ * @return true if handoff state is available
+ */
+bool handoff_receive(void)
+{
+    const char *env = getenv(HANDOFF_ENV);
+    struct stat st;
+
+    if (!env) {
+        return false;
+    }
+
+    char *end;
+    long fd = strtol(env, &end, 10);
+    unsetenv(HANDOFF_ENV);
+    if (*end != '\0' || fd < 0 || fd > INT32_MAX) {
+        logging_warning("Ignoring invalid %s value", HANDOFF_ENV);
+        return false;
+    }
+
+    if (fstat((int)fd, &st) != 0 || st.st_size < (off_t)sizeof(handoff_header_t) ||
+        st.st_size > HANDOFF_MAX_SIZE) {
+        logging_warning("Handoff state unavailable, starting fresh");
+        close((int)fd);
+        return false;
+    }
+
+    g_handoff_size = (size_t)st.st_size;
+    g_handoff_blob = malloc(g_handoff_size);
+    ssize_t n = g_handoff_blob ? pread((int)fd, g_handoff_blob, g_handoff_size, 0) : -1;
+    close((int)fd);
+
+    const handoff_header_t *hdr = (const handoff_header_t *)g_handoff_blob;
+    if (n != (ssize_t)g_handoff_size || hdr->magic != HANDOFF_MAGIC ||
+        hdr->version != HANDOFF_VERSION) {
+        logging_warning("Handoff state invalid, starting fresh");
+        handoff_release();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Copy a received state record
+ *
+ * @param type Record type
+ * @param data Destination buffer
+ * @param len Expected payload length (must match exactly)
+ * @return 0 on success, -1 if the record is missing or has another size
+ */
+int handoff_get(uint16_t type, void *data, uint32_t len)
+{
+    size_t off = sizeof(handoff_header_t);
+
+    if (!g_handoff_blob || !data) {
+        return -1;
+    }
+
+    while (off + sizeof(handoff_record_t) <= g_handoff_size) {
+        handoff_record_t rec;
+        memcpy(&rec, g_handoff_blob + off, sizeof(rec));
+        off += sizeof(rec);
+
+        if (rec.len > g_handoff_size - off) {
+            break;  /* Truncated record */
+        }
+        if (rec.type == type) {
+            if (rec.len != len) {
+                logging_warning("Handoff record %u has size %u, expected %u; ignored",
+                               type, rec.len, len);
+                return -1;
+            }
+            memcpy(data, g_handoff_blob + off, len);
+            return 0;
+        }
+        off += rec.len;
+    }
+
+    return -1;
+}
+
+/**
+ * Release received state
+ */
+void handoff_release(void)
+{
+    free(g_handoff_blob);
+    g_handoff_blob = NULL;
+    g_handoff_size = 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file headroom.c
+ * @brief Thermal headroom score for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file computes the thermal headroom score. A rising trend is
+ * projected over the configured horizon, and the score falls linearly from
+ * 100 at (temp_max - headroom_span) to 0 at temp_max. A falling trend does
+ * not raise the score, so a modem that is still hot is not reported as
+ * cool while it recovers.
+ *
+ * The published score only follows the computed one once it moved by at
+ * least the hysteresis (or reached 0 or 100), so policies acting on it do
+ * not flap on sensor noise.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/state.h"
+#include "include/headroom.h"
+
+/* ============================================================================
+ * STATE
+ * ============================================================================ */
+
+static int g_temp_max = DEFAULT_TEMP_MAX;
+static int g_temp_crit = DEFAULT_TEMP_CRIT;
+static int g_span = 1;
+static int g_horizon = 0;
+static int g_hysteresis = 0;
+
+static headroom_t g_headroom = { .score = -1 };
+
+/* Trend estimator */
+static bool g_have_prev = false;
+static int g_prev_mdeg = 0;
+static time_t g_prev_time = 0;
+static double g_rate = 0.0;       /* m°C per minute */
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * threshold_mdeg - Convert a configured threshold in °C
+ * @str: Threshold as configured ("" = unset)
+ * @fallback: Value in m°C if unset or invalid
+ *
+ * Return: Threshold in m°C
+ */
+static int threshold_mdeg(const char *str, int fallback)
+{
+    char *endptr;
+
+    if (!str[0]) {
+        return fallback;
+    }
+
+    errno = 0;
+    double value = strtod(str, &endptr);
+    if (errno != 0 || endptr == str || *endptr != '\0') {
+        return fallback;
+    }
+    return (int)(value * 1000.0);
+}
+
+/**
+ * level_for - Level of a published score
+ * @score: Published score
+ * @temp_mdeg: Current temperature
+ */
+static int level_for(int score, int temp_mdeg)
+{
+    if (temp_mdeg >= g_temp_crit ||
+        (g_headroom.level == HEADROOM_LEVEL_CRITICAL && temp_mdeg > g_temp_crit - HEADROOM_CRIT_CLEAR)) {
+        return HEADROOM_LEVEL_CRITICAL;
+    }
+    if (score == 0) {
+        return HEADROOM_LEVEL_HOT;
+    }
+    return score < HEADROOM_WARM_SCORE ? HEADROOM_LEVEL_WARM : HEADROOM_LEVEL_OK;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * headroom_configure - Apply thresholds and headroom options
+ * @cfg: Configuration
+ */
+void headroom_configure(const config_t *cfg)
+{
+    g_temp_max = threshold_mdeg(cfg->temp_max, DEFAULT_TEMP_MAX);
+    g_temp_crit = threshold_mdeg(cfg->temp_crit, DEFAULT_TEMP_CRIT);
+    g_span = cfg->headroom_span;
+    g_horizon = cfg->headroom_horizon;
+    g_hysteresis = cfg->headroom_hysteresis;
+
+    logging_debug("Headroom: temp_max=%d m°C, temp_crit=%d m°C, span=%d m°C, horizon=%d s, hysteresis=%d",
+                  g_temp_max, g_temp_crit, g_span, g_horizon, g_hysteresis);
+}
+
+/**
+ * headroom_update - Update the score with a published temperature
+ * @temp_mdeg: Temperature in m°C
+ * @estimated: true for a board-sensor estimate
+ */
+void headroom_update(int temp_mdeg, bool estimated)
+{
+    time_t now = sys_time();
+
+    // Smoothed trend, same estimator as the rate rules
+    if (g_have_prev && now > g_prev_time) {
+        double dt = (double)(now - g_prev_time);
+        double slope = (temp_mdeg - g_prev_mdeg) * 60.0 / dt;
+        g_rate += dt / (HEADROOM_TREND_WINDOW + dt) * (slope - g_rate);
+    }
+    if (!g_have_prev || now > g_prev_time) {
+        g_prev_mdeg = temp_mdeg;
+        g_prev_time = now;
+        g_have_prev = true;
+    }
+
+    // Only a rising trend is projected ahead
+    double rise = g_rate > 0.0 ? g_rate * g_horizon / 60.0 : 0.0;
+    int projected = temp_mdeg + (int)rise;
+
+    int score = (int)(100LL * (g_temp_max - projected) / g_span);
+    if (score < 0) {
+        score = 0;
+    } else if (score > 100) {
+        score = 100;
+    }
+
+    // Hysteresis: small moves are held back, the ends of the scale are not
+    int published = g_headroom.score;
+    if (published < 0 || abs(score - published) >= g_hysteresis || score == 0 || score == 100) {
+        published = score;
+    }
+
+    int level = level_for(published, temp_mdeg);
+    if (published != g_headroom.score || level != g_headroom.level) {
+        if (g_headroom.score >= 0 && level != g_headroom.level) {
+            logging_info("Thermal headroom %s -> %s (score %d, %d m°C)",
+                         headroom_level_name(g_headroom.level), headroom_level_name(level),
+                         published, temp_mdeg);
+        }
+        g_headroom.score = published;
+        g_headroom.level = level;
+        g_headroom.changed = now;
+    }
+    g_headroom.trend = (int)g_rate;
+    g_headroom.projected_mdeg = projected;
+    g_headroom.temp_mdeg = temp_mdeg;
+    g_headroom.estimated = estimated;
+    g_headroom.updated = now;
+
+    state_set("headroom", "%d", g_headroom.score);
+    state_set("headroom_level", "%s", headroom_level_name(g_headroom.level));
+    state_set("headroom_source", "%s", estimated ? "estimated" : "modem");
+    state_set("headroom_changed", "%lld", (long long)g_headroom.changed);
+    state_set("headroom_temp", "%d", temp_mdeg);
+    state_set("headroom_trend", "%d", g_headroom.trend);
+    state_set("headroom_updated", "%lld", (long long)now);
+}
+
+/**
+ * headroom_resume - Continue from the score published by a previous image
+ */
+void headroom_resume(void)
+{
+    char value[STATE_VALUE_LEN];
+
+    if (state_read("headroom", value, sizeof(value)) != 0) {
+        return;
+    }
+    g_headroom.score = atoi(value);
+
+    if (state_read("headroom_level", value, sizeof(value)) == 0) {
+        for (int level = HEADROOM_LEVEL_OK; level <= HEADROOM_LEVEL_CRITICAL; level++) {
+            if (strcmp(value, headroom_level_name(level)) == 0) {
+                g_headroom.level = level;
+            }
+        }
+    }
+    if (state_read("headroom_changed", value, sizeof(value)) == 0) {
+        g_headroom.changed = (time_t)atoll(value);
+    }
+    if (state_read("headroom_temp", value, sizeof(value)) == 0) {
+        g_headroom.temp_mdeg = atoi(value);
+    }
+    if (state_read("headroom_trend", value, sizeof(value)) == 0) {
+        g_headroom.trend = atoi(value);
+    }
+    if (state_read("headroom_source", value, sizeof(value)) == 0) {
+        g_headroom.estimated = strcmp(value, "estimated") == 0;
+    }
+    if (state_read("headroom_updated", value, sizeof(value)) == 0) {
+        g_headroom.updated = (time_t)atoll(value);
+    }
+}
+
+/**
+ * headroom_get - Current published headroom
+ */
+const headroom_t *headroom_get(void)
+{
+    return &g_headroom;
+}
+
+/**
+ * headroom_temp_max - Configured temp_max in m°C
+ */
+int headroom_temp_max(void)
+{
+    return g_temp_max;
+}
+
+/**
+ * headroom_level_name - Name of a headroom level
+ * @level: headroom_level_t
+ */
+const char *headroom_level_name(int level)
+{
+    static const char *const names[] = { "ok", "warm", "hot", "critical" };
+
+    if (level < HEADROOM_LEVEL_OK || level > HEADROOM_LEVEL_CRITICAL) {
+        return "unknown";
+    }
+    return names[level];
+}
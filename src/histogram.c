@@ -0,0 +1,593 @@
+/**
+ * @file histogram.c
+ * @brief Time-at-temperature histogram for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file keeps the seconds each AT+QTEMP sensor spent per 1 °C band and
+ * implements the histogram subcommand. The counters are written to a live
+ * copy in /var/run every minute (survives daemon restarts) and to the
+ * persistent histogram_file every histogram_save seconds (survives
+ * reboots, limits flash writes). On start the copy with more accumulated
+ * time wins, and a re-exec hands the counters over directly.
+ *
+ * The sliding window adds the same time to the current slot and to a
+ * running sum of all slots. When a slot expires, it is subtracted from the
+ * sum and reused, so quantiles never need more than one pass over the bands.
+ *
+ * Equivalent hours use the Arrhenius acceleration factor
+ *   AF(T) = exp(Ea / k * (1 / Tref - 1 / T))
+ * per band, computed when the figure is read, so changing the model
+ * parameters re-weights the whole history.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <limits.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/state.h"
+#include "include/histogram.h"
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define HISTOGRAM_MAGIC    0x48524d51u   /* "QMRH" */
+#define HISTOGRAM_VERSION  1
+#define BOLTZMANN_EV       8.617333262e-5
+
+/* On-disk header, followed by histogram_data_t */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sensors;            /* HISTOGRAM_SENSORS of the writer */
+    uint32_t bins;               /* HISTOGRAM_BINS of the writer */
+    int32_t min_c;               /* HISTOGRAM_MIN_C of the writer */
+    uint32_t crc;                /* CRC32 of the payload */
+} histogram_header_t;
+
+static const char *const histogram_sensor_names[HISTOGRAM_SENSORS] = { "modem", "ap", "pa" };
+
+static histogram_data_t g_hist;
+static bool g_loaded = false;
+static char g_file[CONFIG_STRING_LEN] = {0};
+static int g_save_interval = 0;
+static int g_max_gap = 0;        /* Longer gaps between readings are not counted */
+static int g_ea_mev = 0;
+static int g_ref_mdeg = 0;
+
+/* Sliding quantile window and the sum of its slots */
+static histogram_window_t g_window;
+static histogram_data_t g_window_sum;
+static int g_quantile_window = 0;
+
+static time_t g_prev_time = 0;
+static time_t g_live_saved = 0;
+static time_t g_file_saved = 0;
+static bool g_live_dirty = false;
+static bool g_file_dirty = false;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * histogram_bin - Band of a temperature
+ * @temp_mdeg: Temperature in m°C
+ *
+ * Return: Band index, clamped to the first and last band
+ */
+static int histogram_bin(int temp_mdeg)
+{
+    int offset = temp_mdeg - HISTOGRAM_MIN_C * 1000;
+
+    if (offset < 0) {
+        return 0;
+    }
+    int bin = offset / 1000;
+    return bin < HISTOGRAM_BINS ? bin : HISTOGRAM_BINS - 1;
+}
+
+/**
+ * histogram_total - Seconds accumulated over all sensors and bands
+ */
+static uint64_t histogram_total(const histogram_data_t *data)
+{
+    uint64_t total = 0;
+
+    for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+        for (int b = 0; b < HISTOGRAM_BINS; b++) {
+            total += data->seconds[s][b];
+        }
+    }
+    return total;
+}
+
+/**
+ * histogram_load - Read a histogram file
+ * @path: File path
+ * @data: Filled with the counters
+ *
+ * Files written with another layout or failing the checksum are ignored.
+ *
+ * Return: 0 on success, -1 if missing or invalid
+ */
+static int histogram_load(const char *path, histogram_data_t *data)
+{
+    histogram_header_t hdr;
+
+    int fd = sys_open(path, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int ok = read(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+             read(fd, data, sizeof(*data)) == (ssize_t)sizeof(*data);
+    close(fd);
+
+    if (!ok || hdr.magic != HISTOGRAM_MAGIC || hdr.version != HISTOGRAM_VERSION ||
+        hdr.sensors != HISTOGRAM_SENSORS || hdr.bins != HISTOGRAM_BINS || hdr.min_c != HISTOGRAM_MIN_C) {
+        logging_warning("Ignoring histogram file %s with unknown layout", path);
+        return -1;
+    }
+    if (hdr.crc != config_crc32(data, sizeof(*data))) {
+        logging_warning("Ignoring histogram file %s with bad checksum", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * histogram_store - Write counters to a file atomically
+ * @path: File path
+ * @data: Counters
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int histogram_store(const char *path, const histogram_data_t *data)
+{
+    char tmp_path[PATH_MAX_LEN];
+    histogram_header_t hdr = {
+        .magic = HISTOGRAM_MAGIC,
+        .version = HISTOGRAM_VERSION,
+        .sensors = HISTOGRAM_SENSORS,
+        .bins = HISTOGRAM_BINS,
+        .min_c = HISTOGRAM_MIN_C,
+        .crc = config_crc32(data, sizeof(*data))
+    };
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid()) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+
+    int fd = sys_open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        logging_warning("Cannot write histogram file %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    int ok = write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+             write(fd, data, sizeof(*data)) == (ssize_t)sizeof(*data) &&
+             fsync(fd) == 0;
+    close(fd);
+
+    if (!ok || sys_rename(tmp_path, path) != 0) {
+        logging_warning("Failed to update histogram file %s", path);
+        sys_unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * histogram_publish - Publish equivalent hours and window percentiles
+ */
+static void histogram_publish(void)
+{
+    static const int quantiles[] = { 500, 950, 990 };
+    char key[STATE_KEY_LEN];
+
+    for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+        snprintf(key, sizeof(key), "stress_%s", histogram_sensor_names[s]);
+        state_set(key, "%.1f", histogram_stress(&g_hist, s, g_ea_mev, g_ref_mdeg));
+
+        for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+            int celsius;
+            snprintf(key, sizeof(key), "p%d_%s", quantiles[i] / 10, histogram_sensor_names[s]);
+            if (histogram_quantile(&g_window_sum, s, quantiles[i], &celsius) == 0) {
+                state_set(key, "%d", celsius);
+            } else {
+                state_set(key, "%s", "");
+            }
+        }
+    }
+    state_set("quantile_window", "%d", g_quantile_window);
+}
+
+/**
+ * window_reset - Empty the sliding window
+ * @now: Daemon clock
+ */
+static void window_reset(time_t now)
+{
+    memset(&g_window, 0, sizeof(g_window));
+    memset(&g_window_sum, 0, sizeof(g_window_sum));
+    g_window.window = g_quantile_window;
+    g_window.slot_start = (int64_t)now;
+}
+
+/**
+ * window_advance - Expire slots older than the window
+ * @now: Daemon clock
+ *
+ * Each expired slot is subtracted from the sum once, so the cost is
+ * bounded by the number of bands per slot change.
+ */
+static void window_advance(time_t now)
+{
+    int64_t slot_len = g_quantile_window / HISTOGRAM_WINDOW_SLOTS;
+
+    if (g_window.slot_start == 0 || now - g_window.slot_start >= (int64_t)g_quantile_window) {
+        window_reset(now);
+        return;
+    }
+
+    while (now - g_window.slot_start >= slot_len) {
+        g_window.slot = (g_window.slot + 1) % HISTOGRAM_WINDOW_SLOTS;
+        g_window.slot_start += slot_len;
+        for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+            for (int b = 0; b < HISTOGRAM_BINS; b++) {
+                g_window_sum.seconds[s][b] -= g_window.seconds[g_window.slot][s][b];
+            }
+        }
+        memset(g_window.seconds[g_window.slot], 0, sizeof(g_window.seconds[0]));
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * histogram_configure - Apply histogram options
+ * @cfg: Configuration
+ */
+void histogram_configure(const config_t *cfg)
+{
+    snprintf(g_file, sizeof(g_file), "%s", cfg->histogram_file);
+    g_save_interval = cfg->histogram_save;
+    g_max_gap = 2 * (cfg->interval_max > cfg->interval ? cfg->interval_max : cfg->interval);
+    g_ea_mev = cfg->stress_ea;
+    g_ref_mdeg = cfg->stress_ref;
+
+    if (g_quantile_window != cfg->quantile_window) {
+        if (g_quantile_window != 0) {
+            logging_info("Quantile window changed to %d s, percentiles restart", cfg->quantile_window);
+        }
+        g_quantile_window = cfg->quantile_window;
+        window_reset(0);
+    }
+
+    if (g_loaded) {
+        return;
+    }
+    g_loaded = true;
+
+    histogram_data_t live, persistent;
+    bool have_live = histogram_load(HISTOGRAM_LIVE_FILE, &live) == 0;
+    bool have_file = g_file[0] && histogram_load(g_file, &persistent) == 0;
+
+    // The copy with more accumulated time is the newer one
+    if (have_live && (!have_file || histogram_total(&live) >= histogram_total(&persistent))) {
+        g_hist = live;
+    } else if (have_file) {
+        g_hist = persistent;
+    } else {
+        return;
+    }
+    logging_info("Histogram loaded: %llu s of sensor time",
+                 (unsigned long long)histogram_total(&g_hist));
+}
+
+/**
+ * histogram_update - Account the time since the previous reading
+ * @mdeg: Sensor readings in m°C, indexed by histogram_sensor_t
+ * @present: Which sensors the response actually reported
+ */
+void histogram_update(const int mdeg[HISTOGRAM_SENSORS], const bool present[HISTOGRAM_SENSORS])
+{
+    time_t now = sys_time();
+
+    if (g_prev_time != 0 && now > g_prev_time && now - g_prev_time <= g_max_gap) {
+        uint32_t dt = (uint32_t)(now - g_prev_time);
+
+        window_advance(now);
+
+        for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+            if (present[s]) {
+                int bin = histogram_bin(mdeg[s]);
+                uint16_t *slot = &g_window.seconds[g_window.slot][s][bin];
+                uint32_t add = dt < (uint32_t)(UINT16_MAX - *slot) ? dt : (uint32_t)(UINT16_MAX - *slot);
+
+                g_hist.seconds[s][bin] += dt;
+                *slot += (uint16_t)add;
+                g_window_sum.seconds[s][bin] += add;
+            }
+        }
+        g_live_dirty = true;
+        g_file_dirty = true;
+    }
+    g_prev_time = now;
+
+    if (g_live_saved == 0) {
+        g_live_saved = now;
+        g_file_saved = now;
+    }
+
+    if (g_live_dirty && now - g_live_saved >= HISTOGRAM_LIVE_SAVE) {
+        if (histogram_store(HISTOGRAM_LIVE_FILE, &g_hist) == 0) {
+            g_live_dirty = false;
+        }
+        histogram_store(HISTOGRAM_WINDOW_FILE, &g_window_sum);
+        histogram_publish();
+        g_live_saved = now;
+    }
+
+    if (g_file_dirty && g_file[0] && now - g_file_saved >= g_save_interval) {
+        if (histogram_store(g_file, &g_hist) == 0) {
+            g_file_dirty = false;
+            logging_debug("Histogram saved to %s", g_file);
+        }
+        g_file_saved = now;
+    }
+}
+
+/**
+ * histogram_close - Write unsaved counters
+ */
+void histogram_close(void)
+{
+    if (g_live_dirty && histogram_store(HISTOGRAM_LIVE_FILE, &g_hist) == 0) {
+        g_live_dirty = false;
+    }
+    if (g_file_dirty && g_file[0] && histogram_store(g_file, &g_hist) == 0) {
+        g_file_dirty = false;
+    }
+}
+
+/**
+ * histogram_data - Counters for a re-exec handoff
+ */
+const histogram_data_t *histogram_data(void)
+{
+    return &g_hist;
+}
+
+/**
+ * histogram_import - Take over counters from a previous image
+ * @data: Histogram handed over by the previous image
+ */
+void histogram_import(const histogram_data_t *data)
+{
+    g_hist = *data;
+    g_loaded = true;
+    g_live_dirty = true;
+    g_file_dirty = true;
+}
+
+/**
+ * histogram_window - Sliding window for a re-exec handoff
+ */
+const histogram_window_t *histogram_window(void)
+{
+    return &g_window;
+}
+
+/**
+ * histogram_window_import - Take over the sliding window
+ * @window: Window handed over by the previous image
+ */
+void histogram_window_import(const histogram_window_t *window)
+{
+    if (window->window != g_quantile_window || window->slot < 0 ||
+        window->slot >= HISTOGRAM_WINDOW_SLOTS) {
+        return;
+    }
+
+    g_window = *window;
+    memset(&g_window_sum, 0, sizeof(g_window_sum));
+    for (int i = 0; i < HISTOGRAM_WINDOW_SLOTS; i++) {
+        for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+            for (int b = 0; b < HISTOGRAM_BINS; b++) {
+                g_window_sum.seconds[s][b] += g_window.seconds[i][s][b];
+            }
+        }
+    }
+}
+
+/**
+ * histogram_quantile - Time-weighted quantile of one sensor
+ * @data: Histogram
+ * @sensor: histogram_sensor_t
+ * @permille: Quantile in 1/1000
+ * @celsius: Filled with the lower edge of the band in °C
+ *
+ * Return: 0 on success, -1 if the sensor has no samples
+ */
+int histogram_quantile(const histogram_data_t *data, int sensor, int permille, int *celsius)
+{
+    uint64_t total = 0, sum = 0;
+
+    for (int b = 0; b < HISTOGRAM_BINS; b++) {
+        total += data->seconds[sensor][b];
+    }
+    if (total == 0) {
+        return -1;
+    }
+
+    // Smallest band where the cumulative time reaches the quantile
+    uint64_t target = (total * (uint64_t)permille + 999) / 1000;
+    for (int b = 0; b < HISTOGRAM_BINS; b++) {
+        sum += data->seconds[sensor][b];
+        if (sum >= target) {
+            *celsius = HISTOGRAM_MIN_C + b;
+            return 0;
+        }
+    }
+    *celsius = HISTOGRAM_MIN_C + HISTOGRAM_BINS - 1;
+    return 0;
+}
+
+/**
+ * histogram_stress - Arrhenius-weighted time of one sensor
+ * @data: Histogram
+ * @sensor: histogram_sensor_t
+ * @ea_mev: Activation energy in meV
+ * @ref_mdeg: Reference temperature in m°C
+ *
+ * Return: Equivalent hours at the reference temperature
+ */
+double histogram_stress(const histogram_data_t *data, int sensor, int ea_mev, int ref_mdeg)
+{
+    double ea_over_k = ea_mev / 1000.0 / BOLTZMANN_EV;
+    double inv_ref = 1.0 / (ref_mdeg / 1000.0 + 273.15);
+    double seconds = 0.0;
+
+    for (int b = 0; b < HISTOGRAM_BINS; b++) {
+        if (data->seconds[sensor][b] == 0) {
+            continue;
+        }
+        double band_k = HISTOGRAM_MIN_C + b + 0.5 + 273.15;   /* Band centre */
+        seconds += data->seconds[sensor][b] * exp(ea_over_k * (inv_ref - 1.0 / band_k));
+    }
+    return seconds / 3600.0;
+}
+
+/**
+ * histogram_mode - Print the saved time-at-temperature counters
+ * @cfg: Configuration
+ * @window: Print the sliding window and its percentiles
+ * @json: Output as JSON
+ *
+ * Return: 0 on success, 1 if no histogram was found
+ */
+int histogram_mode(const config_t *cfg, bool window, bool json)
+{
+    static const int quantiles[] = { 500, 950, 990 };
+    histogram_data_t data;
+    int first = HISTOGRAM_BINS, last = -1;
+
+    if (window) {
+        if (histogram_load(HISTOGRAM_WINDOW_FILE, &data) != 0) {
+            fprintf(stderr, "Error: No quantile window recorded yet (is the daemon running?)\n");
+            return 1;
+        }
+    } else if (histogram_load(HISTOGRAM_LIVE_FILE, &data) != 0 &&
+               (!cfg->histogram_file[0] || histogram_load(cfg->histogram_file, &data) != 0)) {
+        fprintf(stderr, "Error: No temperature histogram recorded yet\n");
+        return 1;
+    }
+
+    for (int b = 0; b < HISTOGRAM_BINS; b++) {
+        for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+            if (data.seconds[s][b] != 0) {
+                if (b < first) {
+                    first = b;
+                }
+                last = b;
+            }
+        }
+    }
+
+    if (json) {
+        // One compact vector per sensor, seconds per band starting at "first" °C;
+        // vectors of several routers merge by adding them band by band
+        printf("{\"first\": %d, \"band\": 1, ", HISTOGRAM_MIN_C + (last >= 0 ? first : 0));
+        if (window) {
+            printf("\"window\": %d, ", cfg->quantile_window);
+        }
+        printf("\"sensors\": {");
+        for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+            printf("%s\"%s\": [", s ? ", " : "", histogram_sensor_names[s]);
+            for (int b = first; b <= last; b++) {
+                printf("%s%u", b > first ? "," : "", (unsigned)data.seconds[s][b]);
+            }
+            printf("]");
+        }
+        if (window) {
+            printf("}, \"percentiles\": {");
+            for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+                printf("%s\"%s\": {", s ? ", " : "", histogram_sensor_names[s]);
+                for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+                    int celsius;
+                    printf("%s\"p%d\": ", i ? ", " : "", quantiles[i] / 10);
+                    if (histogram_quantile(&data, s, quantiles[i], &celsius) == 0) {
+                        printf("%d", celsius);
+                    } else {
+                        printf("null");
+                    }
+                }
+                printf("}");
+            }
+            printf("}}\n");
+            return 0;
+        }
+        printf("}, \"stress_ea\": %.3f, \"stress_ref\": %.1f, \"stress_hours\": {",
+               cfg->stress_ea / 1000.0, cfg->stress_ref / 1000.0);
+        for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+            printf("%s\"%s\": %.1f", s ? ", " : "", histogram_sensor_names[s],
+                   histogram_stress(&data, s, cfg->stress_ea, cfg->stress_ref));
+        }
+        printf("}}\n");
+        return 0;
+    }
+
+    if (window) {
+        printf("Time at temperature over the last %d s (hours per 1°C band):\n", cfg->quantile_window);
+    } else {
+        printf("Time at temperature (hours per 1°C band):\n");
+    }
+    printf("  %5s %10s %10s %10s\n", "°C", "modem", "ap", "pa");
+    for (int b = first; b <= last; b++) {
+        if (data.seconds[HISTOGRAM_MODEM][b] == 0 && data.seconds[HISTOGRAM_AP][b] == 0 &&
+            data.seconds[HISTOGRAM_PA][b] == 0) {
+            continue;
+        }
+        printf("  %5d %10.2f %10.2f %10.2f\n", HISTOGRAM_MIN_C + b,
+               data.seconds[HISTOGRAM_MODEM][b] / 3600.0, data.seconds[HISTOGRAM_AP][b] / 3600.0,
+               data.seconds[HISTOGRAM_PA][b] / 3600.0);
+    }
+
+    if (window) {
+        printf("\nPercentiles p50/p95/p99 (°C):");
+        for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+            printf("%s %s", s ? "," : "", histogram_sensor_names[s]);
+            for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+                int celsius;
+                if (histogram_quantile(&data, s, quantiles[i], &celsius) == 0) {
+                    printf("%s%d", i ? "/" : " ", celsius);
+                } else {
+                    printf("%s-", i ? "/" : " ");
+                }
+            }
+        }
+        printf("\n");
+        return 0;
+    }
+
+    printf("\nEquivalent hours at %.1f°C (Ea %.2f eV):", cfg->stress_ref / 1000.0, cfg->stress_ea / 1000.0);
+    for (int s = 0; s < HISTOGRAM_SENSORS; s++) {
+        printf("%s %s %.1f", s ? "," : "", histogram_sensor_names[s],
+               histogram_stress(&data, s, cfg->stress_ea, cfg->stress_ref));
+    }
+    printf("\n");
+    return 0;
+}
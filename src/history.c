@@ -0,0 +1,550 @@
+/**
+ * @file history.c
+ * @brief Sample history and compact export for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file keeps the ring of published samples and implements the history
+ * subcommand. The ring lives in a shared memory mapping of HISTORY_FILE:
+ * the daemon is the only writer, readers map the file read-only. A slot's
+ * sequence number is cleared before and set after its fields are written,
+ * so a reader that sees the same sequence number before and after copying
+ * a record has a consistent copy, without locks.
+ *
+ * The export encodes each chunk as the first sample followed by runs of
+ * identical deltas (see history.h), and protects it with a CRC32.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+#include <time.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/history.h"
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define HISTORY_MAGIC    0x48524d51u   /* Same family as the histogram file */
+#define HISTORY_VERSION  1
+#define EPOCH_SHIFT      32            /* Sequence numbers are epoch << 32 | count */
+#define EPOCH_MASK       0xffffffu     /* 24 bits keep cursors below 2^56 */
+
+/* Ring file header, followed by capacity records */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;        /* sizeof(history_record_t) of the writer */
+    uint32_t capacity;
+    uint32_t epoch;              /* Random id of this ring, upper bits of every seq */
+    uint64_t next_seq;           /* Sequence number of the next record */
+} history_header_t;
+
+/* Worst case: every sample starts a run of 8 varints */
+#define CHUNK_MAX_BYTES  (16 + 12 * 10 + HISTORY_CHUNK_SAMPLES * (7 * 10 + 1))
+
+static history_header_t *g_header = NULL;
+static history_record_t *g_records = NULL;
+static size_t g_map_size = 0;
+static uint32_t g_capacity = 0;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * map_size - Bytes of a ring file with @capacity records
+ */
+static size_t map_size(uint32_t capacity)
+{
+    return sizeof(history_header_t) + (size_t)capacity * sizeof(history_record_t);
+}
+
+/**
+ * header_valid - Check that a mapped ring was written by this layout
+ */
+static bool header_valid(const history_header_t *h, size_t file_size)
+{
+    return h->magic == HISTORY_MAGIC && h->version == HISTORY_VERSION &&
+           h->record_size == sizeof(history_record_t) && h->capacity > 0 &&
+           file_size == map_size(h->capacity);
+}
+
+/**
+ * first_seq - Sequence number of the first record of a ring
+ */
+static uint64_t first_seq(uint32_t epoch)
+{
+    return ((uint64_t)epoch << EPOCH_SHIFT) + 1;
+}
+
+/**
+ * new_epoch - Pick the epoch of a new ring
+ *
+ * The ring in /var/run is lost on reboot. A random epoch in the upper
+ * bits of the sequence numbers keeps a cursor from an earlier ring from
+ * ever matching a sample of the new one.
+ */
+static uint32_t new_epoch(void)
+{
+    uint32_t epoch;
+
+    if (getrandom(&epoch, sizeof(epoch), GRND_NONBLOCK) != (ssize_t)sizeof(epoch)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        epoch = (uint32_t)time(NULL) ^ (uint32_t)ts.tv_nsec ^ ((uint32_t)getpid() << 16);
+    }
+    epoch &= EPOCH_MASK;
+    return epoch ? epoch : 1;
+}
+
+/**
+ * create_ring - Build an empty ring beside HISTORY_FILE and rename it over it
+ * @hdr: Header of the new ring
+ *
+ * Readers may have the old file mapped; shrinking it in place would fault
+ * them with SIGBUS. They keep the old inode instead and see the new ring
+ * on their next open, which never has a half-written header.
+ *
+ * Return: Descriptor of the new ring, or -1 on error
+ */
+static int create_ring(const history_header_t *hdr)
+{
+    char tmp_path[PATH_MAX_LEN];
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%d", HISTORY_FILE, (int)getpid()) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+
+    int fd = sys_open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (ftruncate(fd, (off_t)map_size(hdr->capacity)) != 0 ||
+        pwrite(fd, hdr, sizeof(*hdr), 0) != (ssize_t)sizeof(*hdr) ||
+        sys_rename(tmp_path, HISTORY_FILE) != 0) {
+        int saved = errno;
+        close(fd);
+        sys_unlink(tmp_path);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * clamp_sensor - Store a sensor reading in the record's byte
+ */
+static int8_t clamp_sensor(int celsius)
+{
+    if (celsius > INT8_MAX) {
+        return INT8_MAX;
+    }
+    return (int8_t)(celsius < INT8_MIN ? INT8_MIN : celsius);
+}
+
+/**
+ * read_record - Copy a record if it is complete and still holds @seq
+ *
+ * Return: true on success, false if the slot was overwritten meanwhile
+ */
+static bool read_record(const history_record_t *slot, uint64_t seq, history_record_t *out)
+{
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq) {
+        return false;
+    }
+    memcpy(out, slot, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq && out->seq == seq;
+}
+
+/**
+ * put_varint - Append an unsigned LEB128 varint
+ *
+ * Return: Number of bytes written (at most 10)
+ */
+static size_t put_varint(uint8_t *p, uint64_t v)
+{
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/**
+ * put_signed - Append a zigzag-encoded signed varint
+ */
+static size_t put_signed(uint8_t *p, int64_t v)
+{
+    return put_varint(p, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+/**
+ * put_u32 - Append a little-endian uint32
+ */
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * same_delta - Check whether two consecutive steps have identical deltas
+ */
+static bool same_delta(const history_record_t *a0, const history_record_t *a1,
+                       const history_record_t *b0, const history_record_t *b1)
+{
+    if (a1->seq - a0->seq != b1->seq - b0->seq ||
+        a1->timestamp - a0->timestamp != b1->timestamp - b0->timestamp ||
+        a1->temp_mdeg - a0->temp_mdeg != b1->temp_mdeg - b0->temp_mdeg ||
+        a1->flags != b1->flags) {
+        return false;
+    }
+    for (int s = 0; s < 3; s++) {
+        if (a1->sensors[s] - a0->sensors[s] != b1->sensors[s] - b0->sensors[s]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * write_chunk - Encode and write one export chunk
+ * @out: Output stream
+ * @r: Samples in sequence order
+ * @count: Number of samples (1 to HISTORY_CHUNK_SAMPLES)
+ *
+ * Return: Bytes written, 0 on error
+ */
+static size_t write_chunk(FILE *out, const history_record_t *r, int count)
+{
+    static uint8_t buf[CHUNK_MAX_BYTES];
+    uint8_t *payload = buf + 8;
+    size_t n = 0;
+    int64_t sum = 0;
+    int32_t min = r[0].temp_mdeg, max = r[0].temp_mdeg;
+    unsigned int estimated = 0;
+
+    for (int i = 0; i < count; i++) {
+        sum += r[i].temp_mdeg;
+        min = r[i].temp_mdeg < min ? r[i].temp_mdeg : min;
+        max = r[i].temp_mdeg > max ? r[i].temp_mdeg : max;
+        estimated += (r[i].flags & HISTORY_FLAG_ESTIMATED) ? 1 : 0;
+    }
+
+    /* First sample and aggregates */
+    n += put_varint(payload + n, (uint64_t)count);
+    n += put_varint(payload + n, r[0].seq);
+    n += put_signed(payload + n, r[0].timestamp);
+    n += put_signed(payload + n, r[0].temp_mdeg);
+    for (int s = 0; s < 3; s++) {
+        n += put_signed(payload + n, r[0].sensors[s]);
+    }
+    payload[n++] = r[0].flags;
+    n += put_signed(payload + n, min);
+    n += put_signed(payload + n, max);
+    n += put_signed(payload + n, sum / count);
+    n += put_varint(payload + n, estimated);
+
+    /* Runs of identical deltas */
+    for (int i = 1; i < count; ) {
+        int run = 1;
+        while (i + run < count && same_delta(&r[i - 1], &r[i], &r[i + run - 1], &r[i + run])) {
+            run++;
+        }
+
+        n += put_varint(payload + n, (uint64_t)run);
+        n += put_varint(payload + n, r[i].seq - r[i - 1].seq);
+        n += put_signed(payload + n, r[i].timestamp - r[i - 1].timestamp);
+        n += put_signed(payload + n, (int64_t)r[i].temp_mdeg - r[i - 1].temp_mdeg);
+        for (int s = 0; s < 3; s++) {
+            n += put_signed(payload + n, r[i].sensors[s] - r[i - 1].sensors[s]);
+        }
+        payload[n++] = r[i].flags;
+        i += run;
+    }
+
+    memcpy(buf, "QRH", 3);
+    buf[3] = HISTORY_EXPORT_VERSION;
+    put_u32(buf + 4, (uint32_t)n);
+    put_u32(payload + n, config_crc32(payload, n));
+
+    size_t total = 8 + n + 4;
+    return fwrite(buf, 1, total, out) == total ? total : 0;
+}
+
+/**
+ * print_record - Print one sample as text or JSON
+ */
+static void print_record(const history_record_t *r, bool json, bool first)
+{
+    if (json) {
+        printf("%s    {\"seq\": %llu, \"timestamp\": %lld, \"temperature\": %d, \"source\": \"%s\", "
+               "\"modem\": %d, \"ap\": %d, \"pa\": %d}",
+               first ? "" : ",\n", (unsigned long long)r->seq, (long long)r->timestamp, r->temp_mdeg,
+               (r->flags & HISTORY_FLAG_ESTIMATED) ? "estimated" : "modem",
+               r->sensors[0], r->sensors[1], r->sensors[2]);
+    } else {
+        printf("%8llu  %10lld  %7d  %-9s  %5d  %5d  %5d\n",
+               (unsigned long long)r->seq, (long long)r->timestamp, r->temp_mdeg,
+               (r->flags & HISTORY_FLAG_ESTIMATED) ? "estimated" : "modem",
+               r->sensors[0], r->sensors[1], r->sensors[2]);
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * history_configure - Apply the history options, opening or resizing the ring
+ * @cfg: Configuration
+ */
+void history_configure(const config_t *cfg)
+{
+    uint32_t capacity = (uint32_t)cfg->history_size;
+    struct stat st;
+
+    if (g_header && capacity == g_capacity) {
+        return;
+    }
+    history_close();
+
+    if (capacity == 0) {
+        sys_unlink(HISTORY_FILE);
+        return;
+    }
+
+    size_t size = map_size(capacity);
+    history_header_t old;
+    int fd = sys_open(HISTORY_FILE, O_RDWR | O_CLOEXEC, 0);
+    bool valid = fd >= 0 && fstat(fd, &st) == 0 &&
+                 pread(fd, &old, sizeof(old), 0) == (ssize_t)sizeof(old) &&
+                 header_valid(&old, (size_t)st.st_size);
+    bool reuse = valid && old.capacity == capacity;
+
+    /* A new or resized ring starts empty, in a fresh file */
+    if (!reuse) {
+        history_header_t hdr = {
+            .magic = HISTORY_MAGIC,
+            .version = HISTORY_VERSION,
+            .record_size = sizeof(history_record_t),
+            .capacity = capacity
+        };
+        if (valid) {
+            /* Resized: the samples are gone, but cursors stay valid */
+            hdr.epoch = old.epoch;
+            hdr.next_seq = old.next_seq;
+        } else {
+            hdr.epoch = new_epoch();
+            hdr.next_seq = first_seq(hdr.epoch);
+        }
+
+        if (fd >= 0) {
+            close(fd);
+        }
+        fd = create_ring(&hdr);
+        if (fd < 0) {
+            logging_warning("Cannot create history file: %s", strerror(errno));
+            return;
+        }
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        logging_warning("Cannot map history file: %s", strerror(errno));
+        return;
+    }
+
+    g_header = map;
+    g_records = (history_record_t *)(g_header + 1);
+    g_map_size = size;
+    g_capacity = capacity;
+
+    if (reuse) {
+        logging_debug("History: continuing at sample %llu (%u slots)",
+                      (unsigned long long)g_header->next_seq, capacity);
+    } else if (valid) {
+        logging_debug("History: resized to %u slots, continuing at sample %llu",
+                      capacity, (unsigned long long)g_header->next_seq);
+    } else {
+        logging_debug("History: new ring with %u slots (epoch %u)", capacity, g_header->epoch);
+    }
+}
+
+/**
+ * history_record - Append a published sample
+ * @temp_mdeg: Published temperature in m°C
+ * @modem_c: Modem sensor in °C
+ * @ap_c: AP sensor in °C
+ * @pa_c: PA sensor in °C
+ * @estimated: true for a board-sensor estimate
+ */
+void history_record(int temp_mdeg, int modem_c, int ap_c, int pa_c, bool estimated)
+{
+    if (!g_header) {
+        return;
+    }
+
+    uint64_t seq = g_header->next_seq;
+    history_record_t *slot = &g_records[(seq - 1) % g_capacity];
+
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->timestamp = (int64_t)sys_time();
+    slot->temp_mdeg = temp_mdeg;
+    slot->sensors[0] = clamp_sensor(modem_c);
+    slot->sensors[1] = clamp_sensor(ap_c);
+    slot->sensors[2] = clamp_sensor(pa_c);
+    slot->flags = estimated ? HISTORY_FLAG_ESTIMATED : 0;
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&g_header->next_seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * history_close - Unmap the ring
+ */
+void history_close(void)
+{
+    if (g_header) {
+        munmap(g_header, g_map_size);
+    }
+    g_header = NULL;
+    g_records = NULL;
+    g_map_size = 0;
+    g_capacity = 0;
+}
+
+/**
+ * history_mode - Print or export the samples since a cursor
+ * @since: First sequence number to include (0 = oldest available)
+ * @export: Write binary chunks instead of text/JSON
+ * @json: Output as JSON
+ *
+ * Return: 0 on success, 1 if no history is available
+ */
+int history_mode(uint64_t since, bool export, bool json)
+{
+    static history_record_t chunk[HISTORY_CHUNK_SAMPLES];
+    struct stat st;
+    int fd = sys_open(HISTORY_FILE, O_RDONLY | O_CLOEXEC, 0);
+
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(history_header_t)) {
+        fprintf(stderr, "Error: No sample history found (is the daemon running with history_size > 0?)\n");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED || !header_valid(map, (size_t)st.st_size)) {
+        fprintf(stderr, "Error: Sample history file is invalid\n");
+        if (map != MAP_FAILED) {
+            munmap(map, (size_t)st.st_size);
+        }
+        return 1;
+    }
+
+    if (export && isatty(STDOUT_FILENO)) {
+        fprintf(stderr, "Error: Refusing to write binary export to a terminal, redirect it to a file\n");
+        munmap(map, (size_t)st.st_size);
+        return 2;
+    }
+
+    const history_header_t *header = map;
+    const history_record_t *records = (const history_record_t *)(header + 1);
+    uint64_t next = __atomic_load_n(&header->next_seq, __ATOMIC_ACQUIRE);
+    uint64_t base = first_seq(header->epoch);
+    uint64_t oldest = next - base > header->capacity ? next - header->capacity : base;
+    uint64_t seq = since > oldest ? since : oldest;
+
+    if (since > 0 && (since >> EPOCH_SHIFT) != header->epoch) {
+        // The ring was recreated (reboot, invalid file) since the cursor was taken
+        logging_warning("Cursor %llu is from an earlier history, exporting from %llu",
+                        (unsigned long long)since, (unsigned long long)oldest);
+        seq = oldest;
+    } else if (since > next) {
+        logging_warning("Cursor %llu is ahead of the history (next %llu), exporting from %llu",
+                        (unsigned long long)since, (unsigned long long)next, (unsigned long long)oldest);
+        seq = oldest;
+    } else if (since > 0 && since < oldest) {
+        logging_warning("%llu samples before the cursor were overwritten, exporting from %llu",
+                        (unsigned long long)(oldest - since), (unsigned long long)oldest);
+    }
+
+    if (json && !export) {
+        printf("{\n  \"samples\": [\n");
+    } else if (!export) {
+        printf("%8s  %10s  %7s  %-9s  %5s  %5s  %5s\n", "seq", "timestamp", "m°C", "source",
+               "modem", "ap", "pa");
+    }
+
+    size_t bytes = 0;
+    unsigned long samples = 0;
+    bool first = true;
+    int ok = 1;
+
+    while (seq < next && ok) {
+        int count = 0;
+
+        /* Collect a chunk; slots overwritten while reading are skipped */
+        while (seq < next && count < HISTORY_CHUNK_SAMPLES) {
+            if (read_record(&records[(seq - 1) % header->capacity], seq, &chunk[count])) {
+                count++;
+            }
+            seq++;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        if (export) {
+            size_t written = write_chunk(stdout, chunk, count);
+            ok = written > 0;
+            bytes += written;
+        } else {
+            for (int i = 0; i < count; i++) {
+                print_record(&chunk[i], json, first);
+                first = false;
+            }
+        }
+        samples += (unsigned long)count;
+    }
+
+    if (json && !export) {
+        printf("%s  ],\n  \"cursor\": %llu\n}\n", first ? "" : "\n", (unsigned long long)seq);
+    }
+    fflush(stdout);
+    munmap(map, (size_t)st.st_size);
+
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to write export: %s\n", strerror(errno));
+        return 1;
+    }
+
+    if (export) {
+        logging_debug("Exported %lu samples in %zu bytes", samples, bytes);
+    }
+    fprintf(stderr, "cursor=%llu\n", (unsigned long long)seq);
+    return 0;
+}
@@ -0,0 +1,823 @@
+/**
+ * @file http.c
+ * @brief Local HTTP endpoint for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements a minimal HTTP/1.1 server inside the daemon, bound
+ * to a Unix socket or a loopback address and meant to be reached through a
+ * local reverse proxy. It serves three endpoints:
+ *
+ *   GET /events   Server-Sent Events stream, one "sample" event per new
+ *                 sample, with the sequence number as event id
+ *   GET /sample   Latest sample as JSON. With ?since=SEQ or
+ *                 If-None-Match the request is held until a sample other
+ *                 than SEQ is published (long-poll), or answered with 304
+ *                 after ?timeout=S seconds
+ *   GET /headroom Thermal headroom score as JSON
+ *   GET /admission
+ *                 Admission decision for a heavy modem operation of
+ *                 ?duration=S seconds (admit, defer with Retry-After, deny)
+ *
+ * The server is single-threaded and driven from the daemon's sampling
+ * sleep: http_wait_until() polls the sockets until the next deadline, so
+ * idle dashboards cost no wakeups beyond the sampling period.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/http.h"
+#include "include/headroom.h"
+#include "include/admission.h"
+#include "include/recovery.h"
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define HTTP_SAMPLE_JSON_LEN 128
+
+typedef enum {
+    HTTP_CLIENT_FREE = 0,
+    HTTP_CLIENT_READING,         /* Receiving request line and headers */
+    HTTP_CLIENT_WAITING,         /* Long-poll held until a new sample */
+    HTTP_CLIENT_STREAM,          /* Event stream */
+    HTTP_CLIENT_CLOSING,         /* Flushing the final response */
+} http_client_state_t;
+
+typedef struct {
+    int fd;
+    http_client_state_t state;
+    uint64_t since;              /* Sequence number the client already has */
+    struct timespec deadline;    /* Request timeout, long-poll end or keepalive */
+    size_t in_len;
+    size_t out_len;
+    char in[HTTP_REQUEST_MAX];
+    char out[HTTP_OUTPUT_MAX];
+} http_client_t;
+
+static int g_listen_fd = -1;
+static char g_unix_path[PATH_MAX_LEN] = {0};   /* Resolved socket path to unlink */
+static http_client_t g_clients[HTTP_MAX_CLIENTS];
+static int g_client_count = 0;
+static http_sample_t g_sample = {0};
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * deadline_in - Monotonic timestamp @seconds from now
+ */
+static struct timespec deadline_in(int seconds)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += seconds;
+    return ts;
+}
+
+/**
+ * diff_ms - Milliseconds from @a to @b (negative if @b is earlier)
+ */
+static long diff_ms(const struct timespec *a, const struct timespec *b)
+{
+    return (long)(b->tv_sec - a->tv_sec) * 1000L + (b->tv_nsec - a->tv_nsec) / 1000000L;
+}
+
+/**
+ * format_sample - Format the latest sample as a JSON object
+ */
+static int format_sample(char *buf, size_t size)
+{
+    return snprintf(buf, size,
+                    "{\"seq\": %llu, \"temperature\": %d, \"source\": \"%s\", \"timestamp\": %lld}",
+                    (unsigned long long)g_sample.seq, g_sample.temp_mdeg,
+                    g_sample.estimated ? "estimated" : "modem", (long long)g_sample.timestamp);
+}
+
+/**
+ * format_headroom - Format the published headroom as a JSON object
+ */
+static int format_headroom(char *buf, size_t size)
+{
+    const headroom_t *h = headroom_get();
+
+    return snprintf(buf, size,
+                    "{\"headroom\": %d, \"level\": \"%s\", \"trend\": %d, \"projected\": %d, "
+                    "\"source\": \"%s\", \"changed\": %lld}\n",
+                    h->score, h->score < 0 ? "unknown" : headroom_level_name(h->level), h->trend,
+                    h->projected_mdeg, h->estimated ? "estimated" : "modem", (long long)h->changed);
+}
+
+/* ============================================================================
+ * CLIENT FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * client_close - Disconnect a client and free its slot
+ */
+static void client_close(http_client_t *c)
+{
+    if (c->state == HTTP_CLIENT_FREE) {
+        return;
+    }
+    close(c->fd);
+    c->fd = -1;
+    c->state = HTTP_CLIENT_FREE;
+    g_client_count--;
+}
+
+/**
+ * client_printf - Queue formatted output for a client
+ *
+ * Return: 0 on success, -1 if the output buffer is full (client is closed)
+ */
+static int client_printf(http_client_t *c, const char *fmt, ...)
+{
+    size_t avail = sizeof(c->out) - c->out_len;
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(c->out + c->out_len, avail, fmt, ap);
+    va_end(ap);
+
+    if (n < 0 || (size_t)n >= avail) {
+        logging_debug("HTTP client too slow, disconnecting");
+        client_close(c);
+        return -1;
+    }
+    c->out_len += (size_t)n;
+    return 0;
+}
+
+/**
+ * client_flush - Send queued output without blocking
+ */
+static void client_flush(http_client_t *c)
+{
+    while (c->state != HTTP_CLIENT_FREE && c->out_len > 0) {
+        ssize_t n = send(c->fd, c->out, c->out_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                client_close(c);
+            }
+            return;
+        }
+        memmove(c->out, c->out + n, c->out_len - (size_t)n);
+        c->out_len -= (size_t)n;
+    }
+
+    if (c->state == HTTP_CLIENT_CLOSING && c->out_len == 0) {
+        client_close(c);
+    }
+}
+
+/**
+ * client_finish - Queue a complete response and close after sending it
+ */
+static void client_finish(http_client_t *c, const char *status, const char *headers, const char *body)
+{
+    if (client_printf(c, "HTTP/1.1 %s\r\n%sContent-Length: %zu\r\nConnection: close\r\n\r\n%s",
+                      status, headers, strlen(body), body) == 0) {
+        c->state = HTTP_CLIENT_CLOSING;
+        c->deadline = deadline_in(HTTP_REQUEST_TIMEOUT);
+    }
+}
+
+/**
+ * client_send_sample - Answer a /sample request with the latest sample
+ * @c: Client
+ * @modified: false to answer 304 Not Modified
+ */
+static void client_send_sample(http_client_t *c, bool modified)
+{
+    char headers[SMALL_BUFFER_LEN * 4];
+    char body[HTTP_SAMPLE_JSON_LEN + 2];
+
+    snprintf(headers, sizeof(headers),
+             "Content-Type: application/json\r\nCache-Control: no-cache\r\nETag: \"%llu\"\r\n",
+             (unsigned long long)g_sample.seq);
+
+    if (!modified) {
+        client_finish(c, "304 Not Modified", headers, "");
+        return;
+    }
+
+    format_sample(body, sizeof(body) - 1);
+    strcat(body, "\n");
+    client_finish(c, "200 OK", headers, body);
+}
+
+/**
+ * client_send_event - Queue the latest sample as a Server-Sent Event
+ */
+static void client_send_event(http_client_t *c)
+{
+    char data[HTTP_SAMPLE_JSON_LEN];
+
+    format_sample(data, sizeof(data));
+    if (client_printf(c, "id: %llu\nevent: sample\ndata: %s\n\n",
+                      (unsigned long long)g_sample.seq, data) == 0) {
+        c->since = g_sample.seq;
+        c->deadline = deadline_in(HTTP_SSE_KEEPALIVE);
+    }
+}
+
+/* ============================================================================
+ * REQUEST HANDLING
+ * ============================================================================ */
+
+/**
+ * parse_seq - Parse a sequence number, optionally quoted as an ETag
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int parse_seq(const char *str, uint64_t *seq)
+{
+    char *endptr;
+
+    str += strspn(str, " \t");
+    if (strncmp(str, "W/", 2) == 0) {
+        str += 2;
+    }
+    if (*str == '"') {
+        str++;
+    }
+
+    errno = 0;
+    unsigned long long value = strtoull(str, &endptr, 10);
+    if (errno != 0 || endptr == str || (*endptr != '\0' && *endptr != '"' &&
+                                        *endptr != '&' && *endptr != '\r' && *endptr != ' ')) {
+        return -1;
+    }
+    *seq = value;
+    return 0;
+}
+
+/**
+ * find_header - Find a header value in a request
+ * @headers: Header block, lines separated by CRLF
+ * @name: Header name including the colon
+ *
+ * Return: Pointer to the value (up to CRLF), NULL if missing
+ */
+static const char *find_header(const char *headers, const char *name)
+{
+    size_t len = strlen(name);
+
+    for (const char *line = headers; line && *line; ) {
+        if (strncasecmp(line, name, len) == 0) {
+            return line + len;
+        }
+        line = strchr(line, '\n');
+        if (line) {
+            line++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * handle_request - Dispatch a complete request
+ */
+static void handle_request(http_client_t *c)
+{
+    char method[8], target[SMALL_BUFFER_LEN * 4];
+
+    if (sscanf(c->in, "%7s %127s HTTP/1.%*d", method, target) != 2) {
+        client_finish(c, "400 Bad Request", "", "");
+        return;
+    }
+
+    const char *headers = strchr(c->in, '\n');
+    headers = headers ? headers + 1 : "";
+
+    if (strcmp(method, "GET") != 0) {
+        client_finish(c, "405 Method Not Allowed", "Allow: GET\r\n", "");
+        return;
+    }
+
+    char *query = strchr(target, '?');
+    if (query) {
+        *query++ = '\0';
+    }
+
+    if (strcmp(target, "/events") == 0) {
+        const char *last_id = find_header(headers, "Last-Event-ID:");
+        uint64_t since = 0;
+        if (last_id) {
+            parse_seq(last_id, &since);
+        }
+
+        if (client_printf(c, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                             "Cache-Control: no-cache\r\nX-Accel-Buffering: no\r\n\r\n"
+                             "retry: %d\n\n", HTTP_SSE_RETRY_MS) != 0) {
+            return;
+        }
+        c->state = HTTP_CLIENT_STREAM;
+        c->since = since;
+        c->deadline = deadline_in(HTTP_SSE_KEEPALIVE);
+        if (g_sample.seq != 0 && g_sample.seq != since) {
+            client_send_event(c);
+        }
+        logging_debug("HTTP event stream opened (%d clients)", g_client_count);
+        return;
+    }
+
+    if (strcmp(target, "/sample") == 0) {
+        uint64_t since = 0;
+        int timeout = HTTP_POLL_TIMEOUT;
+
+        const char *etag = find_header(headers, "If-None-Match:");
+        if (etag && parse_seq(etag, &since) != 0) {
+            since = 0;
+        }
+
+        for (char *param = query; param && *param; ) {
+            char *next = strchr(param, '&');
+            if (next) {
+                *next++ = '\0';
+            }
+            if (strncmp(param, "since=", 6) == 0 && parse_seq(param + 6, &since) != 0) {
+                client_finish(c, "400 Bad Request", "", "");
+                return;
+            } else if (strncmp(param, "timeout=", 8) == 0) {
+                timeout = atoi(param + 8);
+                if (timeout < 0 || timeout > HTTP_POLL_TIMEOUT_MAX) {
+                    client_finish(c, "400 Bad Request", "", "");
+                    return;
+                }
+            }
+            param = next;
+        }
+
+        /* Any sample other than the client's counts as new (sequence restarts with the daemon) */
+        if (g_sample.seq != 0 && g_sample.seq != since) {
+            client_send_sample(c, true);
+        } else if (timeout == 0) {
+            client_send_sample(c, false);
+        } else {
+            c->state = HTTP_CLIENT_WAITING;
+            c->since = since;
+            c->deadline = deadline_in(timeout);
+        }
+        return;
+    }
+
+    if (strcmp(target, "/headroom") == 0) {
+        char body[HTTP_SAMPLE_JSON_LEN * 2];
+        format_headroom(body, sizeof(body));
+        client_finish(c, "200 OK", "Content-Type: application/json\r\nCache-Control: no-cache\r\n", body);
+        return;
+    }
+
+    if (strcmp(target, "/admission") == 0) {
+        int duration = ADMISSION_DEFAULT_DURATION;
+
+        for (char *param = query; param && *param; ) {
+            char *next = strchr(param, '&');
+            if (next) {
+                *next++ = '\0';
+            }
+            if (strncmp(param, "duration=", 9) == 0) {
+                char *endptr;
+                long value = strtol(param + 9, &endptr, 10);
+                if (endptr == param + 9 || *endptr != '\0' || value < 0 || value > ADMISSION_DURATION_MAX) {
+                    client_finish(c, "400 Bad Request", "", "");
+                    return;
+                }
+                duration = (int)value;
+            }
+            param = next;
+        }
+
+        const headroom_t *h = headroom_get();
+        time_t now = sys_time();
+        admission_t a;
+        admission_decide(h, recovery_state()->step != RECOVERY_NONE, duration, now, &a);
+
+        char headers[SMALL_BUFFER_LEN * 4];
+        char body[HTTP_SAMPLE_JSON_LEN * 3];
+        int len = snprintf(headers, sizeof(headers), "Content-Type: application/json\r\nCache-Control: no-cache\r\n");
+        if (a.decision == ADMISSION_DEFER) {
+            snprintf(headers + len, sizeof(headers) - (size_t)len, "Retry-After: %lld\r\n",
+                     (long long)(a.until - now));
+        }
+        admission_format_json(&a, h, now, body, sizeof(body));
+        client_finish(c, "200 OK", headers, body);
+        return;
+    }
+
+    client_finish(c, "404 Not Found", "", "");
+}
+
+/**
+ * client_read - Handle readable data on a client socket
+ */
+static void client_read(http_client_t *c)
+{
+    char discard[256];
+
+    if (c->state != HTTP_CLIENT_READING) {
+        /* Nothing more is expected; only detect the peer going away */
+        ssize_t n = recv(c->fd, discard, sizeof(discard), MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            client_close(c);
+        }
+        return;
+    }
+
+    ssize_t n = recv(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len, MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        client_close(c);
+        return;
+    }
+    if (n < 0) {
+        return;
+    }
+
+    c->in_len += (size_t)n;
+    c->in[c->in_len] = '\0';
+
+    if (strstr(c->in, "\r\n\r\n") || strstr(c->in, "\n\n")) {
+        handle_request(c);
+    } else if (c->in_len >= sizeof(c->in) - 1) {
+        client_finish(c, "431 Request Header Fields Too Large", "", "");
+    }
+}
+
+/**
+ * client_timeout - Handle an expired client deadline
+ */
+static void client_timeout(http_client_t *c)
+{
+    switch (c->state) {
+        case HTTP_CLIENT_WAITING:
+            client_send_sample(c, false);
+            break;
+        case HTTP_CLIENT_STREAM:
+            /* Keeps proxies from closing idle streams */
+            if (client_printf(c, ": keepalive\n\n") == 0) {
+                c->deadline = deadline_in(HTTP_SSE_KEEPALIVE);
+            }
+            break;
+        default:
+            client_close(c);
+            break;
+    }
+}
+
+/**
+ * accept_clients - Accept pending connections
+ */
+static void accept_clients(void)
+{
+    for (;;) {
+        int fd = accept4(g_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        http_client_t *c = NULL;
+        for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+            if (g_clients[i].state == HTTP_CLIENT_FREE) {
+                c = &g_clients[i];
+                break;
+            }
+        }
+        if (!c) {
+            logging_debug("HTTP client limit reached, connection refused");
+            close(fd);
+            continue;
+        }
+
+        c->fd = fd;
+        c->state = HTTP_CLIENT_READING;
+        c->in_len = 0;
+        c->out_len = 0;
+        c->since = 0;
+        c->deadline = deadline_in(HTTP_REQUEST_TIMEOUT);
+        g_client_count++;
+    }
+}
+
+/* ============================================================================
+ * LISTENER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * listen_unix - Create the listening Unix socket
+ */
+static int listen_unix(const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+    if (sys_path(g_unix_path, sizeof(g_unix_path), path) != 0 ||
+        strlen(g_unix_path) >= sizeof(addr.sun_path)) {
+        logging_error("HTTP socket path too long: %s", path);
+        g_unix_path[0] = '\0';
+        return -1;
+    }
+    memcpy(addr.sun_path, g_unix_path, strlen(g_unix_path) + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        g_unix_path[0] = '\0';
+        return -1;
+    }
+
+    /* A stale socket from an earlier run or image would make bind() fail */
+    unlink(g_unix_path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        logging_error("Cannot bind HTTP socket %s: %s", g_unix_path, strerror(errno));
+        close(fd);
+        g_unix_path[0] = '\0';
+        return -1;
+    }
+    chmod(g_unix_path, 0660);
+
+    return fd;
+}
+
+/**
+ * listen_loopback - Create the listening TCP socket on a loopback address
+ */
+static int listen_loopback(const char *spec)
+{
+    char host[SMALL_BUFFER_LEN * 4];
+    struct sockaddr_storage addr = {0};
+    socklen_t addr_len;
+
+    const char *colon = strrchr(spec, ':');
+    if (!colon || (size_t)(colon - spec) >= sizeof(host)) {
+        logging_error("Invalid http_listen '%s' (expected unix:<path> or <loopback address>:<port>)", spec);
+        return -1;
+    }
+    memcpy(host, spec, (size_t)(colon - spec));
+    host[colon - spec] = '\0';
+
+    char *endptr;
+    long port = strtol(colon + 1, &endptr, 10);
+    if (*endptr != '\0' || port < 1 || port > 65535) {
+        logging_error("Invalid http_listen port in '%s'", spec);
+        return -1;
+    }
+
+    /* Strip IPv6 brackets */
+    char *h = host;
+    if (h[0] == '[' && h[strlen(h) - 1] == ']') {
+        h[strlen(h) - 1] = '\0';
+        h++;
+    }
+    if (strcmp(h, "localhost") == 0) {
+        h = "127.0.0.1";
+    }
+
+    struct sockaddr_in *sin = (struct sockaddr_in *)&addr;
+    struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&addr;
+    if (inet_pton(AF_INET, h, &sin->sin_addr) == 1) {
+        if ((ntohl(sin->sin_addr.s_addr) >> 24) != 127) {
+            logging_error("http_listen must be a loopback address, got '%s'", h);
+            return -1;
+        }
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons((uint16_t)port);
+        addr_len = sizeof(*sin);
+    } else if (inet_pton(AF_INET6, h, &sin6->sin6_addr) == 1) {
+        if (!IN6_IS_ADDR_LOOPBACK(&sin6->sin6_addr)) {
+            logging_error("http_listen must be a loopback address, got '%s'", h);
+            return -1;
+        }
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons((uint16_t)port);
+        addr_len = sizeof(*sin6);
+    } else {
+        logging_error("Invalid http_listen address '%s'", h);
+        return -1;
+    }
+
+    int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&addr, addr_len) != 0) {
+        logging_error("Cannot bind HTTP endpoint %s: %s", spec, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Start listening
+ *
+ * @param listen_spec "unix:<path>", "<path>" or "<loopback address>:<port>";
+ *                    empty disables the endpoint
+ * @return 0 on success or if disabled, -1 on error
+ */
+int http_open(const char *listen_spec)
+{
+    http_close();
+
+    if (!listen_spec || !*listen_spec) {
+        return 0;
+    }
+
+    if (strncmp(listen_spec, "unix:", 5) == 0) {
+        g_listen_fd = listen_unix(listen_spec + 5);
+    } else if (listen_spec[0] == '/') {
+        g_listen_fd = listen_unix(listen_spec);
+    } else {
+        g_listen_fd = listen_loopback(listen_spec);
+    }
+
+    if (g_listen_fd < 0) {
+        return -1;
+    }
+
+    if (listen(g_listen_fd, HTTP_MAX_CLIENTS) != 0) {
+        logging_error("Cannot listen on HTTP endpoint %s: %s", listen_spec, strerror(errno));
+        http_close();
+        return -1;
+    }
+
+    logging_info("HTTP endpoint listening on %s", listen_spec);
+    return 0;
+}
+
+/**
+ * Stop listening and disconnect all clients
+ */
+void http_close(void)
+{
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        client_close(&g_clients[i]);
+    }
+
+    if (g_listen_fd >= 0) {
+        close(g_listen_fd);
+        g_listen_fd = -1;
+    }
+    if (g_unix_path[0]) {
+        unlink(g_unix_path);
+        g_unix_path[0] = '\0';
+    }
+}
+
+/**
+ * Check whether the endpoint is listening
+ *
+ * @return true if listening
+ */
+bool http_enabled(void)
+{
+    return g_listen_fd >= 0;
+}
+
+/**
+ * Number of connected clients
+ *
+ * @return Open client connections
+ */
+int http_client_count(void)
+{
+    return g_client_count;
+}
+
+/* ============================================================================
+ * PUBLISH & EVENT LOOP
+ * ============================================================================ */
+
+/**
+ * Publish a new sample to streams and waiting long-poll requests
+ *
+ * @param sample Sample with a new sequence number
+ */
+void http_publish(const http_sample_t *sample)
+{
+    g_sample = *sample;
+
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        http_client_t *c = &g_clients[i];
+
+        if (c->state == HTTP_CLIENT_WAITING && g_sample.seq != c->since) {
+            client_send_sample(c, true);
+        } else if (c->state == HTTP_CLIENT_STREAM) {
+            client_send_event(c);
+        } else {
+            continue;
+        }
+        client_flush(c);
+    }
+}
+
+/**
+ * Serve clients until an absolute CLOCK_MONOTONIC deadline
+ *
+ * @param deadline Deadline on the real monotonic clock
+ * @return Wakeup lateness in microseconds, -1 if interrupted by a signal
+ */
+long http_wait_until(const struct timespec *deadline)
+{
+    struct pollfd fds[HTTP_MAX_CLIENTS + 1];
+    http_client_t *owners[HTTP_MAX_CLIENTS + 1];
+
+    for (;;) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        /* 64-bit: a 32-bit long holds only 2.1 s in nanoseconds */
+        int64_t remaining_ns = (int64_t)(deadline->tv_sec - now.tv_sec) * 1000000000LL +
+                               (deadline->tv_nsec - now.tv_nsec);
+        if (remaining_ns <= 0) {
+            return (long)(-remaining_ns / 1000LL);
+        }
+
+        /* Expire client deadlines and find the nearest one */
+        int nfds = 0;
+        fds[nfds].fd = g_listen_fd;
+        fds[nfds].events = POLLIN;
+        owners[nfds++] = NULL;
+
+        for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+            http_client_t *c = &g_clients[i];
+            if (c->state == HTTP_CLIENT_FREE) {
+                continue;
+            }
+
+            long until_ms = diff_ms(&now, &c->deadline);
+            if (until_ms <= 0) {
+                client_timeout(c);
+                client_flush(c);
+                if (c->state == HTTP_CLIENT_FREE) {
+                    continue;
+                }
+                until_ms = diff_ms(&now, &c->deadline);
+            }
+            if (until_ms > 0 && (int64_t)until_ms * 1000000LL < remaining_ns) {
+                remaining_ns = (int64_t)until_ms * 1000000LL;
+            }
+
+            fds[nfds].fd = c->fd;
+            fds[nfds].events = POLLIN | (c->out_len > 0 ? POLLOUT : 0);
+            owners[nfds++] = c;
+        }
+
+        struct timespec timeout = {
+            .tv_sec = (time_t)(remaining_ns / 1000000000LL),
+            .tv_nsec = (long)(remaining_ns % 1000000000LL)
+        };
+        int ready = ppoll(fds, (nfds_t)nfds, &timeout, NULL);
+        if (ready < 0) {
+            return (errno == EINTR) ? -1 : sys_sleep_until(deadline);
+        }
+        if (ready == 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            accept_clients();
+        }
+
+        for (int i = 1; i < nfds; i++) {
+            http_client_t *c = owners[i];
+            if (c->state == HTTP_CLIENT_FREE || fds[i].revents == 0) {
+                continue;
+            }
+            if (fds[i].revents & (POLLERR | POLLNVAL)) {
+                client_close(c);
+                continue;
+            }
+            if (fds[i].revents & (POLLIN | POLLHUP)) {
+                client_read(c);
+            }
+            client_flush(c);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/**
+ * @file admission.h
+ * @brief Thermal admission control declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for thermal admission control. Tools that run heavy modem
+ * operations (network scans, firmware queries, speed tests) ask before
+ * starting and get one of
+ *
+ *   admit   enough headroom for the operation
+ *   defer   not now; retry at the given time
+ *   deny    no headroom expected (critical, hot and not cooling, or no data)
+ *
+ * The decision uses the published headroom: current temperature and trend,
+ * projected over the operation's duration, against temp_max minus
+ * admission_margin. It is answered by the daemon's HTTP endpoint
+ * (/admission) and by the admit subcommand from the state file.
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <stdbool.h>
+#include <time.h>
+#include "config.h"
+#include "headroom.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define ADMISSION_DEFAULT_DURATION  60      /* Assumed operation length (s) */
+#define ADMISSION_DURATION_MAX      3600
+#define ADMISSION_RETRY_SEC         60      /* Defer time when no cooling is visible */
+#define ADMISSION_DEFER_MAX         1800    /* Longer expected waits are denied */
+#define ADMISSION_MIN_COOLING       100     /* m°C/min a falling trend needs to be projected */
+#define ADMISSION_STALE_MIN         60      /* Minimum age (s) before a sample is stale */
+#define ADMISSION_EXIT_DEFER        75      /* admit exit status for defer (EX_TEMPFAIL) */
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+typedef enum {
+    ADMISSION_ADMIT = 0,
+    ADMISSION_DEFER,
+    ADMISSION_DENY
+} admission_decision_t;
+
+/**
+ * Admission answer
+ */
+typedef struct {
+    int decision;                /* admission_decision_t */
+    const char *reason;          /* Short keyword, e.g. "cooling" */
+    time_t until;                /* Daemon clock to retry at (defer only) */
+    int projected_mdeg;          /* Temperature expected at the end of the operation */
+    int limit_mdeg;              /* temp_max - admission_margin */
+} admission_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Apply admission_margin and the sample staleness limit
+ *
+ * Call after headroom_configure(), the limit follows temp_max.
+ *
+ * @param cfg Configuration
+ */
+void admission_configure(const config_t *cfg);
+
+/**
+ * Decide whether a heavy operation may start now
+ *
+ * @param h Published headroom
+ * @param recovering true while the modem recovery ladder is running
+ * @param duration Expected operation length in seconds
+ * @param now Daemon clock
+ * @param out Filled with the answer
+ */
+void admission_decide(const headroom_t *h, bool recovering, int duration, time_t now,
+                      admission_t *out);
+
+/**
+ * Name of a decision
+ *
+ * @param decision admission_decision_t
+ * @return "admit", "defer" or "deny"
+ */
+const char *admission_name(int decision);
+
+/**
+ * Format an answer as a JSON object (with trailing newline)
+ *
+ * @param a Answer
+ * @param h Headroom the answer is based on
+ * @param now Daemon clock
+ * @param buf Output buffer
+ * @param size Size of buf
+ * @return snprintf() result
+ */
+int admission_format_json(const admission_t *a, const headroom_t *h, time_t now,
+                          char *buf, size_t size);
+
+/**
+ * Admit subcommand - answer from the daemon's state file
+ *
+ * @param cfg Configuration
+ * @param duration Expected operation length in seconds
+ * @param json Output as JSON
+ * @return 0 admit, ADMISSION_EXIT_DEFER defer, 1 deny
+ */
+int admission_mode(const config_t *cfg, int duration, bool json);
+
+#endif /* ADMISSION_H */
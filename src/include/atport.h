@@ -0,0 +1,126 @@
+/**
+ * @file atport.h
+ * @brief AT port pool declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the daemon's AT port pool. The modem exposes several
+ * AT-capable ttys; the pool keeps the preferred working port active and
+ * the next one open as a warm standby, tracks a health score per port and
+ * fails over to the standby within the same sample when the active port
+ * stops answering.
+ */
+
+#ifndef ATPORT_H
+#define ATPORT_H
+
+#include <stdbool.h>
+#include "config.h"
+#include "handoff.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define ATPORT_HEALTH_MAX        100
+#define ATPORT_HEALTH_FAILBACK   80   /* Health a preferred port needs to become active again */
+#define ATPORT_MAX_FAILURES      3    /* Consecutive failures before a port is closed */
+#define ATPORT_PROBE_INTERVAL    6    /* Samples between keepalive probes of the standby */
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Apply the configured port list and baud rate
+ *
+ * Ports that are no longer listed, or all ports if the baud rate changed,
+ * are closed. Health scores of ports that stay listed are kept.
+ *
+ * @param cfg Configuration with at_ports and baud_rate
+ */
+void atport_configure(const config_t *cfg);
+
+/**
+ * Open the active port and the warm standby
+ *
+ * While no port is open all ports are tried in order. Otherwise closed
+ * ports are only reopened after their retry delay.
+ *
+ * @return 0 if an active port is open, -1 if no port could be opened
+ */
+int atport_open(void);
+
+/**
+ * Check whether an active port is open
+ *
+ * @return true if AT commands can be sent
+ */
+bool atport_connected(void);
+
+/**
+ * Send an AT command, failing over to the standby if the active port fails
+ *
+ * A response counts only if it ends in a final OK; an echo or garbage
+ * without a result code is a failure of the port.
+ *
+ * @param command AT command including the trailing CR
+ * @param response Response buffer
+ * @param response_len Size of the response buffer
+ * @return Number of bytes in response, -1 if no port answered with OK
+ */
+int atport_command(const char *command, char *response, size_t response_len);
+
+/**
+ * Send an AT command through a port other than the active one
+ *
+ * Used when the active port is wedged: the standby is tried first, then
+ * every other configured port is opened for the one command, and the
+ * active port is only used as the last resort.
+ *
+ * @param command AT command including the trailing CR
+ * @param response Response buffer
+ * @param response_len Size of the response buffer
+ * @return Number of bytes in response, -1 if no port answered
+ */
+int atport_command_other(const char *command, char *response, size_t response_len);
+
+/**
+ * Per-sample housekeeping: probe the standby and fail back
+ *
+ * Every ATPORT_PROBE_INTERVAL calls the standby is sent a bare AT so its
+ * health stays current. A standby that is preferred over the active port
+ * takes over again once its health reaches ATPORT_HEALTH_FAILBACK.
+ */
+void atport_maintain(void);
+
+/**
+ * Close all ports
+ */
+void atport_close_all(void);
+
+/**
+ * Log per-port health and counters
+ */
+void atport_log_health(void);
+
+/**
+ * Describe the open ports for a re-exec handoff
+ *
+ * @param state Filled with port paths, descriptors and health
+ * @return Number of open ports
+ */
+int atport_export(handoff_ports_t *state);
+
+/**
+ * Take over ports from a previous image
+ *
+ * Descriptors are only adopted for ports that are still configured with
+ * the same baud rate; all others are closed.
+ *
+ * @param state Port state handed over by the previous image
+ */
+void atport_import(const handoff_ports_t *state);
+
+#endif /* ATPORT_H */
@@ -0,0 +1,48 @@
+/**
+ * @file bench.h
+ * @brief AT round-trip benchmark declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the bench subcommand, which measures AT command
+ * round-trip performance of a live modem to tell slow firmware, USB link
+ * and baud rate settings apart.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <termios.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define BENCH_DEFAULT_COUNT      20     /* Transactions per command and baud rate */
+#define BENCH_MAX_COUNT          10000
+#define BENCH_MAX_TIMEOUTS       3      /* Consecutive timeouts before a baud rate is skipped */
+#define BENCH_PAUSE_TIMEOUT      15     /* Seconds to wait for the daemon to release the port */
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Bench mode - measure AT round-trip performance
+ *
+ * Runs @count timed AT and AT+QTEMP transactions per baud rate using
+ * init_serial_port() and send_at_command(), and reports latency
+ * percentiles, bytes per response, timeouts and throughput. A running
+ * daemon is paused for the duration of the run.
+ *
+ * @param port Serial port to benchmark
+ * @param baud_rate Single baud rate to test, or 0 to sweep all supported rates
+ * @param count Transactions per command and baud rate
+ * @param json Output results as JSON
+ * @return 0 on success, 1 on error
+ */
+int bench_mode(const char *port, speed_t baud_rate, int count, bool json);
+
+#endif /* BENCH_H */
@@ -91,15 +91,19 @@
  * ============================================================================ */
 
 /* Serial port reconnection settings */
-#define SERIAL_MAX_RECONNECT_ATTEMPTS  5    /* Maximum retry attempts */
 #define SERIAL_INITIAL_RECONNECT_DELAY 10   /* Initial delay in seconds */
 #define SERIAL_MAX_RECONNECT_DELAY     60   /* Maximum delay in seconds */
-#define SERIAL_MAX_FAILED_CYCLES       3    /* Exit after N reconnect cycles without success */
 
 /* Daemon timing intervals */
 #define STATS_LOG_INTERVAL             100  /* Log stats every N iterations */
 #define CONFIG_CHECK_INTERVAL          60   /* Check UCI config every N seconds */
 
+/* Sampling lateness above this is counted as a late sample */
+#define SAMPLE_LATE_THRESHOLD_US       100000
+
+/* Resource self-monitoring (checked with every statistics log) */
+#define RESOURCE_RSS_GROWTH_KB         256  /* Warn when RSS exceeds baseline by this much */
+
 /* ============================================================================
  * HELPER MACROS
  * ============================================================================ */
@@ -12,25 +12,102 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <stdint.h>
+#include <stddef.h>
 #include <termios.h>
 #include "common.h"
 
-/* Configuration structure */
+/* Maximum number of board hwmon sensors used for fallback estimation */
+#define MAX_BOARD_SENSORS 4
+
+/* Maximum number of AT ports (serial_port plus at_port standbys) */
+#define MAX_AT_PORTS 4
+
+/* Reaction rules (UCI 'rule' sections) */
+#define MAX_RULES        8
+#define RULE_NAME_LEN    32
+#define RULE_ACTION_LEN  256
+#define RULE_COUNT_MAX   16   /* Upper bound for a rule's 'count' option */
+
+/* Value a rule is evaluated on */
+typedef enum {
+    RULE_METRIC_TEMP = 0,        /* Published temperature (incl. estimates) */
+    RULE_METRIC_MODEM,           /* Modem sensor of AT+QTEMP */
+    RULE_METRIC_AP,              /* AP sensor of AT+QTEMP */
+    RULE_METRIC_PA,              /* PA sensor of AT+QTEMP */
+    RULE_METRIC_RATE,            /* Rate of change of the published temperature */
+    RULE_METRIC_HEADROOM         /* Published thermal headroom score (0-100) */
+} rule_metric_t;
+
+/* Reaction rule */
+typedef struct {
+    char name[RULE_NAME_LEN];
+    int metric;                  /* rule_metric_t */
+    int above;                   /* 1: fire above threshold, 0: fire below */
+    int threshold;               /* m°C (m°C/min for rate) */
+    int hysteresis;              /* Clears once this far back across the threshold */
+    int duration;                /* Seconds the condition must hold (0 = first sample) */
+    int count;                   /* Matching samples needed within window (0 = use duration) */
+    int window;                  /* Seconds for count; smoothing time for rate */
+    int cooldown;                /* Minimum seconds between two firings */
+    char action[RULE_ACTION_LEN];        /* Shell command run when the rule fires */
+    char clear_action[RULE_ACTION_LEN];  /* Shell command run when it clears ("" = none) */
+} rule_config_t;
+
+/* Configuration structure (new fields also go into config_layout_hash()) */
 typedef struct {
     char serial_port[CONFIG_STRING_LEN];
+    char at_ports[MAX_AT_PORTS][CONFIG_STRING_LEN]; /* serial_port first, then at_port list */
+    int at_port_count;
     int interval;
     speed_t baud_rate;
     char error_value[CONFIG_STRING_LEN];
     char log_level[CONFIG_STRING_LEN];
+    int log_async;               /* Queue log messages for a writer thread */
     char temp_modem_prefix[CONFIG_STRING_LEN];
     char temp_ap_prefix[CONFIG_STRING_LEN];
     char temp_pa_prefix[CONFIG_STRING_LEN];
+    char board_sensors[MAX_BOARD_SENSORS][CONFIG_STRING_LEN];
+    int board_sensor_count;
+    int board_agree_delta;       /* m°C: modem and board estimate "agree" within this */
+    int interval_max;            /* Relaxed polling interval while sources agree (s) */
+    int realtime;                /* SCHED_FIFO, mlockall and CPU pinning for sampling */
+    int rt_priority;             /* SCHED_FIFO priority (1-99) */
+    unsigned long cpu_affinity;  /* CPU mask (bit N = CPU N, 0 = no pinning) */
+    char http_listen[CONFIG_STRING_LEN]; /* HTTP endpoint ("" = disabled) */
+    char temp_min[SMALL_BUFFER_LEN];     /* Thresholds as configured in °C ("" = unset) */
+    char temp_max[SMALL_BUFFER_LEN];
+    char temp_crit[SMALL_BUFFER_LEN];
+    char temp_default[SMALL_BUFFER_LEN];
+    int headroom_span;           /* m°C below temp_max where the headroom score starts to fall */
+    int headroom_horizon;        /* Seconds a rising trend is projected ahead */
+    int headroom_hysteresis;     /* Score points before a change is republished */
+    int admission_margin;        /* °C below temp_max heavy operations must stay */
+    char histogram_file[CONFIG_STRING_LEN]; /* Persistent time-at-temperature file ("" = /var/run only) */
+    int histogram_save;          /* Seconds between writes of histogram_file */
+    int stress_ea;               /* Arrhenius activation energy in meV */
+    int stress_ref;              /* Arrhenius reference temperature in m°C */
+    int quantile_window;         /* Seconds covered by the p50/p95/p99 window */
+    int history_size;            /* Samples kept for history export (0 = disabled) */
+    int recovery_reopen_timeout; /* Seconds each recovery step gets before escalating */
+    int recovery_reset_timeout;
+    int recovery_usb_timeout;
+    int recovery_power_timeout;
+    char usb_device[CONFIG_STRING_LEN];  /* Modem USB device for unbind/rebind ("" = skip) */
+    char power_gpio[CONFIG_STRING_LEN];  /* Modem power GPIO number or value file ("" = skip) */
+    int power_gpio_active_low;   /* Modem is powered while the GPIO is low */
+    rule_config_t rules[MAX_RULES];
+    int rule_count;
 } config_t;
 
+struct uci_context;
+
 /* Function declarations */
+struct uci_context *config_uci_alloc_context(void);
 int config_read_uci(config_t *config);
 void config_set_defaults(config_t *config);
 int config_parse_baud_rate(const char *baud_str, speed_t *baud_rate);
 int config_parse_log_level(const char *level_str);
+uint32_t config_crc32(const void *data, size_t len);
 
 #endif /* CONFIG_H */
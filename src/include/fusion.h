@@ -0,0 +1,106 @@
+/**
+ * @file fusion.h
+ * @brief Board sensor fusion function declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the board sensor fallback. The daemon learns an online
+ * offset between one or more board hwmon sensors near the modem slot and
+ * the modem's own AT+QTEMP readings, and uses it to publish an estimated
+ * temperature whenever the AT path is unavailable.
+ */
+
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <stdbool.h>
+#include "config.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define FUSION_MIN_SAMPLES   6      /* Paired samples before estimates are trusted */
+#define FUSION_EWMA_WEIGHT   0.1    /* Weight of a new sample in the offset model */
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+/**
+ * Offset model state
+ */
+typedef struct {
+    double offset_mdeg;          /* EWMA of (modem - board) in m°C */
+    double variance;             /* EWMA of squared residual (m°C^2) */
+    unsigned long samples;       /* Paired samples learned so far */
+} fusion_model_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Resolve configured board sensors to hwmon input paths
+ *
+ * Each entry of config->board_sensors is either an absolute sysfs path to a
+ * temp*_input file, an hwmon device name (uses temp1_input) or
+ * "name:tempN" to select a specific channel. The learned model is reset
+ * when the sensor set changes.
+ *
+ * @param config Configuration with board sensor list
+ * @return Number of resolved sensors (0 if fusion is disabled)
+ */
+int fusion_init(const config_t *config);
+
+/**
+ * Check if at least one board sensor is configured and resolved
+ *
+ * @return true if board sensors are available
+ */
+bool fusion_enabled(void);
+
+/**
+ * Read the board temperature (mean of all resolved board sensors)
+ *
+ * @param board_mdeg Pointer to store result in m°C
+ * @return 1 on success, 0 if any resolved board sensor could not be read
+ */
+int fusion_read_board(int *board_mdeg);
+
+/**
+ * Feed a paired modem/board sample into the offset model
+ *
+ * @param modem_mdeg Modem temperature from AT+QTEMP in m°C
+ * @param board_mdeg Board temperature read at the same time in m°C
+ */
+void fusion_update(int modem_mdeg, int board_mdeg);
+
+/**
+ * Estimate the modem temperature from a board reading
+ *
+ * @param board_mdeg Board temperature in m°C
+ * @param estimate_mdeg Pointer to store the estimate in m°C
+ * @return 1 if the model is trained and an estimate was produced, 0 otherwise
+ */
+int fusion_estimate(int board_mdeg, int *estimate_mdeg);
+
+/**
+ * Check if modem and board-derived readings agree
+ *
+ * @param modem_mdeg Modem temperature in m°C
+ * @param board_mdeg Board temperature in m°C
+ * @param tolerance_mdeg Maximum allowed difference in m°C
+ * @return true if the model is trained and the residual is within tolerance
+ */
+bool fusion_sources_agree(int modem_mdeg, int board_mdeg, int tolerance_mdeg);
+
+/**
+ * Access the offset model (for statistics logging)
+ *
+ * @return Pointer to the live model
+ */
+fusion_model_t *fusion_model(void);
+
+#endif /* FUSION_H */
@@ -0,0 +1,176 @@
+/**
+ * @file handoff.h
+ * @brief Daemon re-exec state handoff declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the daemon state handoff. On SIGHUP the daemon serializes
+ * its runtime state as type-length-value records into an anonymous memfd,
+ * keeps the open serial port and lock file descriptors across exec(), and
+ * re-executes its own binary. The new image picks the state up again, so
+ * statistics survive and sampling continues without reopening the port.
+ */
+
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HANDOFF_ENV          "QUECTEL_HANDOFF_FD"  /* memfd number for the new image */
+#define HANDOFF_MAGIC        0x464f4851u           /* "QHOF" */
+#define HANDOFF_VERSION      1
+#define HANDOFF_MAX_SIZE     (1024 * 1024)         /* Upper bound for a state blob */
+
+/*
+ * Record types. Records are only accepted if their length matches the
+ * reader's structure size, and unknown types are skipped, so old and new
+ * images with differing layouts degrade to a partial handoff instead of
+ * misinterpreting state. Never renumber existing types.
+ */
+typedef enum {
+    HANDOFF_TLV_DAEMON = 1,      /* handoff_daemon_t */
+    HANDOFF_TLV_STATS = 2,       /* Daemon statistics counters */
+    HANDOFF_TLV_FUSION = 3,      /* Board sensor offset model */
+    HANDOFF_TLV_SERIAL = 4,      /* Retired single serial port, superseded by HANDOFF_TLV_PORTS */
+    HANDOFF_TLV_BOARD = 5,       /* Board sensor list the fusion model belongs to */
+    HANDOFF_TLV_SAMPLE = 6,      /* Last published sample (http_sample_t) */
+    HANDOFF_TLV_PORTS = 7,       /* handoff_ports_t */
+    HANDOFF_TLV_RULES = 8,       /* handoff_rules_t */
+    HANDOFF_TLV_HISTOGRAM = 9,   /* Time-at-temperature counters (histogram_data_t) */
+    HANDOFF_TLV_WINDOW = 10,     /* Sliding quantile window (histogram_window_t) */
+    HANDOFF_TLV_RECOVERY = 11,   /* Modem recovery ladder (recovery_state_t) */
+} handoff_tlv_type_t;
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+/**
+ * General daemon state
+ */
+typedef struct {
+    int64_t start_time;          /* Daemon start time (uptime survives re-exec) */
+    int32_t lock_fd;             /* Inherited daemon lock file descriptor */
+    int32_t reserved0;           /* Formerly failed_cycles, see HANDOFF_TLV_RECOVERY */
+    uint32_t reexec_count;       /* Number of re-execs since start */
+    uint32_t reserved;
+} handoff_daemon_t;
+
+/**
+ * AT port pool state (active, warm standby and health scores)
+ */
+#define HANDOFF_MAX_PORTS 4
+
+typedef struct {
+    int32_t fd;                  /* Inherited descriptor, -1 if closed */
+    int32_t health;              /* Health score 0-100 */
+    char port[64];
+} handoff_port_t;
+
+typedef struct {
+    uint32_t baud_rate;          /* speed_t the ports were configured with */
+    int32_t active;              /* Index of the active port, -1 = none */
+    int32_t standby;             /* Index of the warm standby, -1 = none */
+    uint32_t count;
+    handoff_port_t ports[HANDOFF_MAX_PORTS];
+} handoff_ports_t;
+
+/**
+ * Reaction rule state (matched by rule name)
+ */
+#define HANDOFF_MAX_RULES 8
+
+typedef struct {
+    char name[32];
+    int32_t active;              /* Fired and not yet cleared */
+    int32_t fired;               /* Times fired since daemon start */
+    int64_t last_fired;          /* Daemon clock of the last firing, 0 = never */
+    int64_t cond_since;          /* Start of the current run past the threshold, 0 = none */
+} handoff_rule_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t reserved;
+    handoff_rule_t rules[HANDOFF_MAX_RULES];
+} handoff_rules_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Start collecting state for a re-exec
+ *
+ * @return 0 on success, -1 if no memfd could be created
+ */
+int handoff_begin(void);
+
+/**
+ * Append a state record
+ *
+ * @param type Record type
+ * @param data Record payload
+ * @param len Payload length in bytes
+ * @return 0 on success, -1 on error
+ */
+int handoff_put(uint16_t type, const void *data, uint32_t len);
+
+/**
+ * Keep a file descriptor open across exec()
+ *
+ * @param fd File descriptor to inherit
+ * @return 0 on success, -1 on error
+ */
+int handoff_keep_fd(int fd);
+
+/**
+ * Discard the collected state after a failed re-exec
+ *
+ * Closes the memfd and makes the descriptors passed to handoff_keep_fd()
+ * close-on-exec again. Safe to call if nothing was collected.
+ */
+void handoff_abort(void);
+
+/**
+ * Re-execute the daemon binary with the collected state
+ *
+ * The command line of the current process is reused. If the binary was
+ * started with an absolute path, that path is executed (picking up an
+ * upgraded binary), otherwise /proc/self/exe.
+ *
+ * @return Only returns on failure (-1); the collected state is discarded
+ */
+int handoff_exec(void);
+
+/**
+ * Take over state passed by a previous image
+ *
+ * Reads and validates the memfd named by HANDOFF_ENV, then closes it and
+ * clears the variable so it is not inherited by child processes.
+ *
+ * @return true if handoff state is available
+ */
+bool handoff_receive(void);
+
+/**
+ * Copy a received state record
+ *
+ * @param type Record type
+ * @param data Destination buffer
+ * @param len Expected payload length (must match exactly)
+ * @return 0 on success, -1 if the record is missing or has another size
+ */
+int handoff_get(uint16_t type, void *data, uint32_t len);
+
+/**
+ * Release received state
+ */
+void handoff_release(void);
+
+#endif /* HANDOFF_H */
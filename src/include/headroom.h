@@ -0,0 +1,106 @@
+/**
+ * @file headroom.h
+ * @brief Thermal headroom score declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the thermal headroom score. The daemon condenses the
+ * current temperature, its trend and the configured thresholds into one
+ * number from 100 (cool) to 0 (at temp_max within the projection horizon),
+ * so multi-WAN policies can shift traffic away before firmware throttling
+ * starts. The score is published with hysteresis to the state file and the
+ * HTTP endpoint.
+ */
+
+#ifndef HEADROOM_H
+#define HEADROOM_H
+
+#include <stdbool.h>
+#include <time.h>
+#include "config.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HEADROOM_TREND_WINDOW        60     /* Smoothing time of the trend (s) */
+#define HEADROOM_CRIT_CLEAR          2000   /* m°C below temp_crit to leave 'critical' */
+#define HEADROOM_WARM_SCORE          50     /* Scores below this are 'warm' */
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+typedef enum {
+    HEADROOM_LEVEL_OK = 0,       /* Score >= HEADROOM_WARM_SCORE */
+    HEADROOM_LEVEL_WARM,         /* Score below HEADROOM_WARM_SCORE */
+    HEADROOM_LEVEL_HOT,          /* Score 0: temp_max reached within the horizon */
+    HEADROOM_LEVEL_CRITICAL      /* At or above temp_crit */
+} headroom_level_t;
+
+/**
+ * Published headroom
+ */
+typedef struct {
+    int score;                   /* 0-100, -1 before the first sample */
+    int level;                   /* headroom_level_t */
+    int trend;                   /* Smoothed rate of change in m°C/min */
+    int projected_mdeg;          /* Temperature expected at the end of the horizon */
+    int temp_mdeg;               /* Last temperature */
+    bool estimated;              /* Last sample was a board-sensor estimate */
+    time_t changed;              /* Daemon clock when score or level last changed */
+    time_t updated;              /* Daemon clock of the last temperature */
+} headroom_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Apply thresholds and headroom options
+ *
+ * @param cfg Configuration
+ */
+void headroom_configure(const config_t *cfg);
+
+/**
+ * Update the score with a published temperature
+ *
+ * Writes the state file keys headroom, headroom_level, headroom_source,
+ * headroom_changed, headroom_temp, headroom_trend and headroom_updated when
+ * the published values change.
+ *
+ * @param temp_mdeg Temperature in m°C
+ * @param estimated true for a board-sensor estimate
+ */
+void headroom_update(int temp_mdeg, bool estimated);
+
+/**
+ * Continue from the score published by a previous image (re-exec)
+ */
+void headroom_resume(void);
+
+/**
+ * Current published headroom
+ *
+ * @return Headroom state
+ */
+const headroom_t *headroom_get(void);
+
+/**
+ * Configured temp_max
+ *
+ * @return temp_max in m°C
+ */
+int headroom_temp_max(void);
+
+/**
+ * Name of a headroom level
+ *
+ * @param level headroom_level_t
+ * @return "ok", "warm", "hot" or "critical"
+ */
+const char *headroom_level_name(int level);
+
+#endif /* HEADROOM_H */
@@ -0,0 +1,164 @@
+/**
+ * @file histogram.h
+ * @brief Time-at-temperature histogram declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the time-at-temperature histogram. The daemon adds the
+ * time between two AT+QTEMP readings to one 1 °C band per sensor (constant
+ * work per sample, fixed size) and keeps the counters across restarts and
+ * reboots. An Arrhenius acceleration model turns the histogram into
+ * equivalent hours at a reference temperature, a single figure for
+ * warranty and replacement planning.
+ *
+ * A sliding window of the same bands, kept as HISTOGRAM_WINDOW_SLOTS
+ * sub-windows, yields p50/p95/p99 per sensor in bounded memory. AT+QTEMP
+ * reports whole degrees, so these quantiles are exact, and windows from
+ * several routers merge by adding their band counters.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HISTOGRAM_MIN_C        -40     /* Lower edge of the first band (°C) */
+#define HISTOGRAM_BINS         166     /* 1 °C bands from -40 to 125 °C */
+#define HISTOGRAM_SENSORS      3       /* modem, ap, pa */
+#define HISTOGRAM_LIVE_FILE    "/var/run/quectel_rm520n_thermal.hist"
+#define HISTOGRAM_LIVE_SAVE    60      /* Seconds between writes of the live copy */
+#define HISTOGRAM_WINDOW_FILE  "/var/run/quectel_rm520n_thermal.window"
+#define HISTOGRAM_WINDOW_SLOTS 24      /* Sub-windows of the sliding quantile window */
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+typedef enum {
+    HISTOGRAM_MODEM = 0,
+    HISTOGRAM_AP,
+    HISTOGRAM_PA
+} histogram_sensor_t;
+
+/**
+ * Seconds spent per band (also passed on in the re-exec handoff)
+ */
+typedef struct {
+    uint32_t seconds[HISTOGRAM_SENSORS][HISTOGRAM_BINS];
+} histogram_data_t;
+
+/**
+ * Sliding quantile window (also passed on in the re-exec handoff)
+ *
+ * A slot covers quantile_window / HISTOGRAM_WINDOW_SLOTS seconds, at most
+ * 7 hours, so its per-band counters fit 16 bits.
+ */
+typedef struct {
+    int64_t slot_start;          /* Daemon clock when the current slot began, 0 = empty */
+    int32_t window;              /* quantile_window the slots were filled with (s) */
+    int32_t slot;                /* Index of the current slot */
+    uint16_t seconds[HISTOGRAM_WINDOW_SLOTS][HISTOGRAM_SENSORS][HISTOGRAM_BINS];
+} histogram_window_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Apply histogram options, loading saved counters on the first call
+ *
+ * @param cfg Configuration
+ */
+void histogram_configure(const config_t *cfg);
+
+/**
+ * Account the time since the previous reading to the current bands
+ *
+ * Also writes the live copy and the persistent file when they are due.
+ *
+ * Sensors missing from the response are skipped; 0 °C is a valid reading.
+ *
+ * @param mdeg Sensor readings in m°C, indexed by histogram_sensor_t
+ * @param present Which sensors the response reported
+ */
+void histogram_update(const int mdeg[HISTOGRAM_SENSORS], const bool present[HISTOGRAM_SENSORS]);
+
+/**
+ * Write unsaved counters to the live copy and the persistent file
+ */
+void histogram_close(void);
+
+/**
+ * Counters for a re-exec handoff
+ *
+ * @return Histogram data
+ */
+const histogram_data_t *histogram_data(void);
+
+/**
+ * Take over counters from a previous image
+ *
+ * @param data Histogram handed over by the previous image
+ */
+void histogram_import(const histogram_data_t *data);
+
+/**
+ * Sliding window for a re-exec handoff
+ *
+ * @return Window state
+ */
+const histogram_window_t *histogram_window(void);
+
+/**
+ * Take over the sliding window from a previous image
+ *
+ * Dropped if it was filled with another quantile_window.
+ *
+ * @param window Window handed over by the previous image
+ */
+void histogram_window_import(const histogram_window_t *window);
+
+/**
+ * Time-weighted quantile of one sensor
+ *
+ * @param data Histogram
+ * @param sensor histogram_sensor_t
+ * @param permille Quantile in 1/1000 (e.g. 950 for p95)
+ * @param celsius Filled with the lower edge of the band in °C
+ * @return 0 on success, -1 if the sensor has no samples
+ */
+int histogram_quantile(const histogram_data_t *data, int sensor, int permille, int *celsius);
+
+/**
+ * Arrhenius-weighted time of one sensor
+ *
+ * @param data Histogram
+ * @param sensor histogram_sensor_t
+ * @param ea_mev Activation energy in meV
+ * @param ref_mdeg Reference temperature in m°C
+ * @return Equivalent hours at the reference temperature
+ */
+double histogram_stress(const histogram_data_t *data, int sensor, int ea_mev, int ref_mdeg);
+
+/**
+ * Histogram subcommand - print the saved time-at-temperature counters
+ *
+ * Reads the daemon's live copy (at most HISTOGRAM_LIVE_SAVE seconds old)
+ * or, if the daemon has not written one since boot, the persistent file.
+ * With @window the sliding quantile window is printed instead.
+ *
+ * @param cfg Configuration (persistent file and stress model)
+ * @param window Print the sliding window and its percentiles
+ * @param json Output as JSON
+ * @return 0 on success, 1 if no histogram was found
+ */
+int histogram_mode(const config_t *cfg, bool window, bool json);
+
+#endif /* HISTOGRAM_H */
@@ -0,0 +1,113 @@
+/**
+ * @file history.h
+ * @brief Sample history and compact export declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the sample history. The daemon appends every published
+ * sample to a fixed-size ring in a memory-mapped file in /var/run, and the
+ * history subcommand reads it without talking to the daemon. Every sample
+ * carries a sequence number, which serves as the resumable export cursor.
+ * Its upper bits are a random id of the ring, so a cursor taken before the
+ * ring was recreated (e.g. after a reboot) is recognised as such.
+ *
+ * 'history --export' writes the samples since a cursor as binary chunks
+ * for upload over metered links. Each chunk is
+ *
+ *   "QRH" version    4 bytes, version = HISTORY_EXPORT_VERSION
+ *   length           uint32 LE, bytes of the payload
+ *   payload
+ *   crc              uint32 LE, CRC32 of the payload
+ *
+ * and the payload is a sequence of varints (LEB128; signed values
+ * zigzag-encoded):
+ *
+ *   count, first seq, first timestamp, first temperature (m°C),
+ *   first modem/ap/pa (°C, 0 = missing), first flags,
+ *   min, max and mean temperature (m°C), estimated samples,
+ *   then runs until count samples are described:
+ *   run length, Δseq, Δtimestamp, Δtemperature, Δmodem, Δap, Δpa, flags
+ *
+ * A run repeats the same deltas, so a steady temperature at a fixed
+ * interval costs a few bytes per chunk instead of a record per sample.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HISTORY_FILE            "/var/run/quectel_rm520n_thermal.history"
+#define HISTORY_CHUNK_SAMPLES   256     /* Samples per export chunk */
+#define HISTORY_EXPORT_VERSION  1
+#define HISTORY_FLAG_ESTIMATED  0x01    /* Board-sensor estimate */
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+/**
+ * One sample in the ring
+ */
+typedef struct {
+    uint64_t seq;                /* 0 while the slot is being written */
+    int64_t timestamp;           /* Daemon clock */
+    int32_t temp_mdeg;           /* Published temperature */
+    int8_t sensors[3];           /* modem, ap, pa in °C (0 = missing) */
+    uint8_t flags;               /* HISTORY_FLAG_* */
+} history_record_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Apply the history options, opening or resizing the ring
+ *
+ * An existing ring of the same size is continued, so sequence numbers and
+ * cursors survive daemon restarts. A resized ring starts empty but keeps
+ * its sequence numbers.
+ *
+ * @param cfg Configuration
+ */
+void history_configure(const config_t *cfg);
+
+/**
+ * Append a published sample
+ *
+ * @param temp_mdeg Published temperature in m°C
+ * @param modem_c Modem sensor in °C (0 = missing)
+ * @param ap_c AP sensor in °C (0 = missing)
+ * @param pa_c PA sensor in °C (0 = missing)
+ * @param estimated true for a board-sensor estimate
+ */
+void history_record(int temp_mdeg, int modem_c, int ap_c, int pa_c, bool estimated);
+
+/**
+ * Unmap the ring (the file stays for readers and the next start)
+ */
+void history_close(void);
+
+/**
+ * History subcommand - print or export the samples since a cursor
+ *
+ * The next cursor is printed to stderr as "cursor=<seq>".
+ *
+ * A cursor from an earlier ring or ahead of the history starts at the
+ * oldest sample, with a warning.
+ *
+ * @param since First sequence number to include (0 = oldest available)
+ * @param export Write binary chunks instead of text/JSON
+ * @param json Output as JSON (ignored with export)
+ * @return 0 on success, 1 if no history is available
+ */
+int history_mode(uint64_t since, bool export, bool json);
+
+#endif /* HISTORY_H */
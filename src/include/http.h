@@ -0,0 +1,97 @@
+/**
+ * @file http.h
+ * @brief Local HTTP endpoint declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the daemon's local HTTP endpoint. It serves the latest
+ * sample as Server-Sent Events and as conditional long-poll requests keyed
+ * on the sample sequence number, so dashboards get updates without
+ * spawning the CLI for every poll.
+ */
+
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HTTP_MAX_CLIENTS          16
+#define HTTP_REQUEST_MAX          2048   /* Request line and headers */
+#define HTTP_OUTPUT_MAX           4096   /* Unsent bytes per client before it is dropped */
+#define HTTP_REQUEST_TIMEOUT      5      /* Seconds to receive a complete request */
+#define HTTP_POLL_TIMEOUT         30     /* Default long-poll wait (s) */
+#define HTTP_POLL_TIMEOUT_MAX     300
+#define HTTP_SSE_KEEPALIVE        25     /* Comment line interval on idle streams (s) */
+#define HTTP_SSE_RETRY_MS         5000   /* Reconnect delay advertised to EventSource */
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+/**
+ * Published sample (also passed on in the re-exec handoff)
+ */
+typedef struct {
+    uint64_t seq;                /* Sequence number, 0 = nothing published yet */
+    int64_t timestamp;           /* Daemon clock at publication */
+    int32_t temp_mdeg;           /* Temperature in m°C */
+    int32_t estimated;           /* 1 if a board-sensor estimate */
+} http_sample_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Start listening
+ *
+ * @param listen_spec "unix:<path>", "<path>" or "<loopback address>:<port>";
+ *                    empty disables the endpoint
+ * @return 0 on success or if disabled, -1 on error
+ */
+int http_open(const char *listen_spec);
+
+/**
+ * Stop listening and disconnect all clients
+ */
+void http_close(void);
+
+/**
+ * Check whether the endpoint is listening
+ *
+ * @return true if listening
+ */
+bool http_enabled(void);
+
+/**
+ * Number of connected clients
+ *
+ * @return Open client connections
+ */
+int http_client_count(void);
+
+/**
+ * Publish a new sample to streams and waiting long-poll requests
+ *
+ * @param sample Sample with a new sequence number
+ */
+void http_publish(const http_sample_t *sample);
+
+/**
+ * Serve clients until an absolute CLOCK_MONOTONIC deadline
+ *
+ * Replaces sys_sleep_until() while the endpoint is enabled.
+ *
+ * @param deadline Deadline on the real monotonic clock
+ * @return Wakeup lateness in microseconds, -1 if interrupted by a signal
+ */
+long http_wait_until(const struct timespec *deadline);
+
+#endif /* HTTP_H */
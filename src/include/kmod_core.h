@@ -0,0 +1,52 @@
+/**
+ * @file kmod_core.h
+ * @brief Header for the shared temperature core of the kernel module
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This header defines the state shared by the sysfs, thermal and hwmon
+ * front-ends of the quectel_rm520n_temp module. All front-ends read and
+ * write the same temperature and thresholds through these helpers, so the
+ * three views always agree.
+ */
+
+#ifndef KMOD_CORE_H
+#define KMOD_CORE_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#endif
+
+/**
+ * Module parameters (read-only after load, see /sys/module/quectel_rm520n_temp/parameters/):
+ * - enable_sysfs   - Create /sys/kernel/quectel_rm520n_thermal/ (default: 1)
+ * - enable_thermal - Register the virtual thermal sensor driver (default: 1)
+ * - enable_hwmon   - Register the hwmon device (default: 1)
+ */
+
+#ifdef __KERNEL__
+
+/**
+ * enum quectel_threshold - Temperature thresholds held by the core
+ */
+enum quectel_threshold {
+	QUECTEL_TEMP_MIN,
+	QUECTEL_TEMP_MAX,
+	QUECTEL_TEMP_CRIT,
+	QUECTEL_TEMP_DEFAULT,
+};
+
+/* Shared core (core.c) */
+int quectel_core_parse(const char *buf, size_t count, int *value);
+int quectel_core_get_temp(void);
+int quectel_core_set_temp(int value);
+int quectel_core_get_threshold(enum quectel_threshold which);
+int quectel_core_set_threshold(enum quectel_threshold which, int value);
+bool quectel_core_get_estimated(void);
+void quectel_core_set_estimated(bool estimated);
+void quectel_core_get_stats(unsigned long *updates, unsigned long *update_time, bool *estimated);
+
+#endif /* __KERNEL__ */
+
+#endif /* KMOD_CORE_H */
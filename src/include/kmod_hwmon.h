@@ -1,13 +1,13 @@
 /**
  * @file kmod_hwmon.h
- * @brief Header for hwmon temperature sensor kernel module
+ * @brief Header for the hwmon temperature sensor front-end
  * @author Christopher Sollinger
  * @date 2025
  * @license GPL
  *
- * This header defines the interface for the hwmon kernel module
- * that integrates Quectel RM520N temperature monitoring with the
- * Linux hwmon subsystem.
+ * This header defines the interface for the hwmon front-end of the
+ * quectel_rm520n_temp module that integrates Quectel RM520N temperature
+ * monitoring with the Linux hwmon subsystem.
  */
 
 #ifndef KMOD_HWMON_H
@@ -16,11 +16,10 @@
 #ifdef __KERNEL__
 #include <linux/hwmon.h>
 #include <linux/platform_device.h>
-#include <linux/mutex.h>
 #endif
 
 /**
- * Hwmon integration features:
+ * Hwmon integration features (module parameter enable_hwmon):
  * - Device name: quectel_rm520n_thermal
  * - Attributes exported via standard hwmon interface:
  *   * temp1_input (r)  - Current temperature in m°C
@@ -29,33 +28,17 @@
  *   * temp1_crit  (rw) - Critical threshold in m°C
  *
  * Synchronization:
- * - Reads thresholds from /sys/kernel/quectel_rm520n_thermal/ on probe
- * - Uses mutex for thread-safe operations
+ * - Temperature and thresholds live in the shared core, so they always
+ *   match /sys/kernel/quectel_rm520n_thermal/
  * - Supports Device Tree and fallback platform device
  */
 
 #ifdef __KERNEL__
 
-/**
- * struct quectel_hwmon_data - Private data for hwmon device
- * @lock: Mutex for thread-safe access
- * @temp: Current temperature in millidegrees Celsius
- * @temp_min: Minimum temperature threshold in m°C
- * @temp_max: Maximum temperature threshold in m°C
- * @temp_crit: Critical temperature threshold in m°C
- *
- * This structure holds the runtime state of the hwmon device.
- */
-struct quectel_hwmon_data {
-	struct mutex lock;
-	int temp;
-	int temp_min;
-	int temp_max;
-	int temp_crit;
-};
+/* Front-end lifecycle, called from core.c */
+int quectel_hwmon_init(void);
+void quectel_hwmon_exit(void);
 
 #endif /* __KERNEL__ */
 
-/* Module does not export any public functions */
-
 #endif /* KMOD_HWMON_H */
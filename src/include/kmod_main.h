@@ -1,12 +1,12 @@
 /**
  * @file kmod_main.h
- * @brief Header for sysfs temperature interface kernel module
+ * @brief Header for the sysfs temperature front-end
  * @author Christopher Sollinger
  * @date 2025
  * @license GPL
  *
- * This header defines the interface for the main sysfs kernel module
- * that provides /sys/kernel/quectel_rm520n_thermal/ interface.
+ * This header defines the interface for the sysfs front-end of the
+ * quectel_rm520n_temp module that provides /sys/kernel/quectel_rm520n_thermal/.
  */
 
 #ifndef KMOD_MAIN_H
@@ -18,15 +18,22 @@
 #endif
 
 /**
- * Sysfs paths exported by this module:
+ * Sysfs paths exported by this front-end (module parameter enable_sysfs):
  * - /sys/kernel/quectel_rm520n_thermal/temp        (rw) - Current temperature in m°C
  * - /sys/kernel/quectel_rm520n_thermal/temp_min    (rw) - Minimum threshold in m°C
  * - /sys/kernel/quectel_rm520n_thermal/temp_max    (rw) - Maximum threshold in m°C
  * - /sys/kernel/quectel_rm520n_thermal/temp_crit   (rw) - Critical threshold in m°C
  * - /sys/kernel/quectel_rm520n_thermal/temp_default (rw) - Default temperature in m°C
- * - /sys/kernel/quectel_rm520n_thermal/stats       (r)  - Statistics (total_updates, last_update_time)
+ * - /sys/kernel/quectel_rm520n_thermal/temp_source (rw) - "modem" or "estimated" (board sensor fallback)
+ * - /sys/kernel/quectel_rm520n_thermal/stats       (r)  - Statistics (total_updates, last_update_time, source)
  */
 
-/* Module does not export any public functions */
+#ifdef __KERNEL__
+
+/* Front-end lifecycle, called from core.c */
+int quectel_sysfs_init(void);
+void quectel_sysfs_exit(void);
+
+#endif /* __KERNEL__ */
 
 #endif /* KMOD_MAIN_H */
@@ -1,12 +1,13 @@
 /**
  * @file kmod_sensor.h
- * @brief Header for virtual thermal sensor kernel module
+ * @brief Header for the virtual thermal sensor front-end
  * @author Christopher Sollinger
  * @date 2025
  * @license GPL
  *
- * This header defines the interface for the thermal sensor kernel module
- * that registers a virtual thermal zone with the Linux Thermal Framework.
+ * This header defines the interface for the thermal sensor front-end of the
+ * quectel_rm520n_temp module that registers a virtual thermal zone with the
+ * Linux Thermal Framework.
  */
 
 #ifndef KMOD_SENSOR_H
@@ -18,14 +19,14 @@
 #endif
 
 /**
- * Thermal zone integration features:
+ * Thermal zone integration features (module parameter enable_thermal):
  * - Registers virtual thermal zone with Linux Thermal Framework
  * - Provides temperature data to thermal subsystem
  * - Supports system-wide thermal management and fan control
  * - Device Tree compatible with fallback platform device support
  *
  * Thermal Zone Operations:
- * - get_temp: Read current temperature from sysfs
+ * - get_temp: Read current temperature from the shared core
  * - get_trip_type: Report trip point types (passive, hot, critical)
  * - get_trip_temp: Report trip point temperatures
  * - set_trip_temp: Update trip point temperatures (configurable)
@@ -36,20 +37,13 @@
 
 #ifdef __KERNEL__
 
-/**
- * struct quectel_sensor_data - Private data for thermal sensor
- * @dev: Pointer to platform device
- * @tz: Pointer to thermal zone device
- *
- * This structure holds the runtime state of the thermal sensor.
- */
-struct quectel_sensor_data {
-	struct device *dev;
-	struct thermal_zone_device *tz;
-};
+/* Front-end lifecycle, called from core.c */
+int quectel_sensor_init(void);
+void quectel_sensor_exit(void);
 
-#endif /* __KERNEL__ */
+/* Push a core temperature update to the registered zone, if any */
+void quectel_sensor_notify(void);
 
-/* Module does not export any public functions */
+#endif /* __KERNEL__ */
 
 #endif /* KMOD_SENSOR_H */
@@ -7,6 +7,11 @@
  *
  * This header provides a lightweight wrapper around OpenWRT's ulog
  * library for consistent logging across daemon and CLI tools.
+ *
+ * The daemon can optionally route messages through an asynchronous
+ * backend (logging.c): messages are queued in a bounded ring and written
+ * by a separate thread, and a full ring drops messages instead of
+ * blocking the caller.
  */
 
 #ifndef LOGGING_H
@@ -16,6 +21,64 @@
 #include <syslog.h>
 #include <stdbool.h>
 
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define LOGGING_QUEUE_SLOTS     256             /* Queued messages (async) */
+#define LOGGING_MSG_LEN         256             /* Bytes per queued message */
+#define LOGGING_WRITER_STACK    (64 * 1024)     /* Writer thread stack size */
+#define LOGGING_STOP_TIMEOUT_MS 1000            /* Drain time on stop before dropping */
+
+/* ============================================================================
+ * ASYNCHRONOUS BACKEND (logging.c)
+ * ============================================================================ */
+
+/* true while messages are routed through the writer thread */
+extern bool logging_async_active;
+
+/**
+ * Set the lowest priority that is logged (sync and async)
+ *
+ * @param threshold syslog priority (LOG_DEBUG ... LOG_ERR)
+ */
+void logging_set_threshold(int threshold);
+
+/**
+ * Queue a message for the writer thread; drops it if the queue is full
+ *
+ * @param priority syslog priority
+ * @param fmt printf-style format
+ */
+void logging_enqueue(int priority, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Start the writer thread and route messages through the queue
+ *
+ * @return 0 on success, -1 on error (logging stays synchronous)
+ */
+int logging_async_start(void);
+
+/**
+ * Write the queued messages, stop the writer thread and log synchronously
+ *
+ * Messages that cannot be written within LOGGING_STOP_TIMEOUT_MS are
+ * dropped.
+ */
+void logging_async_stop(void);
+
+/**
+ * Number of messages dropped because the queue was full
+ *
+ * @return Dropped messages since start
+ */
+unsigned long logging_async_dropped(void);
+
+/* ============================================================================
+ * SYNCHRONOUS INTERFACE
+ * ============================================================================ */
+
 /**
  * Initialize logging system
  *
@@ -37,11 +100,7 @@ static inline void logging_init(bool use_syslog, bool use_stderr, bool debug, co
 
     ulog_open(channels, LOG_DAEMON, ident);
 
-    if (debug) {
-        ulog_threshold(LOG_DEBUG);
-    } else {
-        ulog_threshold(LOG_INFO);
-    }
+    logging_set_threshold(debug ? LOG_DEBUG : LOG_INFO);
 }
 
 /**
@@ -57,10 +116,22 @@ static inline void logging_cleanup(void)
 #define ULOG_DBG(fmt, ...) ulog(LOG_DEBUG, fmt "\n", ##__VA_ARGS__)
 #endif
 
-/* Convenience macros mapping to ulog */
-#define logging_debug(fmt, ...)   ULOG_DBG(fmt, ##__VA_ARGS__)
-#define logging_info(...)         ULOG_INFO(__VA_ARGS__)
-#define logging_warning(...)      ULOG_WARN(__VA_ARGS__)
-#define logging_error(...)        ULOG_ERR(__VA_ARGS__)
+/* Convenience macros mapping to ulog, or to the queue when async is active */
+#define logging_debug(fmt, ...) do { \
+        if (logging_async_active) logging_enqueue(LOG_DEBUG, fmt, ##__VA_ARGS__); \
+        else ULOG_DBG(fmt, ##__VA_ARGS__); \
+    } while (0)
+#define logging_info(...) do { \
+        if (logging_async_active) logging_enqueue(LOG_INFO, __VA_ARGS__); \
+        else ULOG_INFO(__VA_ARGS__); \
+    } while (0)
+#define logging_warning(...) do { \
+        if (logging_async_active) logging_enqueue(LOG_WARNING, __VA_ARGS__); \
+        else ULOG_WARN(__VA_ARGS__); \
+    } while (0)
+#define logging_error(...) do { \
+        if (logging_async_active) logging_enqueue(LOG_ERR, __VA_ARGS__); \
+        else ULOG_ERR(__VA_ARGS__); \
+    } while (0)
 
 #endif /* LOGGING_H */
@@ -0,0 +1,121 @@
+/**
+ * @file recovery.h
+ * @brief Modem recovery ladder declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the modem recovery ladder. While the modem cannot be
+ * read, the daemon escalates through increasingly drastic steps, each with
+ * its own timeout:
+ *
+ *   reopen   close and reopen the AT ports
+ *   reset    AT+CFUN=1,1 through another AT port (modem reboot)
+ *   usb      unbind and rebind the modem's USB device (usb_device)
+ *   power    switch the modem's power GPIO off and on (power_gpio)
+ *
+ * Steps without configuration are skipped. If the last step times out,
+ * the ladder starts over with doubled timeouts (up to one hour), so the
+ * daemon keeps trying instead of exiting.
+ */
+
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <stdint.h>
+#include "config.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define RECOVERY_TRIGGER_FAILURES  4       /* Failed samples before the ladder starts */
+#define RECOVERY_RETRY_SEC         5       /* Port retry delay while a step is in progress */
+#define RECOVERY_RESET_COMMAND     "AT+CFUN=1,1\r"
+#define RECOVERY_USB_OFF_SEC       2       /* Time the USB device stays unbound */
+#define RECOVERY_POWER_OFF_SEC     5       /* Time the modem stays powered off */
+#define RECOVERY_TIMEOUT_MAX       3600    /* Cap for step timeouts doubled per round */
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+typedef enum {
+    RECOVERY_NONE = 0,           /* Modem answering */
+    RECOVERY_REOPEN,
+    RECOVERY_RESET,
+    RECOVERY_USB,
+    RECOVERY_POWER,
+    RECOVERY_STEPS
+} recovery_step_t;
+
+/**
+ * Ladder state and per-step counters (also the re-exec handoff)
+ */
+typedef struct {
+    int32_t step;                /* recovery_step_t in progress */
+    int32_t failures;            /* Failed samples in the current outage */
+    int32_t round;               /* Completed ladders in the current outage */
+    int32_t reserved;
+    int64_t outage_start;        /* Daemon clock of the first failure, 0 = none */
+    int64_t deadline;            /* Daemon clock when the current step expires */
+    int64_t last_outage;         /* Duration of the last recovered outage (s) */
+    uint32_t attempts[RECOVERY_STEPS];   /* Times each step was taken */
+    uint32_t recovered[RECOVERY_STEPS];  /* Outages that ended during each step */
+} recovery_state_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Apply the per-step timeouts and the USB/GPIO recovery targets
+ *
+ * @param cfg Configuration
+ */
+void recovery_configure(const config_t *cfg);
+
+/**
+ * Account a sample the modem could not deliver, escalating when due
+ *
+ * Starts the ladder after RECOVERY_TRIGGER_FAILURES failures and moves to
+ * the next step once the current one has timed out.
+ */
+void recovery_failure(void);
+
+/**
+ * Account a successful modem read, ending an outage
+ */
+void recovery_success(void);
+
+/**
+ * Limit a retry delay while a step is in progress
+ *
+ * During a step, ports are retried at least every RECOVERY_RETRY_SEC and
+ * never later than the step deadline.
+ *
+ * @param delay Wanted delay in seconds
+ * @return Delay in seconds (at least 1)
+ */
+int recovery_delay(int delay);
+
+/**
+ * Log the per-step counters
+ */
+void recovery_log_stats(void);
+
+/**
+ * Ladder state for a re-exec handoff
+ *
+ * @return Pointer to the internal state
+ */
+recovery_state_t *recovery_state(void);
+
+/**
+ * Continue the ladder of a previous image
+ *
+ * @param state State handed over by the previous image
+ */
+void recovery_import(const recovery_state_t *state);
+
+#endif /* RECOVERY_H */
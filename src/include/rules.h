@@ -0,0 +1,87 @@
+/**
+ * @file rules.h
+ * @brief Reaction rule engine declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the daemon's reaction rules. Rules are defined as UCI
+ * 'rule' sections and evaluated incrementally on every sample with constant
+ * state per rule (time above threshold, smoothed rate of change, matching
+ * samples in a sliding window). A rule that fires runs its action as an
+ * asynchronous child process, so the sampling loop never waits for it.
+ */
+
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include "config.h"
+#include "handoff.h"
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+/**
+ * One sample as seen by the rules
+ */
+typedef struct {
+    int temp_mdeg;               /* Published temperature */
+    int modem_mdeg;              /* AT+QTEMP sensors, each only valid if its has_ flag is set */
+    int ap_mdeg;
+    int pa_mdeg;
+    bool has_modem;              /* Sensor was in the response (all false for estimates) */
+    bool has_ap;
+    bool has_pa;
+    bool estimated;
+} rules_sample_t;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Apply the configured rules
+ *
+ * State of rules whose definition did not change is kept, so reloading the
+ * configuration neither re-fires active rules nor resets their cooldown.
+ *
+ * @param cfg Configuration with the rule list
+ */
+void rules_configure(const config_t *cfg);
+
+/**
+ * Evaluate all rules on a new sample
+ *
+ * @param sample Sample values
+ */
+void rules_evaluate(const rules_sample_t *sample);
+
+/**
+ * Reap finished actions without blocking
+ */
+void rules_reap(void);
+
+/**
+ * Log per-rule firing counters
+ */
+void rules_log_stats(void);
+
+/**
+ * Describe rule state for a re-exec handoff
+ *
+ * @param state Filled with per-rule state
+ */
+void rules_export(handoff_rules_t *state);
+
+/**
+ * Take over rule state from a previous image
+ *
+ * State is matched by rule name; rules that no longer exist are dropped.
+ *
+ * @param state Rule state handed over by the previous image
+ */
+void rules_import(const handoff_rules_t *state);
+
+#endif /* RULES_H */
@@ -7,18 +7,82 @@
  * 
  * This header provides common serial communication functions used by
  * both the daemon and CLI tools for AT command communication.
+ *
+ * Besides local ttys, a port can be a network endpoint exported by a
+ * serial server such as ser2net:
+ *
+ *   tcp://host:port[?options]       raw TCP, bytes passed through
+ *   rfc2217://host:port[?options]   Telnet with the COM port option
+ *
+ * Options are comma-separated: timeout=<s> (AT response timeout) and
+ * connect=<s> (connect and negotiation timeout). IPv6 hosts are written
+ * in brackets.
  */
 
 #ifndef SERIAL_H
 #define SERIAL_H
 
+#include <stdbool.h>
 #include <sys/types.h>
 #include <termios.h>
 
+/* Network endpoints */
+#define SERIAL_SCHEME_TCP            "tcp://"
+#define SERIAL_SCHEME_RFC2217        "rfc2217://"
+#define SERIAL_NET_MAX               8    /* Open network endpoints per process */
+#define SERIAL_NET_CONNECT_TIMEOUT   3    /* Default connect timeout (s) */
+#define SERIAL_NET_TIMEOUT_MAX       60   /* Upper limit of timeout= and connect= (s) */
+
+typedef enum {
+    SERIAL_TRANSPORT_TTY = 0,
+    SERIAL_TRANSPORT_TCP,
+    SERIAL_TRANSPORT_RFC2217
+} serial_transport_t;
+
+/**
+ * Parsed network endpoint
+ */
+typedef struct {
+    serial_transport_t transport;
+    char host[64];
+    char service[8];             /* TCP port */
+    int timeout;                 /* AT response timeout (s) */
+    int connect_timeout;         /* Connect and negotiation timeout (s) */
+} serial_endpoint_t;
+
 /* Function declarations */
 int init_serial_port(const char *port, speed_t baud_rate);
 int read_modem_response(int fd, char *buf, size_t buflen);
 int send_at_command(int fd, const char *command, char *response, size_t response_len);
 int close_serial_port(int fd);
 
+/**
+ * Check whether a port names a network endpoint
+ *
+ * @param port Port as configured
+ * @return true for tcp:// and rfc2217:// ports
+ */
+bool serial_is_network(const char *port);
+
+/**
+ * Parse a network endpoint
+ *
+ * @param port Port as configured
+ * @param ep Filled with the endpoint
+ * @return 0 on success, -1 if the port is not a valid network endpoint
+ */
+int serial_parse_endpoint(const char *port, serial_endpoint_t *ep);
+
+/**
+ * Register a descriptor inherited from a previous image (re-exec)
+ *
+ * Network connections need their transport and timeouts restored; local
+ * ttys need nothing.
+ *
+ * @param fd Inherited descriptor
+ * @param port Port the descriptor belongs to
+ * @return 0 on success, -1 if the endpoint cannot be registered
+ */
+int serial_adopt(int fd, const char *port);
+
 #endif /* SERIAL_H */
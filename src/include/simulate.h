@@ -0,0 +1,57 @@
+/**
+ * @file simulate.h
+ * @brief Offline thermal policy simulator declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the simulate subcommand, which replays a recorded
+ * temperature trace through a model of the thermal zone trip table and
+ * governor so candidate trips and hysteresis can be compared offline.
+ */
+
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+#include <stdbool.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define SIMULATE_MAX_TRIPS         8
+#define SIMULATE_DEFAULT_TRIPS     "65,70,75"   /* Active trips of the overlay example (°C) */
+#define SIMULATE_DEFAULT_HYST      "5"          /* Hysteresis of the overlay example (°C) */
+#define SIMULATE_DEFAULT_GOVERNOR  "step_wise"
+#define SIMULATE_MAX_GAP           600          /* Seconds between samples counted as a gap */
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Simulate mode - replay a temperature trace through a thermal policy
+ *
+ * The trace has one sample per line, either "<epoch> <temp>" (space, tab
+ * or comma separated) or just "<temp>" at the UCI interval. Temperatures
+ * are °C, or m°C if above 1000. Empty lines and lines starting with '#'
+ * are skipped.
+ *
+ * Each active trip i drives cooling state i+1 of one cooling device, as
+ * in quectel_rm520n_thermal_overlay.dts.example. The report lists the time
+ * spent above each trip and above the UCI temp_max/temp_crit thresholds,
+ * the cooling state changes, the time per cooling state and the mean fan
+ * duty, assuming the duty grows linearly with the cooling state.
+ *
+ * @param trace Trace file, or "-" for stdin
+ * @param trips Comma separated trip temperatures in °C, each optionally
+ *              followed by ":<hysteresis>" (NULL = overlay example)
+ * @param hysteresis Default hysteresis in °C (NULL = overlay example)
+ * @param governor "step_wise" or "bang_bang" (NULL = step_wise)
+ * @param json Output the report as JSON
+ * @return 0 on success, 1 if the trace cannot be read, 2 on invalid policy
+ */
+int simulate_mode(const char *trace, const char *trips, const char *hysteresis,
+                  const char *governor, bool json);
+
+#endif /* SIMULATE_H */
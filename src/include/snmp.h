@@ -0,0 +1,40 @@
+/**
+ * @file snmp.h
+ * @brief SNMP pass_persist helper declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the snmp subcommand. snmpd starts it once as a
+ * pass_persist helper and sends get/getnext requests over stdin; the
+ * answers come from the daemon's sysfs interface and state file, so a
+ * walk costs file reads instead of one CLI fork per OID.
+ */
+
+#ifndef SNMP_H
+#define SNMP_H
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+/* NET-SNMP-MIB::netSnmpPlaypen, RM520N subtree */
+#define SNMP_BASE_OID       ".1.3.6.1.4.1.8072.9999.9999.520"
+#define SNMP_MAX_OID_LEN    32      /* Sub-identifiers per OID */
+#define SNMP_CACHE_SEC      1       /* Seconds a snapshot serves a walk */
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * SNMP subcommand - serve the pass_persist protocol on stdin/stdout
+ *
+ * Answers PING, get, getnext and set (always not-writable) until stdin
+ * is closed or an empty line is received.
+ *
+ * @return 0 on normal exit
+ */
+int snmp_mode(void);
+
+#endif /* SNMP_H */
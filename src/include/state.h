@@ -0,0 +1,64 @@
+/**
+ * @file state.h
+ * @brief Published daemon state declarations
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * Header file for the daemon's state file. Values derived by the daemon
+ * (such as the thermal headroom) are published as key=value lines in
+ * /var/run/quectel_rm520n_thermal.state, rewritten atomically and only when
+ * a value changed. Policy scripts can source the file or watch it instead
+ * of polling the CLI and recomputing.
+ */
+
+#ifndef STATE_H
+#define STATE_H
+
+#include <stddef.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define STATE_FILE       "/var/run/quectel_rm520n_thermal.state"
+#define STATE_MAX_KEYS   48
+#define STATE_KEY_LEN    32
+#define STATE_VALUE_LEN  64
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+/**
+ * Set a published value
+ *
+ * Values are shell-safe words; the file is only marked for rewriting if
+ * the value changed.
+ *
+ * @param key Key name ([a-z0-9_])
+ * @param fmt printf-style format of the value
+ */
+void state_set(const char *key, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * Write the state file if a value changed since the last write
+ */
+void state_flush(void);
+
+/**
+ * Remove the state file (daemon shutdown)
+ */
+void state_remove(void);
+
+/**
+ * Look up a value in the state file
+ *
+ * @param key Key name
+ * @param value Buffer for the value
+ * @param size Size of the buffer
+ * @return 0 on success, -1 if the file or key does not exist
+ */
+int state_read(const char *key, char *value, size_t size);
+
+#endif /* STATE_H */
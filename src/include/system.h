@@ -14,6 +14,12 @@
 
 #include <signal.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 /* ============================================================================
  * FUNCTION DECLARATIONS
@@ -60,6 +66,8 @@ void release_daemon_lock(void);
  * 
  * Handles SIGTERM and SIGINT signals to ensure graceful daemon shutdown.
  * Sets shutdown flag and logs the event for proper service management.
+ * SIGHUP requests a re-exec of the daemon with state handoff, SIGUSR1 only
+ * wakes the daemon to re-check its pause state.
  * 
  * Following clig.dev guidelines for signal handling and graceful
  * shutdown procedures.
@@ -74,6 +82,269 @@ void signal_handler(int sig);
  */
 extern volatile sig_atomic_t shutdown_requested;
 
+/**
+ * Global re-exec flag, set by SIGHUP in daemon mode
+ */
+extern volatile sig_atomic_t reexec_requested;
+
+/**
+ * Get the daemon lock file descriptor (for re-exec handoff)
+ *
+ * @return Lock file descriptor, -1 if the lock is not held
+ */
+int get_daemon_lock_fd(void);
+
+/**
+ * Adopt a daemon lock inherited from a previous image
+ *
+ * Verifies that the descriptor still holds the exclusive lock. The PID
+ * file stays valid since exec() keeps the process ID.
+ *
+ * @param fd Inherited lock file descriptor
+ * @return 0 on success, -1 if the descriptor does not hold the lock
+ */
+int adopt_daemon_lock(int fd);
+
+/* ============================================================================
+ * DAEMON PAUSE FUNCTIONS
+ * ============================================================================ */
+
+/*
+ * Tools that need exclusive access to the modem (e.g. bench) write their
+ * PID to /var/run/quectel_rm520n_temp.pause. The daemon then closes the
+ * serial port, keeps publishing board-sensor estimates and acknowledges by
+ * creating /var/run/quectel_rm520n_temp.paused. SIGUSR1 wakes the daemon
+ * so it reacts within milliseconds; a pause file left behind by a crashed
+ * holder is ignored.
+ */
+
+/**
+ * Ask a running daemon to release the serial port
+ *
+ * @param timeout_sec Seconds to wait for the daemon's acknowledgement
+ * @return 0 if the daemon paused (or is not running), -1 on failure
+ */
+int request_daemon_pause(int timeout_sec);
+
+/**
+ * Let a paused daemon resume sampling
+ */
+void release_daemon_pause(void);
+
+/**
+ * Check whether a live process asked the daemon to pause
+ *
+ * @return 1 if the daemon should pause, 0 otherwise
+ */
+int daemon_pause_requested(void);
+
+/**
+ * Acknowledge or clear the daemon's paused state
+ *
+ * @param paused Non-zero once the serial port has been released
+ */
+void set_daemon_paused(int paused);
+
+/* ============================================================================
+ * FILESYSTEM ROOT FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * sys_root - Get the filesystem root prefix
+ *
+ * Returns the value of the QUECTEL_ROOT environment variable (without
+ * trailing slash), or an empty string if unset. Every absolute path the
+ * tool touches (/sys, /proc, /dev, /var/run, /etc/config) is resolved
+ * below this prefix, so the daemon, CLI and config flow can run
+ * unprivileged against a fake tree in a temporary directory.
+ *
+ * @return Root prefix (never NULL)
+ */
+const char *sys_root(void);
+
+/**
+ * sys_path - Resolve an absolute path below the filesystem root prefix
+ * @buf: Buffer to store the resolved path
+ * @size: Size of the buffer
+ * @path: Absolute path as seen on a real system (relative paths are kept)
+ *
+ * @return 0 on success, -1 on truncation
+ */
+int sys_path(char *buf, size_t size, const char *path);
+
+/*
+ * Root-aware wrappers for the libc calls used on system paths. They take
+ * the logical path (e.g. "/sys/class/hwmon") and behave like their libc
+ * counterparts; on truncation they fail with ENAMETOOLONG.
+ */
+
+/**
+ * sys_fopen - fopen() a path below the filesystem root prefix
+ * @path: Logical path (relative paths are not re-rooted)
+ * @mode: fopen() mode
+ *
+ * @return Stream, or NULL on error (errno set)
+ */
+FILE *sys_fopen(const char *path, const char *mode);
+
+/**
+ * sys_opendir - opendir() a path below the filesystem root prefix
+ * @path: Logical path (relative paths are not re-rooted)
+ *
+ * @return Directory stream, or NULL on error (errno set)
+ */
+DIR *sys_opendir(const char *path);
+
+/**
+ * sys_open - open() a path below the filesystem root prefix
+ * @path: Logical path (relative paths are not re-rooted)
+ * @flags: open() flags
+ * @mode: Permissions for O_CREAT
+ *
+ * @return File descriptor, or -1 on error (errno set)
+ */
+int sys_open(const char *path, int flags, mode_t mode);
+
+/**
+ * sys_access - access() a path below the filesystem root prefix
+ * @path: Logical path (relative paths are not re-rooted)
+ * @mode: access() mode (F_OK, R_OK, W_OK, X_OK)
+ *
+ * @return 0 if access is permitted, -1 otherwise (errno set)
+ */
+int sys_access(const char *path, int mode);
+
+/**
+ * sys_stat - stat() a path below the filesystem root prefix
+ * @path: Logical path (relative paths are not re-rooted)
+ * @st: Filled with the file status
+ *
+ * @return 0 on success, -1 on error (errno set)
+ */
+int sys_stat(const char *path, struct stat *st);
+
+/**
+ * sys_unlink - unlink() a path below the filesystem root prefix
+ * @path: Logical path (relative paths are not re-rooted)
+ *
+ * @return 0 on success, -1 on error (errno set)
+ */
+int sys_unlink(const char *path);
+
+/**
+ * sys_chmod - chmod() a path below the filesystem root prefix
+ * @path: Logical path (relative paths are not re-rooted)
+ * @mode: New permissions
+ *
+ * @return 0 on success, -1 on error (errno set)
+ */
+int sys_chmod(const char *path, mode_t mode);
+
+/**
+ * sys_rename - rename() between paths below the filesystem root prefix
+ * @oldpath: Logical source path (relative paths are not re-rooted)
+ * @newpath: Logical destination path
+ *
+ * @return 0 on success, -1 on error (errno set)
+ */
+int sys_rename(const char *oldpath, const char *newpath);
+
+/* ============================================================================
+ * CLOCK FUNCTIONS
+ * ============================================================================ */
+
+#define SYS_TIME_SCALE_MAX 100000   /* Upper bound for QUECTEL_TIME_SCALE */
+
+/**
+ * sys_time_scale - Get the clock acceleration factor
+ *
+ * Returns QUECTEL_TIME_SCALE (1..SYS_TIME_SCALE_MAX). The variable is only
+ * honoured together with QUECTEL_ROOT, so a production daemon always runs
+ * on the real clock.
+ *
+ * @return Acceleration factor (1 = real time)
+ */
+unsigned int sys_time_scale(void);
+
+/**
+ * sys_time - Current time on the daemon clock
+ *
+ * Equivalent to time(NULL) at scale 1. When accelerated, time advances
+ * scale times faster than the monotonic clock, starting from the wall time
+ * of the first call.
+ *
+ * @return Seconds since the epoch on the (possibly virtual) clock
+ */
+time_t sys_time(void);
+
+/**
+ * sys_sleep - Sleep on the daemon clock
+ * @seconds: Seconds to sleep on the (possibly virtual) clock
+ *
+ * Like sleep(), returns early when interrupted by a signal.
+ */
+void sys_sleep(unsigned int seconds);
+
+/**
+ * sys_sleep_until - Sleep until an absolute CLOCK_MONOTONIC deadline
+ * @deadline: Deadline on the real monotonic clock
+ *
+ * @return Wakeup lateness in microseconds, -1 if interrupted by a signal
+ */
+long sys_sleep_until(const struct timespec *deadline);
+
+/**
+ * sys_real_usec - Convert a daemon clock duration to real microseconds
+ * @usec: Duration on the (possibly virtual) clock
+ *
+ * @return Duration in real microseconds (at least 1 for non-zero input)
+ */
+int64_t sys_real_usec(int64_t usec);
+
+/* ============================================================================
+ * REAL-TIME SCHEDULING FUNCTIONS
+ * ============================================================================ */
+
+#define SYS_PREFAULT_STACK (64 * 1024)  /* Stack pre-faulted in real-time mode */
+
+/**
+ * sys_set_realtime - Switch the process in or out of real-time mode
+ * @enable: Non-zero for SCHED_FIFO + mlockall, zero to restore SCHED_OTHER
+ * @priority: SCHED_FIFO priority (1-99)
+ * @cpu_mask: CPU affinity mask (bit N = CPU N, 0 = all CPUs)
+ *
+ * Real-time mode locks all current and future pages and pre-faults
+ * SYS_PREFAULT_STACK bytes of stack, so sampling never waits for page
+ * faults. Children do not inherit the real-time policy. Individual steps
+ * that fail (e.g. missing CAP_SYS_NICE) are logged and skipped.
+ *
+ * @return 0 if all steps succeeded, -1 otherwise
+ */
+int sys_set_realtime(int enable, int priority, unsigned long cpu_mask);
+
+/* ============================================================================
+ * RESOURCE MONITORING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Process resource usage snapshot
+ */
+typedef struct {
+    int open_fds;                /* Entries in /proc/self/fd */
+    long rss_kb;                 /* VmRSS from /proc/self/status */
+    unsigned long cpu_ms;        /* User + system CPU time */
+} sys_resources_t;
+
+/**
+ * sys_resource_usage - Sample the resource usage of the current process
+ * @res: Snapshot to fill in (fields that cannot be read are set to -1/0)
+ *
+ * Always reads the real /proc/self, independent of QUECTEL_ROOT.
+ *
+ * @return 0 on success, -1 if nothing could be read
+ */
+int sys_resource_usage(sys_resources_t *res);
+
 /* ============================================================================
  * HWMON DISCOVERY FUNCTIONS
  * ============================================================================ */
@@ -58,4 +58,16 @@ int extract_temp_values(const char *response, int *modem_temp, int *ap_temp, int
  */
 int select_best_temperature(int modem_temp, int ap_temp, int pa_temp, int *result_mdeg);
 
+/**
+ * Check whether a sensor has a value in the AT+QTEMP response
+ *
+ * extract_temp_values() reports a missing sensor as 0°C; this tells it
+ * apart from a genuine 0°C reading.
+ *
+ * @param response AT command response string
+ * @param prefix Sensor prefix (e.g., "modem-ambient-usr")
+ * @return 1 if the sensor has a value, 0 otherwise
+ */
+int temp_sensor_present(const char *response, const char *prefix);
+
 #endif /* TEMPERATURE_H */
@@ -0,0 +1,349 @@
+/**
+ * @file core.c
+ * @brief Shared temperature core and module entry for Quectel RM520N
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file holds the temperature, thresholds and statistics shared by the
+ * sysfs, thermal and hwmon front-ends, and loads the front-ends selected by
+ * the enable_sysfs, enable_thermal and enable_hwmon module parameters.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/jiffies.h>
+
+#include "../include/common.h"
+#include "../include/kmod_core.h"
+#include "../include/kmod_main.h"
+#include "../include/kmod_sensor.h"
+#include "../include/kmod_hwmon.h"
+
+/* ===== MODULE PARAMETERS ===== */
+
+static bool enable_sysfs = true;
+module_param(enable_sysfs, bool, 0444);
+MODULE_PARM_DESC(enable_sysfs, "Create /sys/kernel/quectel_rm520n_thermal (default: 1)");
+
+static bool enable_thermal = true;
+module_param(enable_thermal, bool, 0444);
+MODULE_PARM_DESC(enable_thermal, "Register the virtual thermal sensor driver (default: 1)");
+
+static bool enable_hwmon = true;
+module_param(enable_hwmon, bool, 0444);
+MODULE_PARM_DESC(enable_hwmon, "Register the hwmon device (default: 1)");
+
+/* ===== SHARED STATE ===== */
+
+/* Temperature threshold storage (in m°C) */
+static int temp_min = DEFAULT_TEMP_MIN;
+static int temp_max = DEFAULT_TEMP_MAX;
+static int temp_crit = DEFAULT_TEMP_CRIT;
+static int temp_default = DEFAULT_TEMP_DEFAULT;
+
+/* Current temperature value in m°C */
+static int modem_temp = DEFAULT_TEMP_DEFAULT;
+
+/* Set when the current value is a board-sensor estimate, not a modem reading */
+static bool temp_estimated = false;
+
+/* Statistics counters */
+static unsigned long total_updates = 0;
+static unsigned long last_update_time = 0;
+
+/* Mutex for thread-safe access to temperature data */
+static DEFINE_MUTEX(temp_lock);
+
+/* ===== CORE ACCESSORS ===== */
+
+/**
+ * quectel_core_parse - Parse a temperature value written by userspace
+ * @buf: Input buffer
+ * @count: Number of characters in input buffer
+ * @value: Parsed value in m°C
+ *
+ * Return: 0 on success, -EINVAL on error
+ */
+int quectel_core_parse(const char *buf, size_t count, int *value)
+{
+    if (!buf || !value || count == 0 || count > PAGE_SIZE) {
+        return -EINVAL;
+    }
+
+    if (kstrtoint(buf, 10, value) != 0) {
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+/**
+ * quectel_core_get_temp - Current temperature
+ *
+ * Return: Temperature in m°C
+ */
+int quectel_core_get_temp(void)
+{
+    int temp;
+
+    mutex_lock(&temp_lock);
+    temp = modem_temp;
+    mutex_unlock(&temp_lock);
+
+    return temp;
+}
+
+/**
+ * quectel_core_set_temp - Update the current temperature
+ * @value: Temperature in m°C
+ *
+ * Validates the absolute range, updates the statistics and notifies the
+ * thermal framework, whichever front-end the value was written to.
+ *
+ * Return: 0 on success, -EINVAL if out of range
+ */
+int quectel_core_set_temp(int value)
+{
+    if (value < TEMP_ABSOLUTE_MIN || value > TEMP_ABSOLUTE_MAX) {
+        pr_err("Quectel RM520N: Temperature value %d m°C outside valid range [%d, %d] m°C\n",
+               value, TEMP_ABSOLUTE_MIN, TEMP_ABSOLUTE_MAX);
+        return -EINVAL;
+    }
+
+    mutex_lock(&temp_lock);
+    modem_temp = value;
+    total_updates++;
+    last_update_time = jiffies / HZ;  /* Convert jiffies to seconds */
+    mutex_unlock(&temp_lock);
+
+    /* Called without temp_lock held: the zone reads back through get_temp */
+    quectel_sensor_notify();
+    return 0;
+}
+
+/**
+ * quectel_core_get_threshold - Read a temperature threshold
+ * @which: Threshold to read
+ *
+ * Return: Threshold in m°C
+ */
+int quectel_core_get_threshold(enum quectel_threshold which)
+{
+    int val;
+
+    mutex_lock(&temp_lock);
+    switch (which) {
+    case QUECTEL_TEMP_MIN:
+        val = temp_min;
+        break;
+    case QUECTEL_TEMP_MAX:
+        val = temp_max;
+        break;
+    case QUECTEL_TEMP_CRIT:
+        val = temp_crit;
+        break;
+    default:
+        val = temp_default;
+        break;
+    }
+    mutex_unlock(&temp_lock);
+
+    return val;
+}
+
+/**
+ * quectel_core_set_threshold - Update a temperature threshold
+ * @which: Threshold to update
+ * @value: New value in m°C
+ *
+ * Keeps min <= default <= max <= crit and the absolute range.
+ *
+ * Return: 0 on success, -EINVAL on error
+ */
+int quectel_core_set_threshold(enum quectel_threshold which, int value)
+{
+    static const char *const names[] = { "temp_min", "temp_max", "temp_crit", "temp_default" };
+    const char *reason = NULL;
+    int limit = 0;
+
+    mutex_lock(&temp_lock);
+    switch (which) {
+    case QUECTEL_TEMP_MIN:
+        if (value < TEMP_ABSOLUTE_MIN) {
+            reason = "below absolute minimum";
+            limit = TEMP_ABSOLUTE_MIN;
+        } else if (value > temp_max) {
+            reason = "cannot exceed temp_max";
+            limit = temp_max;
+        } else {
+            temp_min = value;
+        }
+        break;
+    case QUECTEL_TEMP_MAX:
+        if (value > TEMP_ABSOLUTE_MAX) {
+            reason = "above absolute maximum";
+            limit = TEMP_ABSOLUTE_MAX;
+        } else if (value < temp_min) {
+            reason = "cannot be below temp_min";
+            limit = temp_min;
+        } else {
+            temp_max = value;
+        }
+        break;
+    case QUECTEL_TEMP_CRIT:
+        if (value > TEMP_ABSOLUTE_MAX) {
+            reason = "above absolute maximum";
+            limit = TEMP_ABSOLUTE_MAX;
+        } else if (value < temp_max) {
+            reason = "cannot be below temp_max";
+            limit = temp_max;
+        } else {
+            temp_crit = value;
+        }
+        break;
+    case QUECTEL_TEMP_DEFAULT:
+        if (value < temp_min) {
+            reason = "cannot be below temp_min";
+            limit = temp_min;
+        } else if (value > temp_max) {
+            reason = "cannot exceed temp_max";
+            limit = temp_max;
+        } else {
+            temp_default = value;
+        }
+        break;
+    default:
+        mutex_unlock(&temp_lock);
+        return -EINVAL;
+    }
+    mutex_unlock(&temp_lock);
+
+    if (reason) {
+        pr_err("Quectel RM520N: %s value %d m°C %s %d m°C\n", names[which], value, reason, limit);
+        return -EINVAL;
+    }
+
+    pr_info("Quectel RM520N: Updated %s to %d m°C\n", names[which], value);
+    return 0;
+}
+
+/**
+ * quectel_core_get_estimated - Whether the current value is an estimate
+ *
+ * Return: true if the daemon flagged a board-sensor estimate
+ */
+bool quectel_core_get_estimated(void)
+{
+    bool estimated;
+
+    mutex_lock(&temp_lock);
+    estimated = temp_estimated;
+    mutex_unlock(&temp_lock);
+
+    return estimated;
+}
+
+/**
+ * quectel_core_set_estimated - Flag the source of the current value
+ * @estimated: true for a board-sensor estimate, false for a modem reading
+ */
+void quectel_core_set_estimated(bool estimated)
+{
+    mutex_lock(&temp_lock);
+    temp_estimated = estimated;
+    mutex_unlock(&temp_lock);
+}
+
+/**
+ * quectel_core_get_stats - Snapshot of the update statistics
+ * @updates: Total temperature updates
+ * @update_time: Time of the last update in seconds since boot
+ * @estimated: Source flag of the current value
+ */
+void quectel_core_get_stats(unsigned long *updates, unsigned long *update_time, bool *estimated)
+{
+    mutex_lock(&temp_lock);
+    *updates = total_updates;
+    *update_time = last_update_time;
+    *estimated = temp_estimated;
+    mutex_unlock(&temp_lock);
+}
+
+/* ===== MODULE ENTRY ===== */
+
+/**
+ * quectel_rm520n_temp_init - Module initialization function
+ *
+ * Starts the enabled front-ends in order and stops the ones already
+ * started if a later one fails.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+static int __init quectel_rm520n_temp_init(void)
+{
+    int ret;
+
+    if (!enable_sysfs && !enable_thermal && !enable_hwmon) {
+        pr_err("Quectel RM520N: All front-ends disabled, nothing to load\n");
+        return -EINVAL;
+    }
+
+    if (enable_sysfs) {
+        ret = quectel_sysfs_init();
+        if (ret)
+            return ret;
+    }
+
+    if (enable_thermal) {
+        ret = quectel_sensor_init();
+        if (ret)
+            goto err_sysfs;
+    }
+
+    if (enable_hwmon) {
+        ret = quectel_hwmon_init();
+        if (ret)
+            goto err_sensor;
+    }
+
+    pr_info("Quectel RM520N temperature module loaded (sysfs=%d thermal=%d hwmon=%d) with thresholds: min=%d, max=%d, crit=%d, default=%d m°C\n",
+            enable_sysfs, enable_thermal, enable_hwmon, temp_min, temp_max, temp_crit, temp_default);
+    return 0;
+
+err_sensor:
+    if (enable_thermal)
+        quectel_sensor_exit();
+err_sysfs:
+    if (enable_sysfs)
+        quectel_sysfs_exit();
+    pr_err("Quectel RM520N: Module initialization failed (error: %d)\n", ret);
+    return ret;
+}
+
+/**
+ * quectel_rm520n_temp_exit - Module cleanup function
+ *
+ * Stops the enabled front-ends in reverse order.
+ */
+static void __exit quectel_rm520n_temp_exit(void)
+{
+    if (enable_hwmon)
+        quectel_hwmon_exit();
+    if (enable_thermal)
+        quectel_sensor_exit();
+    if (enable_sysfs)
+        quectel_sysfs_exit();
+
+    pr_info("Quectel RM520N temperature module unloaded.\n");
+}
+
+module_init(quectel_rm520n_temp_init);
+module_exit(quectel_rm520n_temp_exit);
+
+MODULE_DESCRIPTION(KMOD_NAME " - Kernel Module");
+MODULE_AUTHOR(KMOD_AUTHOR);
+MODULE_VERSION(KMOD_VERSION);
+MODULE_LICENSE(KMOD_LICENSE);
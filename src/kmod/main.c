@@ -1,13 +1,14 @@
 /**
  * @file main.c
- * @brief Sysfs temperature interface kernel module for Quectel RM520N
+ * @brief Sysfs temperature front-end for Quectel RM520N
  * @author Christopher Sollinger
  * @date 2025
  * @license GPL
  * 
- * This kernel module provides a sysfs-based temperature interface,
+ * This front-end provides a sysfs-based temperature interface,
  * creating /sys/kernel/quectel_rm520n_thermal/temp for reading and writing
- * temperature values from userspace applications.
+ * temperature values from userspace applications. Values are kept in the
+ * shared core (core.c).
  */
 
 #include <linux/module.h>
@@ -17,28 +18,12 @@
 #include <linux/sysfs.h>
 #include <linux/kobject.h>
 #include <linux/version.h>
-#include <linux/mutex.h>
 
 /* Package metadata definitions */
 #include "../include/common.h"
+#include "../include/kmod_core.h"
 #include "../include/kmod_main.h"
 
-/* Temperature threshold storage (in m°C) */
-static int temp_min = DEFAULT_TEMP_MIN;
-static int temp_max = DEFAULT_TEMP_MAX;
-static int temp_crit = DEFAULT_TEMP_CRIT;
-static int temp_default = DEFAULT_TEMP_DEFAULT;
-
-/* Current temperature value in m°C */
-static int modem_temp = DEFAULT_TEMP_DEFAULT;
-
-/* Statistics counters */
-static unsigned long total_updates = 0;
-static unsigned long last_update_time = 0;
-
-/* Mutex for thread-safe access to temperature data */
-static DEFINE_MUTEX(temp_lock);
-
 /**
  * temp_show - Sysfs read function for current temperature
  * @kobj: Kernel object pointer
@@ -52,7 +37,6 @@ static DEFINE_MUTEX(temp_lock);
  */
 static ssize_t temp_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
 {
-    int temp;
     (void)kobj;
     (void)attr;
 
@@ -61,11 +45,7 @@ static ssize_t temp_show(struct kobject *kobj, struct kobj_attribute *attr, char
         return -EINVAL;
     }
 
-    mutex_lock(&temp_lock);
-    temp = modem_temp;
-    mutex_unlock(&temp_lock);
-
-    return scnprintf(buf, PAGE_SIZE, "%d\n", temp);
+    return scnprintf(buf, PAGE_SIZE, "%d\n", quectel_core_get_temp());
 }
 
 /**
@@ -75,137 +55,101 @@ static ssize_t temp_show(struct kobject *kobj, struct kobj_attribute *attr, char
  * @buf: Input buffer containing temperature string
  * @count: Number of characters in input buffer
  *
- * Updates the current temperature value from sysfs input. Handles
- * newline removal and ensures proper string termination.
+ * Updates the current temperature value from sysfs input.
  *
  * Return: Number of characters processed on success
  */
 static ssize_t temp_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
 {
     int value;
+    int ret;
     (void)kobj;
     (void)attr;
 
-    /* Validate input parameters */
-    if (!buf || count == 0) {
+    if (quectel_core_parse(buf, count, &value) != 0) {
+        pr_err("Quectel RM520N: Failed to parse temperature value from input\n");
         return -EINVAL;
     }
-    
-    /* Parse the temperature value from the buffer */
-    if (kstrtoint(buf, 10, &value) == 0) {
-        mutex_lock(&temp_lock);
-        /* Store the temperature value in m°C */
-        modem_temp = value;
-        /* Update statistics */
-        total_updates++;
-        last_update_time = jiffies / HZ;  /* Convert jiffies to seconds */
-        mutex_unlock(&temp_lock);
-        /* Temperature updated successfully */
-        return count;
-    }
 
-    pr_err("Quectel RM520N: Failed to parse temperature value from input\n");
-    return -EINVAL;
+    ret = quectel_core_set_temp(value);
+    return ret ? ret : (ssize_t)count;
 }
 
-/* Temperature threshold show functions */
 /**
- * temp_min_show - Sysfs read function for minimum temperature threshold
- * @kobj: Kernel object pointer
- * @attr: Kernel object attribute
+ * threshold_show - Format a threshold for sysfs output
+ * @which: Threshold to read
  * @buf: Output buffer for temperature value
  *
- * Returns the minimum temperature threshold in m°C.
- *
  * Return: Number of characters written to buffer
  */
-static ssize_t temp_min_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+static ssize_t threshold_show(enum quectel_threshold which, char *buf)
 {
-    int val;
-    (void)kobj;
-    (void)attr;
-
     /* Validate output buffer */
     if (!buf) {
         return -EINVAL;
     }
 
-    mutex_lock(&temp_lock);
-    val = temp_min;
-    mutex_unlock(&temp_lock);
-
-    return scnprintf(buf, PAGE_SIZE, "%d\n", val);
+    return scnprintf(buf, PAGE_SIZE, "%d\n", quectel_core_get_threshold(which));
 }
 
 /**
- * temp_max_show - Sysfs read function for maximum temperature threshold
- * @kobj: Kernel object pointer
- * @attr: Kernel object attribute
- * @buf: Output buffer for temperature value
+ * threshold_store - Parse and apply a threshold written to sysfs
+ * @which: Threshold to update
+ * @buf: Input buffer containing temperature value
+ * @count: Number of characters in input buffer
  *
- * Returns the maximum temperature threshold in m°C.
+ * Range and ordering checks are done by the core.
  *
- * Return: Number of characters written to buffer
+ * Return: Number of characters processed on success, -EINVAL on error
  */
-static ssize_t temp_max_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+static ssize_t threshold_store(enum quectel_threshold which, const char *buf, size_t count)
 {
-    int val;
-    (void)kobj;
-    (void)attr;
+    int value;
+    int ret;
 
-    /* Validate output buffer */
-    if (!buf) {
+    if (quectel_core_parse(buf, count, &value) != 0) {
+        pr_err("Quectel RM520N: Failed to parse threshold value from input\n");
         return -EINVAL;
     }
 
-    mutex_lock(&temp_lock);
-    val = temp_max;
-    mutex_unlock(&temp_lock);
-
-    return scnprintf(buf, PAGE_SIZE, "%d\n", val);
+    ret = quectel_core_set_threshold(which, value);
+    return ret ? ret : (ssize_t)count;
 }
 
-/**
- * temp_crit_show - Sysfs read function for critical temperature threshold
- * @kobj: Kernel object pointer
- * @attr: Kernel object attribute
- * @buf: Output buffer for temperature value
- *
- * Returns the critical temperature threshold in m°C.
- *
- * Return: Number of characters written to buffer
- */
-static ssize_t temp_crit_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
-{
-    int val;
-    (void)kobj;
-    (void)attr;
-
-    /* Validate output buffer */
-    if (!buf) {
-        return -EINVAL;
-    }
-
-    mutex_lock(&temp_lock);
-    val = temp_crit;
-    mutex_unlock(&temp_lock);
-
-    return scnprintf(buf, PAGE_SIZE, "%d\n", val);
+/* Threshold show/store wrappers for the kobj_attribute callbacks (m°C) */
+#define QUECTEL_THRESHOLD_ATTR(name, which)                                                      \
+static ssize_t name##_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)          \
+{                                                                                                \
+    (void)kobj;                                                                                  \
+    (void)attr;                                                                                  \
+    return threshold_show(which, buf);                                                           \
+}                                                                                                \
+static ssize_t name##_store(struct kobject *kobj, struct kobj_attribute *attr,                   \
+                            const char *buf, size_t count)                                       \
+{                                                                                                \
+    (void)kobj;                                                                                  \
+    (void)attr;                                                                                  \
+    return threshold_store(which, buf, count);                                                   \
 }
 
+QUECTEL_THRESHOLD_ATTR(temp_min, QUECTEL_TEMP_MIN)
+QUECTEL_THRESHOLD_ATTR(temp_max, QUECTEL_TEMP_MAX)
+QUECTEL_THRESHOLD_ATTR(temp_crit, QUECTEL_TEMP_CRIT)
+QUECTEL_THRESHOLD_ATTR(temp_default, QUECTEL_TEMP_DEFAULT)
+
 /**
- * temp_default_show - Sysfs read function for default temperature threshold
+ * temp_source_show - Sysfs read function for temperature source
  * @kobj: Kernel object pointer
  * @attr: Kernel object attribute
- * @buf: Output buffer for temperature value
+ * @buf: Output buffer for source string
  *
- * Returns the default temperature threshold in m°C.
+ * Reports whether the current temperature was read from the modem or
+ * estimated by the daemon from board sensors.
  *
  * Return: Number of characters written to buffer
  */
-static ssize_t temp_default_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+static ssize_t temp_source_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
 {
-    int val;
     (void)kobj;
     (void)attr;
 
@@ -214,80 +158,20 @@ static ssize_t temp_default_show(struct kobject *kobj, struct kobj_attribute *at
         return -EINVAL;
     }
 
-    mutex_lock(&temp_lock);
-    val = temp_default;
-    mutex_unlock(&temp_lock);
-
-    return scnprintf(buf, PAGE_SIZE, "%d\n", val);
-}
-
-/* Temperature threshold store functions */
-/**
- * temp_min_store - Sysfs write function for minimum temperature threshold
- * @kobj: Kernel object pointer
- * @attr: Kernel object attribute
- * @buf: Input buffer containing temperature value
- * @count: Number of characters in input buffer
- *
- * Updates the minimum temperature threshold. Validates that the new value
- * is within the absolute minimum range and less than or equal to max.
- *
- * Return: Number of characters processed on success, -EINVAL on error
- */
-static ssize_t temp_min_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
-{
-    int value;
-    int current_max;
-    (void)kobj;
-    (void)attr;
-
-    /* Validate input parameters */
-    if (!buf || count == 0) {
-        return -EINVAL;
-    }
-
-    if (kstrtoint(buf, 10, &value) == 0) {
-        if (value < TEMP_ABSOLUTE_MIN) {
-            pr_err("Quectel RM520N: temp_min value %d m°C below absolute minimum %d m°C\n",
-                   value, TEMP_ABSOLUTE_MIN);
-            return -EINVAL;
-        }
-
-        mutex_lock(&temp_lock);
-        current_max = temp_max;
-        if (value > current_max) {
-            mutex_unlock(&temp_lock);
-            pr_err("Quectel RM520N: temp_min value %d m°C cannot exceed temp_max %d m°C\n",
-                   value, current_max);
-            return -EINVAL;
-        }
-
-        temp_min = value;
-        mutex_unlock(&temp_lock);
-        pr_info("Quectel RM520N: Updated temp_min to %d m°C\n", value);
-        return count;
-    }
-
-    pr_err("Quectel RM520N: Failed to parse temp_min value from input\n");
-    return -EINVAL;
+    return scnprintf(buf, PAGE_SIZE, "%s\n", quectel_core_get_estimated() ? "estimated" : "modem");
 }
 
 /**
- * temp_max_store - Sysfs write function for maximum temperature threshold
+ * temp_source_store - Sysfs write function for temperature source
  * @kobj: Kernel object pointer
  * @attr: Kernel object attribute
- * @buf: Input buffer containing temperature value
+ * @buf: Input buffer containing "modem" or "estimated"
  * @count: Number of characters in input buffer
  *
- * Updates the maximum temperature threshold. Validates that the new value
- * is greater than or equal to min and within the absolute maximum range.
- *
  * Return: Number of characters processed on success, -EINVAL on error
  */
-static ssize_t temp_max_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+static ssize_t temp_source_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
 {
-    int value;
-    int current_min;
     (void)kobj;
     (void)attr;
 
@@ -296,80 +180,16 @@ static ssize_t temp_max_store(struct kobject *kobj, struct kobj_attribute *attr,
         return -EINVAL;
     }
 
-    if (kstrtoint(buf, 10, &value) == 0) {
-        if (value > TEMP_ABSOLUTE_MAX) {
-            pr_err("Quectel RM520N: temp_max value %d m°C above absolute maximum %d m°C\n",
-                   value, TEMP_ABSOLUTE_MAX);
-            return -EINVAL;
-        }
-
-        mutex_lock(&temp_lock);
-        current_min = temp_min;
-        if (value < current_min) {
-            mutex_unlock(&temp_lock);
-            pr_err("Quectel RM520N: temp_max value %d m°C cannot be below temp_min %d m°C\n",
-                   value, current_min);
-            return -EINVAL;
-        }
-
-        temp_max = value;
-        mutex_unlock(&temp_lock);
-        pr_info("Quectel RM520N: Updated temp_max to %d m°C\n", value);
-        return count;
-    }
-
-    pr_err("Quectel RM520N: Failed to parse temp_max value from input\n");
-    return -EINVAL;
-}
-
-/**
- * temp_crit_store - Sysfs write function for critical temperature threshold
- * @kobj: Kernel object pointer
- * @attr: Kernel object attribute
- * @buf: Input buffer containing temperature value
- * @count: Number of characters in input buffer
- *
- * Updates the critical temperature threshold. Validates that the new value
- * is greater than or equal to max and within the absolute maximum range.
- *
- * Return: Number of characters processed on success, -EINVAL on error
- */
-static ssize_t temp_crit_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
-{
-    int value;
-    int current_max;
-    (void)kobj;
-    (void)attr;
-
-    /* Validate input parameters */
-    if (!buf || count == 0) {
+    if (sysfs_streq(buf, "modem")) {
+        quectel_core_set_estimated(false);
+    } else if (sysfs_streq(buf, "estimated")) {
+        quectel_core_set_estimated(true);
+    } else {
+        pr_err("Quectel RM520N: Invalid temp_source value (expected 'modem' or 'estimated')\n");
         return -EINVAL;
     }
 
-    if (kstrtoint(buf, 10, &value) == 0) {
-        if (value > TEMP_ABSOLUTE_MAX) {
-            pr_err("Quectel RM520N: temp_crit value %d m°C above absolute maximum %d m°C\n",
-                   value, TEMP_ABSOLUTE_MAX);
-            return -EINVAL;
-        }
-
-        mutex_lock(&temp_lock);
-        current_max = temp_max;
-        if (value < current_max) {
-            mutex_unlock(&temp_lock);
-            pr_err("Quectel RM520N: temp_crit value %d m°C cannot be below temp_max %d m°C\n",
-                   value, current_max);
-            return -EINVAL;
-        }
-
-        temp_crit = value;
-        mutex_unlock(&temp_lock);
-        pr_info("Quectel RM520N: Updated temp_crit to %d m°C\n", value);
-        return count;
-    }
-
-    pr_err("Quectel RM520N: Failed to parse temp_crit value from input\n");
-    return -EINVAL;
+    return count;
 }
 
 /**
@@ -378,7 +198,7 @@ static ssize_t temp_crit_store(struct kobject *kobj, struct kobj_attribute *attr
  * @attr: Kernel object attribute
  * @buf: Output buffer for stats string
  *
- * Returns statistics about temperature updates.
+ * Returns statistics about temperature updates from all front-ends.
  *
  * Return: Number of characters written to buffer
  */
@@ -386,6 +206,7 @@ static ssize_t stats_show(struct kobject *kobj, struct kobj_attribute *attr, cha
 {
     unsigned long updates;
     unsigned long update_time;
+    bool estimated;
     (void)kobj;
     (void)attr;
 
@@ -394,67 +215,10 @@ static ssize_t stats_show(struct kobject *kobj, struct kobj_attribute *attr, cha
         return -EINVAL;
     }
 
-    mutex_lock(&temp_lock);
-    updates = total_updates;
-    update_time = last_update_time;
-    mutex_unlock(&temp_lock);
+    quectel_core_get_stats(&updates, &update_time, &estimated);
 
-    return scnprintf(buf, PAGE_SIZE, "total_updates: %lu\nlast_update_time: %lu\n",
-                     updates, update_time);
-}
-
-/**
- * temp_default_store - Sysfs write function for default temperature threshold
- * @kobj: Kernel object pointer
- * @attr: Kernel object attribute
- * @buf: Input buffer containing temperature value
- * @count: Number of characters in input buffer
- *
- * Updates the default temperature threshold. Validates that the new value
- * is within the min to max range.
- *
- * Return: Number of characters processed on success, -EINVAL on error
- */
-static ssize_t temp_default_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
-{
-    int value;
-    int current_min;
-    int current_max;
-    (void)kobj;
-    (void)attr;
-
-    /* Validate input parameters */
-    if (!buf || count == 0) {
-        return -EINVAL;
-    }
-
-    if (kstrtoint(buf, 10, &value) == 0) {
-        mutex_lock(&temp_lock);
-        current_min = temp_min;
-        current_max = temp_max;
-
-        if (value < current_min) {
-            mutex_unlock(&temp_lock);
-            pr_err("Quectel RM520N: temp_default value %d m°C cannot be below temp_min %d m°C\n",
-                   value, current_min);
-            return -EINVAL;
-        }
-
-        if (value > current_max) {
-            mutex_unlock(&temp_lock);
-            pr_err("Quectel RM520N: temp_default value %d m°C cannot exceed temp_max %d m°C\n",
-                   value, current_max);
-            return -EINVAL;
-        }
-
-        temp_default = value;
-        mutex_unlock(&temp_lock);
-        pr_info("Quectel RM520N: Updated temp_default to %d m°C\n", value);
-        return count;
-    }
-
-    pr_err("Quectel RM520N: Failed to parse temp_default value from input\n");
-    return -EINVAL;
+    return scnprintf(buf, PAGE_SIZE, "total_updates: %lu\nlast_update_time: %lu\nsource: %s\n",
+                     updates, update_time, estimated ? "estimated" : "modem");
 }
 
 /* Sysfs attributes: 0644 (read/write for owner, read for others), 0444 (read-only) */
@@ -463,23 +227,37 @@ static struct kobj_attribute temp_min_attribute = __ATTR(temp_min, 0644, temp_mi
 static struct kobj_attribute temp_max_attribute = __ATTR(temp_max, 0644, temp_max_show, temp_max_store);
 static struct kobj_attribute temp_crit_attribute = __ATTR(temp_crit, 0644, temp_crit_show, temp_crit_store);
 static struct kobj_attribute temp_default_attribute = __ATTR(temp_default, 0644, temp_default_show, temp_default_store);
+static struct kobj_attribute temp_source_attribute = __ATTR(temp_source, 0644, temp_source_show, temp_source_store);
 static struct kobj_attribute stats_attribute = __ATTR(stats, 0444, stats_show, NULL);
 
+static struct attribute *quectel_sysfs_attrs[] = {
+    &temp_attribute.attr,
+    &temp_min_attribute.attr,
+    &temp_max_attribute.attr,
+    &temp_crit_attribute.attr,
+    &temp_default_attribute.attr,
+    &temp_source_attribute.attr,
+    &stats_attribute.attr,
+    NULL,
+};
+
+static const struct attribute_group quectel_sysfs_group = {
+    .attrs = quectel_sysfs_attrs,
+};
+
 static struct kobject *temp_kobj;
 
 /**
- * quectel_rm520n_temp_init - Module initialization function
+ * quectel_sysfs_init - Start the sysfs front-end
  *
  * Creates the sysfs directory and all temperature-related attributes.
- * Implements proper error handling with cleanup on failure.
- * Sets up the complete sysfs interface for temperature management.
  *
  * Return: 0 on success, negative error code on failure
  */
-static int __init quectel_rm520n_temp_init(void)
+int __init quectel_sysfs_init(void)
 {
-    int ret = 0;
-    
+    int ret;
+
     /* Create the sysfs directory "quectel_rm520n_thermal" */
     temp_kobj = kobject_create_and_add("quectel_rm520n_thermal", kernel_kobj);
     if (!temp_kobj) {
@@ -487,81 +265,32 @@ static int __init quectel_rm520n_temp_init(void)
         return -ENOMEM;
     }
 
-    pr_info("Quectel RM520N: Created sysfs directory\n");
-
-    /* Create sysfs files individually with proper error handling */
-    ret = sysfs_create_file(temp_kobj, &temp_attribute.attr);
-    if (ret) {
-        pr_err("Quectel RM520N: Failed to create temp attribute (error: %d)\n", ret);
-        goto cleanup;
-    }
-
-    ret = sysfs_create_file(temp_kobj, &temp_min_attribute.attr);
-    if (ret) {
-        pr_err("Quectel RM520N: Failed to create temp_min attribute (error: %d)\n", ret);
-        goto cleanup;
-    }
-
-    ret = sysfs_create_file(temp_kobj, &temp_max_attribute.attr);
-    if (ret) {
-        pr_err("Quectel RM520N: Failed to create temp_max attribute (error: %d)\n", ret);
-        goto cleanup;
-    }
-
-    ret = sysfs_create_file(temp_kobj, &temp_crit_attribute.attr);
-    if (ret) {
-        pr_err("Quectel RM520N: Failed to create temp_crit attribute (error: %d)\n", ret);
-        goto cleanup;
-    }
-
-    ret = sysfs_create_file(temp_kobj, &temp_default_attribute.attr);
-    if (ret) {
-        pr_err("Quectel RM520N: Failed to create temp_default attribute (error: %d)\n", ret);
-        goto cleanup;
-    }
-
-    ret = sysfs_create_file(temp_kobj, &stats_attribute.attr);
+    /* Creates all attributes or none */
+    ret = sysfs_create_group(temp_kobj, &quectel_sysfs_group);
     if (ret) {
-        pr_err("Quectel RM520N: Failed to create stats attribute (error: %d)\n", ret);
-        goto cleanup;
+        pr_err("Quectel RM520N: Failed to create sysfs attributes (error: %d)\n", ret);
+        kobject_put(temp_kobj);
+        temp_kobj = NULL;
+        return ret;
     }
 
-    pr_info("Quectel RM520N temperature module loaded successfully with thresholds: min=%d, max=%d, crit=%d, default=%d m°C\n",
-            temp_min, temp_max, temp_crit, temp_default);
+    pr_info("Quectel RM520N: Created sysfs directory\n");
     return 0;
-
-cleanup:
-    pr_err("Quectel RM520N: Module initialization failed, cleaning up\n");
-    kobject_put(temp_kobj);
-    return ret;
 }
 
 /**
- * quectel_rm520n_temp_exit - Module cleanup function
+ * quectel_sysfs_exit - Stop the sysfs front-end
  *
  * Removes all sysfs attributes and cleans up the kobject.
- * Called when the module is unloaded to prevent resource leaks.
  */
-static void __exit quectel_rm520n_temp_exit(void)
+void quectel_sysfs_exit(void)
 {
-    /* Remove all sysfs files before removing the kobject */
-    sysfs_remove_file(temp_kobj, &temp_attribute.attr);
-    sysfs_remove_file(temp_kobj, &temp_min_attribute.attr);
-    sysfs_remove_file(temp_kobj, &temp_max_attribute.attr);
-    sysfs_remove_file(temp_kobj, &temp_crit_attribute.attr);
-    sysfs_remove_file(temp_kobj, &temp_default_attribute.attr);
-    sysfs_remove_file(temp_kobj, &stats_attribute.attr);
-    
+    if (!temp_kobj)
+        return;
+
+    sysfs_remove_group(temp_kobj, &quectel_sysfs_group);
+
     /* Remove the kobject (this also removes the directory) */
     kobject_put(temp_kobj);
-    
-    pr_info("Quectel RM520N temperature module unloaded.\n");
+    temp_kobj = NULL;
 }
-
-module_init(quectel_rm520n_temp_init);
-module_exit(quectel_rm520n_temp_exit);
-
-MODULE_DESCRIPTION(KMOD_NAME " - Kernel Module");
-MODULE_AUTHOR(KMOD_AUTHOR);
-MODULE_VERSION(KMOD_VERSION);
-MODULE_LICENSE(KMOD_LICENSE);
@@ -1,13 +1,15 @@
 /**
  * @file sensor.c
- * @brief Virtual thermal sensor kernel module for Quectel RM520N
+ * @brief Virtual thermal sensor front-end for Quectel RM520N
  * @author Christopher Sollinger
  * @date 2025
  * @license GPL
  * 
- * This kernel module registers a virtual thermal sensor with the Linux
+ * This front-end registers a virtual thermal sensor with the Linux
  * Thermal Framework, providing temperature data to the thermal subsystem
- * for system-wide thermal management and fan control.
+ * for system-wide thermal management and fan control. The temperature is
+ * read from the shared core (core.c), so writes through any front-end
+ * update the zone.
  */
 
 #include <linux/module.h>
@@ -21,15 +23,20 @@
 #include <linux/errno.h>
 #include <linux/version.h>
 #include <linux/string.h>
+#include <linux/mutex.h>
 
 #include "../include/common.h"
+#include "../include/kmod_core.h"
 #include "../include/kmod_sensor.h"
 
-/* Data structure to store the current temperature (in m°C) */
-struct quectel_temp_data {
-    struct thermal_zone_device *tzd; /* Handle to the Thermal Zone */
-    int cur_temp;                    /* Current temperature in milli-degrees Celsius (m°C) */
-};
+/* Handle to the registered thermal zone, NULL while no device is bound */
+static struct thermal_zone_device *sensor_tzd;
+
+/* Serializes zone updates against probe and remove */
+static DEFINE_MUTEX(sensor_lock);
+
+/* Set once the platform driver is registered */
+static bool sensor_registered;
 
 /**
  * quectel_temp_get_temp - Retrieve current temperature from thermal zone
@@ -37,25 +44,18 @@ struct quectel_temp_data {
  * @temp: Pointer to store temperature value (in m°C)
  *
  * Callback function for the thermal framework to retrieve the current
- * temperature value. Returns 0 on success, -EINVAL on error.
+ * temperature value from the shared core.
  *
- * Return: 0 on success, -EINVAL if data is not available
+ * Return: 0 on success, -EINVAL on invalid arguments
  */
 static int quectel_temp_get_temp(struct thermal_zone_device *tzd, int *temp)
 {
-    struct quectel_temp_data *data;
-    
     /* Validate input parameters */
     if (!tzd || !temp) {
         return -EINVAL;
     }
-    
-    data = thermal_zone_device_priv(tzd);
-    if (!data) {
-        return -EINVAL;
-    }
-    
-    *temp = data->cur_temp;
+
+    *temp = quectel_core_get_temp();
     return 0;
 }
 
@@ -76,14 +76,12 @@ static const struct thermal_zone_device_ops quectel_temp_ops = {
  */
 static ssize_t cur_temp_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
-    struct quectel_temp_data *data = dev_get_drvdata(dev);
-    
     /* Validate input parameters */
-    if (!dev || !attr || !buf || !data) {
+    if (!dev || !attr || !buf) {
         return -EINVAL;
     }
     
-    return scnprintf(buf, PAGE_SIZE, "%d\n", data->cur_temp);
+    return scnprintf(buf, PAGE_SIZE, "%d\n", quectel_core_get_temp());
 }
 
 /**
@@ -93,103 +91,86 @@ static ssize_t cur_temp_show(struct device *dev, struct device_attribute *attr,
  * @buf: Input buffer containing temperature value
  * @count: Number of characters in input buffer
  *
- * Updates the current temperature value from sysfs input. Validates
- * the input range and notifies the thermal framework of changes.
+ * Updates the current temperature value from sysfs input. The core
+ * validates the range and notifies the thermal framework.
  *
  * Return: Number of characters processed on success, -EINVAL on error
  */
 static ssize_t cur_temp_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
-    struct quectel_temp_data *data = dev_get_drvdata(dev);
     int val;
+    int ret;
 
     /* Validate input parameters */
-    if (!dev || !attr || !buf || !data) {
+    if (!dev || !attr) {
         return -EINVAL;
     }
 
-    /* Check if count is reasonable */
-    if (count == 0 || count > PAGE_SIZE) {
+    if (quectel_core_parse(buf, count, &val) != 0) {
+        dev_err(dev, "QuectelTemp: Failed to parse temperature value from input\n");
         return -EINVAL;
     }
 
-    if (kstrtoint(buf, 10, &val) == 0) {
-        /* Validate temperature range */
-        if (val < TEMP_ABSOLUTE_MIN) {
-            dev_err(dev, "QuectelTemp: Temperature value %d m°C below absolute minimum %d m°C\n", 
-                    val, TEMP_ABSOLUTE_MIN);
-            return -EINVAL;
-        }
-        
-        if (val > TEMP_ABSOLUTE_MAX) {
-            dev_err(dev, "QuectelTemp: Temperature value %d m°C above absolute maximum %d m°C\n", 
-                    val, TEMP_ABSOLUTE_MAX);
-            return -EINVAL;
-        }
-        
-        data->cur_temp = val; /* Update the current temperature */
-        /* Temperature updated successfully */
-        
-        /* Notify the thermal framework of temperature changes */
-        thermal_zone_device_update(data->tzd, THERMAL_EVENT_UNSPECIFIED);
-        return count;
-    }
-
-    dev_err(dev, "QuectelTemp: Failed to parse temperature value from input\n");
-    return -EINVAL;
+    ret = quectel_core_set_temp(val);
+    return ret ? ret : (ssize_t)count;
 }
 
 /* Define the sysfs attribute for "cur_temp" with read/write permissions */
 static DEVICE_ATTR_RW(cur_temp);
 
+/**
+ * quectel_sensor_notify - Notify the thermal framework of a new temperature
+ *
+ * Called by the core after every temperature update. Does nothing while no
+ * thermal zone is registered.
+ */
+void quectel_sensor_notify(void)
+{
+    mutex_lock(&sensor_lock);
+    if (sensor_tzd)
+        thermal_zone_device_update(sensor_tzd, THERMAL_EVENT_UNSPECIFIED);
+    mutex_unlock(&sensor_lock);
+}
+
 /**
  * quectel_temp_probe - Probe function for virtual thermal sensor
  * @pdev: Platform device structure
  *
- * Initializes the virtual thermal sensor, allocates memory, registers
- * with the thermal framework, and creates sysfs attributes. Handles
- * thermal zone registration.
+ * Registers the virtual thermal sensor with the thermal framework and
+ * creates the cur_temp attribute. Only one zone is supported.
  *
  * Return: 0 on success, negative error code on failure
  */
 static int quectel_temp_probe(struct platform_device *pdev)
 {
-    struct quectel_temp_data *data;
+    struct thermal_zone_device *tzd;
     int ret;
 
     dev_info(&pdev->dev, "Probing quectel_rm520n_temp...\n");
 
-    /* Allocate memory for the sensor data */
-    data = devm_kzalloc(&pdev->dev, sizeof(*data), GFP_KERNEL);
-    if (!data) {
-        dev_err(&pdev->dev, "Memory allocation failed for quectel_rm520n_temp_data\n");
-        return -ENOMEM;
-    }
-
-    /* Default temperature value from shared constants */
-    data->cur_temp = DEFAULT_TEMP_DEFAULT;
-
     /* Register the sensor only if a Device Tree node is present */
     if (!pdev->dev.of_node) {
         dev_err(&pdev->dev, "No Device Tree node found for quectel_rm520n_temp\n");
         return -ENODEV;
     }
 
+    if (sensor_tzd) {
+        dev_err(&pdev->dev, "Thermal zone already registered by another device\n");
+        return -EBUSY;
+    }
+
     /* Register the thermal zone with the thermal framework
      * Using devm_thermal_of_zone_register
      */
-    data->tzd = devm_thermal_of_zone_register(&pdev->dev, 0, data, &quectel_temp_ops);
+    tzd = devm_thermal_of_zone_register(&pdev->dev, 0, NULL, &quectel_temp_ops);
 
-    if (IS_ERR(data->tzd)) {
-        ret = PTR_ERR(data->tzd);
+    if (IS_ERR(tzd)) {
+        ret = PTR_ERR(tzd);
         dev_err(&pdev->dev, "Failed to register thermal zone: %d\n", ret);
         return ret;
     }
     dev_dbg(&pdev->dev, "Thermal zone registered successfully\n");
 
-    /* Store the sensor data in the platform device */
-    platform_set_drvdata(pdev, data);
-
     /* Create the sysfs file for "cur_temp" */
     ret = device_create_file(&pdev->dev, &dev_attr_cur_temp);
     if (ret) {
@@ -197,6 +178,10 @@ static int quectel_temp_probe(struct platform_device *pdev)
         return ret;
     }
 
+    mutex_lock(&sensor_lock);
+    sensor_tzd = tzd;
+    mutex_unlock(&sensor_lock);
+
     dev_info(&pdev->dev, "Quectel RM520N virtual sensor loaded\n");
     return 0;
 }
@@ -205,14 +190,18 @@ static int quectel_temp_probe(struct platform_device *pdev)
  * quectel_temp_remove - Remove function for virtual thermal sensor
  * @pdev: Platform device structure
  *
- * Cleans up the virtual thermal sensor by removing sysfs attributes
- * and logging the removal. Called when the module is unloaded.
+ * Stops core notifications before the managed thermal zone is released
+ * and removes the sysfs attribute.
  */
 static void quectel_temp_remove(struct platform_device *pdev)
 {
     if (!pdev)
         return;
 
+    mutex_lock(&sensor_lock);
+    sensor_tzd = NULL;
+    mutex_unlock(&sensor_lock);
+
     device_remove_file(&pdev->dev, &dev_attr_cur_temp);
     dev_info(&pdev->dev, "Quectel RM520N virtual sensor removed\n");
 }
@@ -235,14 +224,14 @@ static struct platform_driver quectel_temp_driver = {
 };
 
 /**
- * quectel_temp_init - Module initialization function
+ * quectel_sensor_init - Start the thermal sensor front-end
  *
- * Registers the platform driver with the kernel. Called when the
- * module is loaded.
+ * Registers the platform driver with the kernel. The zone is created
+ * when a matching Device Tree node binds.
  *
  * Return: 0 on success, negative error code on failure
  */
-static int __init quectel_rm520n_temp_sensor_init(void)
+int __init quectel_sensor_init(void)
 {
     int ret;
     
@@ -251,27 +240,23 @@ static int __init quectel_rm520n_temp_sensor_init(void)
         pr_err("QuectelTemp: Failed to register platform driver: %d\n", ret);
         return ret;
     }
-    
+
+    sensor_registered = true;
     pr_info("QuectelTemp: Platform driver registered successfully\n");
     return 0;
 }
 
 /**
- * quectel_temp_exit - Module exit function
+ * quectel_sensor_exit - Stop the thermal sensor front-end
  *
- * Unregisters the platform driver from the kernel. Called when the
- * module is unloaded.
+ * Unregisters the platform driver, which removes a bound zone.
  */
-static void __exit quectel_rm520n_temp_sensor_exit(void)
+void quectel_sensor_exit(void)
 {
+    if (!sensor_registered)
+        return;
+
     platform_driver_unregister(&quectel_temp_driver);
+    sensor_registered = false;
     pr_info("QuectelTemp: Platform driver unregistered\n");
 }
-
-module_init(quectel_rm520n_temp_sensor_init);
-module_exit(quectel_rm520n_temp_sensor_exit);
-
-MODULE_DESCRIPTION(KMOD_NAME " - Virtual Thermal Sensor Driver");
-MODULE_AUTHOR(KMOD_AUTHOR);
-MODULE_VERSION(KMOD_VERSION);
-MODULE_LICENSE(KMOD_LICENSE);
@@ -0,0 +1,262 @@
+/**
+ * @file logging.c
+ * @brief Asynchronous logging backend for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the optional asynchronous logging backend. The
+ * daemon's main thread formats a message into a fixed ring and wakes a
+ * writer thread through an eventfd; the writer thread makes the ulog()
+ * call that may block on logd or a remote syslog target. If the ring is
+ * full, the message is counted as dropped instead of waiting, so logging
+ * back-pressure never delays the sampling loop.
+ *
+ * The ring has one producer (the daemon's main thread) and one consumer
+ * (the writer thread), so the head and tail indices need no lock.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include "include/logging.h"
+
+/* ============================================================================
+ * STATE
+ * ============================================================================ */
+
+typedef struct {
+    int priority;
+    char msg[LOGGING_MSG_LEN];
+} logging_entry_t;
+
+bool logging_async_active = false;
+
+static int g_threshold = LOG_INFO;
+
+static logging_entry_t g_queue[LOGGING_QUEUE_SLOTS];
+static unsigned int g_head = 0;           /* Written by the producer */
+static unsigned int g_tail = 0;           /* Written by the writer thread */
+static unsigned long g_dropped = 0;       /* Written by the producer */
+static bool g_stop = false;
+static struct timespec g_stop_deadline;   /* Set before g_stop */
+static int g_event_fd = -1;
+static pthread_t g_writer;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * stop_expired - Check whether a stop request has run out of time
+ */
+static bool stop_expired(void)
+{
+    struct timespec now;
+
+    if (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > g_stop_deadline.tv_sec ||
+           (now.tv_sec == g_stop_deadline.tv_sec && now.tv_nsec >= g_stop_deadline.tv_nsec);
+}
+
+/**
+ * writer_drain - Pass all queued messages to ulog
+ * @reported: Drop count already reported, updated
+ *
+ * Once a stop request has expired, the rest of the queue is counted as
+ * dropped so a slow log target cannot hold up shutdown or re-exec.
+ */
+static void writer_drain(unsigned long *reported)
+{
+    unsigned int tail = g_tail;
+    unsigned int head = __atomic_load_n(&g_head, __ATOMIC_ACQUIRE);
+
+    while (tail != head) {
+        if (stop_expired()) {
+            __atomic_add_fetch(&g_dropped, head - tail, __ATOMIC_RELAXED);
+            __atomic_store_n(&g_tail, head, __ATOMIC_RELEASE);
+            break;
+        }
+
+        logging_entry_t *e = &g_queue[tail % LOGGING_QUEUE_SLOTS];
+        ulog(e->priority, "%s", e->msg);
+        tail++;
+        __atomic_store_n(&g_tail, tail, __ATOMIC_RELEASE);
+        head = __atomic_load_n(&g_head, __ATOMIC_ACQUIRE);
+    }
+
+    unsigned long dropped = __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+    if (dropped != *reported) {
+        ulog(LOG_WARNING, "Log queue full, %lu messages dropped (%lu total)",
+             dropped - *reported, dropped);
+        *reported = dropped;
+    }
+}
+
+/**
+ * writer_thread - Wait for queued messages and write them
+ */
+static void *writer_thread(void *arg)
+{
+    unsigned long reported = __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+    uint64_t events;
+
+    (void)arg;
+
+    for (;;) {
+        if (read(g_event_fd, &events, sizeof(events)) < 0 && errno != EINTR) {
+            break;
+        }
+        writer_drain(&reported);
+        if (__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+            writer_drain(&reported);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * logging_set_threshold - Set the lowest priority that is logged
+ * @threshold: syslog priority (LOG_DEBUG ... LOG_ERR)
+ */
+void logging_set_threshold(int threshold)
+{
+    g_threshold = threshold;
+    ulog_threshold(threshold);
+}
+
+/**
+ * logging_enqueue - Queue a message for the writer thread
+ * @priority: syslog priority
+ * @fmt: printf-style format
+ */
+void logging_enqueue(int priority, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (priority > g_threshold) {
+        return;
+    }
+
+    unsigned int head = g_head;
+    if (head - __atomic_load_n(&g_tail, __ATOMIC_ACQUIRE) >= LOGGING_QUEUE_SLOTS) {
+        __atomic_add_fetch(&g_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    logging_entry_t *e = &g_queue[head % LOGGING_QUEUE_SLOTS];
+    e->priority = priority;
+    va_start(ap, fmt);
+    vsnprintf(e->msg, sizeof(e->msg), fmt, ap);
+    va_end(ap);
+    __atomic_store_n(&g_head, head + 1, __ATOMIC_RELEASE);
+
+    /* Never blocks: the eventfd counter only saturates after 2^64 - 1 wakeups */
+    uint64_t one = 1;
+    if (write(g_event_fd, &one, sizeof(one)) < 0) {
+        /* The writer thread still drains on its next wakeup */
+    }
+}
+
+/**
+ * logging_async_start - Route log messages through the writer thread
+ *
+ * Return: 0 on success (or already running), -1 on error
+ */
+int logging_async_start(void)
+{
+    pthread_attr_t attr;
+    struct sched_param param = { .sched_priority = 0 };
+    sigset_t all, saved;
+
+    if (logging_async_active) {
+        return 0;
+    }
+
+    g_event_fd = eventfd(0, EFD_CLOEXEC);
+    if (g_event_fd < 0) {
+        return -1;
+    }
+
+    /* The writer runs at normal priority even if sampling is SCHED_FIFO */
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, LOGGING_WRITER_STACK);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+
+    /* Signals stay with the main thread so they interrupt its sleeps */
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+
+    g_stop = false;
+    int ret = pthread_create(&g_writer, &attr, writer_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        close(g_event_fd);
+        g_event_fd = -1;
+        errno = ret;
+        return -1;
+    }
+
+    logging_async_active = true;
+    return 0;
+}
+
+/**
+ * logging_async_stop - Write the queued messages and stop the writer thread
+ *
+ * Messages still queued after LOGGING_STOP_TIMEOUT_MS are dropped.
+ */
+void logging_async_stop(void)
+{
+    uint64_t one = 1;
+
+    if (!logging_async_active) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &g_stop_deadline);
+    g_stop_deadline.tv_sec += LOGGING_STOP_TIMEOUT_MS / 1000;
+    g_stop_deadline.tv_nsec += (LOGGING_STOP_TIMEOUT_MS % 1000) * 1000000L;
+    if (g_stop_deadline.tv_nsec >= 1000000000L) {
+        g_stop_deadline.tv_sec++;
+        g_stop_deadline.tv_nsec -= 1000000000L;
+    }
+    __atomic_store_n(&g_stop, true, __ATOMIC_RELEASE);
+    if (write(g_event_fd, &one, sizeof(one)) < 0) {
+        /* eventfd writes only fail on counter overflow */
+    }
+    pthread_join(g_writer, NULL);
+
+    close(g_event_fd);
+    g_event_fd = -1;
+    logging_async_active = false;
+}
+
+/**
+ * logging_async_dropped - Messages dropped because the queue was full
+ */
+unsigned long logging_async_dropped(void)
+{
+    return __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+}
@@ -66,6 +66,13 @@
 #include "include/daemon.h"
 
 #include "include/uci_config.h"
+#include "include/bench.h"
+#include "include/simulate.h"
+#include "include/state.h"
+#include "include/histogram.h"
+#include "include/snmp.h"
+#include "include/history.h"
+#include "include/admission.h"
 
 /* ============================================================================
  * CONSTANTS & CONFIGURATION
@@ -87,7 +94,16 @@ static bool json_output = false;
 bool verbose_output = false;  /* Shared with UI module */
 static bool celsius_output = false;
 static bool watch_mode = false;
+static int bench_count = BENCH_DEFAULT_COUNT;
+static char port_override[CONFIG_STRING_LEN] = {0};  /* --port, survives UCI reload */
+static speed_t baud_override = 0;                    /* --baud, 0 = not given */
+static const char *sim_trips = NULL;                 /* --trips, NULL = default */
+static const char *sim_hysteresis = NULL;            /* --hysteresis, NULL = default */
+static const char *sim_governor = NULL;              /* --governor, NULL = default */
+static bool history_export = false;                  /* --export */
+static uint64_t history_since = 0;                   /* --since, 0 = oldest sample */
 volatile sig_atomic_t shutdown_requested = 0;
+volatile sig_atomic_t reexec_requested = 0;
 
 /* ============================================================================
  * FUNCTION PROTOTYPES
@@ -136,17 +152,24 @@ int main(int argc, char *argv[])
         {"debug", no_argument, 0, 'd'},
         {"celsius", no_argument, 0, 'c'},
         {"watch", no_argument, 0, 'w'},
+        {"count", required_argument, 0, 'n'},
+        {"trips", required_argument, 0, 't'},
+        {"hysteresis", required_argument, 0, 'H'},
+        {"governor", required_argument, 0, 'g'},
+        {"export", no_argument, 0, 'e'},
+        {"since", required_argument, 0, 's'},
         {"version", no_argument, 0, 'V'},
 
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
     
-    while ((opt = getopt_long(argc, argv, "p:b:jhdVcwh", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:b:n:t:H:g:s:ejhdVcwh", long_options, NULL)) != -1) {
         switch (opt) {
             case 'p':
                 if (optarg) {
                 SAFE_STRNCPY(config.serial_port, optarg, sizeof(config.serial_port));
+                SAFE_STRNCPY(port_override, optarg, sizeof(port_override));
                 } else {
                     fprintf(stderr, "Error: --port requires an argument. Example: --port /dev/ttyUSB2\n");
                     fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
@@ -155,17 +178,53 @@ int main(int argc, char *argv[])
                 break;
             case 'b':
                 if (optarg) {
-                    if (config_parse_baud_rate(optarg, &config.baud_rate) != 0) {
+                    if (config_parse_baud_rate(optarg, &baud_override) != 0) {
                         fprintf(stderr, "Error: Invalid baud rate '%s'. Supported values: 9600, 19200, 38400, 57600, 115200\n", optarg);
                         fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
                         return 2;
                     }
+                    config.baud_rate = baud_override;
                 } else {
                     fprintf(stderr, "Error: --baud requires an argument. Example: --baud 115200\n");
                     fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
                     return 2;
                 }
                 break;
+            case 'n': {
+                char *endptr;
+                long count = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || count < 1 || count > BENCH_MAX_COUNT) {
+                    fprintf(stderr, "Error: Invalid count '%s'. Must be 1-%d\n", optarg, BENCH_MAX_COUNT);
+                    fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
+                    return 2;
+                }
+                bench_count = (int)count;
+                break;
+            }
+            case 't':
+                sim_trips = optarg;
+                break;
+            case 'H':
+                sim_hysteresis = optarg;
+                break;
+            case 'g':
+                sim_governor = optarg;
+                break;
+            case 'e':
+                history_export = true;
+                break;
+            case 's': {
+                char *endptr;
+                errno = 0;
+                unsigned long long since = strtoull(optarg, &endptr, 10);
+                if (errno != 0 || endptr == optarg || *endptr != '\0' || optarg[0] == '-') {
+                    fprintf(stderr, "Error: Invalid cursor '%s'. Example: --since 1234\n", optarg);
+                    fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
+                    return 2;
+                }
+                history_since = (uint64_t)since;
+                break;
+            }
             case 'j':
                 json_output = true;
                 break;
@@ -208,7 +267,7 @@ int main(int argc, char *argv[])
     } else {
         log_threshold = config_parse_log_level(config.log_level);
     }
-    ulog_threshold(log_threshold);
+    logging_set_threshold(log_threshold);
 
     // Check environment variables for CLI guidelines compliance
     check_environment_variables();
@@ -356,6 +415,43 @@ int main(int argc, char *argv[])
         }
     } else if (strcmp(command, "config") == 0) {
         return uci_config_mode();
+    } else if (strcmp(command, "bench") == 0) {
+        return bench_mode(port_override[0] ? port_override : config.serial_port,
+                          baud_override, bench_count, json_output);
+    } else if (strcmp(command, "simulate") == 0) {
+        if (optind + 1 >= argc) {
+            fprintf(stderr, "Error: simulate requires a trace file. Example: %s simulate trace.log\n", argv[0]);
+            fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
+            return 2;
+        }
+        return simulate_mode(argv[optind + 1], sim_trips, sim_hysteresis, sim_governor, json_output);
+    } else if (strcmp(command, "histogram") == 0) {
+        bool window = optind + 1 < argc && strcmp(argv[optind + 1], "window") == 0;
+        if (optind + 1 < argc && !window) {
+            fprintf(stderr, "Error: Unknown histogram view '%s'. Example: %s histogram window\n",
+                    argv[optind + 1], argv[0]);
+            fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
+            return 2;
+        }
+        return histogram_mode(&config, window, json_output);
+    } else if (strcmp(command, "snmp") == 0) {
+        return snmp_mode();
+    } else if (strcmp(command, "history") == 0) {
+        return history_mode(history_since, history_export, json_output);
+    } else if (strcmp(command, "admit") == 0) {
+        int duration = ADMISSION_DEFAULT_DURATION;
+        if (optind + 1 < argc) {
+            char *endptr;
+            long value = strtol(argv[optind + 1], &endptr, 10);
+            if (endptr == argv[optind + 1] || *endptr != '\0' || value < 0 || value > ADMISSION_DURATION_MAX) {
+                fprintf(stderr, "Error: Invalid duration '%s'. Must be 0-%d seconds\n",
+                        argv[optind + 1], ADMISSION_DURATION_MAX);
+                fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
+                return 2;
+            }
+            duration = (int)value;
+        }
+        return admission_mode(&config, duration, json_output);
     } else if (strcmp(command, "status") == 0) {
         // Status command - check daemon running state and show system info
         int daemon_status = check_daemon_running();
@@ -364,7 +460,7 @@ int main(int argc, char *argv[])
             printf("Status: running\n");
 
             // Try to read PID
-            FILE *pid_file = fopen("/var/run/quectel_rm520n_temp.pid", "r");
+            FILE *pid_file = sys_fopen(PID_FILE, "r");
             if (pid_file) {
                 int pid;
                 if (fscanf(pid_file, "%d", &pid) == 1) {
@@ -374,8 +470,8 @@ int main(int argc, char *argv[])
             }
 
             // Show current temperature if available
-            if (access("/sys/kernel/quectel_rm520n_thermal/temp", R_OK) == 0) {
-                FILE *temp_fp = fopen("/sys/kernel/quectel_rm520n_thermal/temp", "r");
+            if (sys_access("/sys/kernel/quectel_rm520n_thermal/temp", R_OK) == 0) {
+                FILE *temp_fp = sys_fopen("/sys/kernel/quectel_rm520n_thermal/temp", "r");
                 if (temp_fp) {
                     char temp[SMALL_BUFFER_LEN];
                     if (fgets(temp, sizeof(temp), temp_fp) != NULL) {
@@ -387,9 +483,48 @@ int main(int argc, char *argv[])
                 }
             }
 
+            // Show whether the current value is a board-sensor estimate
+            FILE *source_fp = sys_fopen("/sys/kernel/quectel_rm520n_thermal/temp_source", "r");
+            if (source_fp) {
+                char source[SMALL_BUFFER_LEN];
+                if (fgets(source, sizeof(source), source_fp) != NULL) {
+                    STRIP_NEWLINE(source);
+                    printf("Source: %s\n", source);
+                }
+                fclose(source_fp);
+            }
+
+            // Show the thermal headroom published by the daemon
+            char headroom[STATE_VALUE_LEN], level[STATE_VALUE_LEN];
+            if (state_read("headroom", headroom, sizeof(headroom)) == 0 &&
+                state_read("headroom_level", level, sizeof(level)) == 0) {
+                printf("Headroom: %s (%s)\n", headroom, level);
+            }
+
+            // Show the percentiles of the daemon's sliding window
+            static const char *const sensors[] = { "modem", "ap", "pa" };
+            char window[STATE_VALUE_LEN];
+            if (state_read("quantile_window", window, sizeof(window)) == 0) {
+                printf("Percentiles over %s s (p50/p95/p99):", window);
+                for (size_t i = 0; i < sizeof(sensors) / sizeof(sensors[0]); i++) {
+                    char key[STATE_KEY_LEN], p50[STATE_VALUE_LEN] = "", p95[STATE_VALUE_LEN] = "",
+                         p99[STATE_VALUE_LEN] = "";
+                    snprintf(key, sizeof(key), "p50_%s", sensors[i]);
+                    state_read(key, p50, sizeof(p50));
+                    snprintf(key, sizeof(key), "p95_%s", sensors[i]);
+                    state_read(key, p95, sizeof(p95));
+                    snprintf(key, sizeof(key), "p99_%s", sensors[i]);
+                    state_read(key, p99, sizeof(p99));
+                    if (p50[0]) {
+                        printf(" %s %s/%s/%s°C", sensors[i], p50, p95, p99);
+                    }
+                }
+                printf("\n");
+            }
+
             // Show statistics from kernel module
-            if (access("/sys/kernel/quectel_rm520n_thermal/stats", R_OK) == 0) {
-                FILE *stats_fp = fopen("/sys/kernel/quectel_rm520n_thermal/stats", "r");
+            if (sys_access("/sys/kernel/quectel_rm520n_thermal/stats", R_OK) == 0) {
+                FILE *stats_fp = sys_fopen("/sys/kernel/quectel_rm520n_thermal/stats", "r");
                 if (stats_fp) {
                     char stats_line[256];
                     printf("\nKernel module statistics:\n");
@@ -401,18 +536,27 @@ int main(int argc, char *argv[])
                 }
             }
 
-            // Show kernel modules status
-            FILE *modules = fopen("/proc/modules", "r");
-            if (modules) {
-                char line[PATH_MAX_LEN];
-                int module_count = 0;
-                while (fgets(line, sizeof(line), modules)) {
-                    if (strstr(line, "quectel_rm520n_temp")) {
-                        module_count++;
+            // Show kernel module status and the front-ends it was loaded with
+            if (sys_access("/sys/module/quectel_rm520n_temp", F_OK) == 0) {
+                static const char *const frontends[] = { "sysfs", "thermal", "hwmon" };
+                printf("Kernel module: loaded (");
+                for (size_t i = 0; i < sizeof(frontends) / sizeof(frontends[0]); i++) {
+                    char param_path[PATH_MAX_LEN];
+                    char value[8] = "";
+                    snprintf(param_path, sizeof(param_path),
+                             "/sys/module/quectel_rm520n_temp/parameters/enable_%s", frontends[i]);
+                    FILE *param_fp = sys_fopen(param_path, "r");
+                    if (param_fp) {
+                        if (!fgets(value, sizeof(value), param_fp)) {
+                            value[0] = '\0';
+                        }
+                        fclose(param_fp);
                     }
+                    printf("%s%s=%s", i ? ", " : "", frontends[i], value[0] == 'Y' ? "on" : "off");
                 }
-                printf("Kernel modules: %d loaded\n", module_count);
-                fclose(modules);
+                printf(")\n");
+            } else {
+                printf("Kernel module: not loaded\n");
             }
 
             return 0;
@@ -426,7 +570,7 @@ int main(int argc, char *argv[])
             return 1;
         }
     } else {
-        fprintf(stderr, "Error: Unknown command '%s'. Valid commands: 'read' (default), 'daemon', 'config', or 'status'\n", command);
+        fprintf(stderr, "Error: Unknown command '%s'. Valid commands: 'read' (default), 'daemon', 'config', 'status', 'bench', 'simulate', 'histogram', 'snmp', 'history' or 'admit'\n", command);
         fprintf(stderr, "Try '%s --help' for more information\n", argv[0]);
         return 2;
     }
@@ -0,0 +1,441 @@
+/**
+ * @file recovery.c
+ * @brief Modem recovery ladder for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the escalating recovery for a modem that stopped
+ * answering: port reopen, AT+CFUN=1,1 through another AT port, USB
+ * unbind/rebind and a power-GPIO cycle. Each step gets its own timeout to
+ * produce a good sample before the next one is taken; counters per step
+ * are logged with the statistics and published to the state file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/atport.h"
+#include "include/state.h"
+#include "include/recovery.h"
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define USB_UNBIND_PATH  "/sys/bus/usb/drivers/usb/unbind"
+#define USB_BIND_PATH    "/sys/bus/usb/drivers/usb/bind"
+#define GPIO_EXPORT_PATH "/sys/class/gpio/export"
+#define RESET_RESPONSE_LEN 256
+
+static const char *const g_step_names[RECOVERY_STEPS] = {
+    "none", "reopen", "reset", "usb", "power"
+};
+
+static recovery_state_t g_state;
+static int g_timeout[RECOVERY_STEPS];
+static char g_usb_device[CONFIG_STRING_LEN];
+static char g_power_gpio[CONFIG_STRING_LEN];
+static bool g_power_active_low;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Write a string to a sysfs attribute
+ * @param path Attribute path
+ * @param value String to write
+ *
+ * @return 0 on success, -1 on error
+ */
+static int write_sysfs_string(const char *path, const char *value)
+{
+    FILE *fp = sys_fopen(path, "w");
+    if (!fp) {
+        logging_warning("Cannot open %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    int ok = fputs(value, fp) >= 0;
+    if (fclose(fp) != 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        logging_warning("Failed to write '%s' to %s: %s", value, path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Make the power GPIO an output without cutting power
+ * @param value_path Value file of the GPIO
+ *
+ * A freshly exported GPIO is an input, which ignores writes to its value.
+ * The direction is switched with the powered level preset, so the modem
+ * does not see a glitch. Value files without a sibling direction file are
+ * left alone.
+ *
+ * @return 0 on success, -1 on error
+ */
+static int gpio_set_output(const char *value_path)
+{
+    char path[PATH_MAX_LEN];
+    char direction[SMALL_BUFFER_LEN] = "";
+    const char *slash = strrchr(value_path, '/');
+
+    if (!slash || strcmp(slash, "/value") != 0 ||
+        snprintf(path, sizeof(path), "%.*s/direction",
+                 (int)(slash - value_path), value_path) >= (int)sizeof(path)) {
+        return 0;
+    }
+
+    FILE *fp = sys_fopen(path, "r");
+    if (!fp) {
+        return 0;
+    }
+    if (!fgets(direction, sizeof(direction), fp)) {
+        direction[0] = '\0';
+    }
+    fclose(fp);
+
+    if (strncmp(direction, "out", 3) == 0) {
+        return 0;
+    }
+    return write_sysfs_string(path, g_power_active_low ? "low" : "high");
+}
+
+/**
+ * Resolve power_gpio to its value file
+ * @param buf Output buffer
+ * @param size Size of buf
+ *
+ * A bare GPIO number is exported through the legacy sysfs interface if
+ * needed; anything else is used as the path of a value file. Either way
+ * the GPIO is made an output before it is used.
+ *
+ * @return 0 on success, -1 on error
+ */
+static int gpio_value_path(char *buf, size_t size)
+{
+    if (!isdigit((unsigned char)g_power_gpio[0])) {
+        snprintf(buf, size, "%s", g_power_gpio);
+        return gpio_set_output(buf);
+    }
+
+    if (snprintf(buf, size, "/sys/class/gpio/gpio%s/value", g_power_gpio) >= (int)size) {
+        return -1;
+    }
+    if (sys_access(buf, W_OK) != 0 && write_sysfs_string(GPIO_EXPORT_PATH, g_power_gpio) != 0) {
+        return -1;
+    }
+    return gpio_set_output(buf);
+}
+
+/**
+ * Reboot the modem with AT+CFUN=1,1
+ *
+ * @return 0 if the modem accepted the command, -1 otherwise
+ */
+static int run_reset(void)
+{
+    char response[RESET_RESPONSE_LEN];
+
+    if (atport_command_other(RECOVERY_RESET_COMMAND, response, sizeof(response)) <= 0 ||
+        !strstr(response, "OK")) {
+        logging_warning("Modem did not accept AT+CFUN=1,1 on any AT port");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Unbind and rebind the modem's USB device
+ *
+ * @return 0 on success, -1 on error
+ */
+static int run_usb(void)
+{
+    if (write_sysfs_string(USB_UNBIND_PATH, g_usb_device) != 0) {
+        return -1;
+    }
+    sys_sleep(RECOVERY_USB_OFF_SEC);
+    return write_sysfs_string(USB_BIND_PATH, g_usb_device);
+}
+
+/**
+ * Switch the modem's power GPIO off and on again
+ *
+ * With power_gpio_active_low the modem is powered while the line is low.
+ *
+ * @return 0 on success, -1 on error
+ */
+static int run_power(void)
+{
+    char path[PATH_MAX_LEN];
+    const char *off = g_power_active_low ? "1" : "0";
+    const char *on = g_power_active_low ? "0" : "1";
+
+    if (gpio_value_path(path, sizeof(path)) != 0 ||
+        write_sysfs_string(path, off) != 0) {
+        return -1;
+    }
+    sys_sleep(RECOVERY_POWER_OFF_SEC);
+    return write_sysfs_string(path, on);
+}
+
+/**
+ * Check whether a step is configured
+ * @param step Recovery step
+ * @return true if the step can be taken
+ */
+static bool step_available(int step)
+{
+    switch (step) {
+        case RECOVERY_USB:
+            return g_usb_device[0] != '\0';
+        case RECOVERY_POWER:
+            return g_power_gpio[0] != '\0';
+        default:
+            return true;
+    }
+}
+
+/**
+ * Timeout of a step in the current round
+ * @param step Recovery step
+ * @return Timeout in seconds, doubled per round up to RECOVERY_TIMEOUT_MAX
+ */
+static int step_timeout(int step)
+{
+    long timeout = g_timeout[step];
+
+    for (int i = 0; i < g_state.round && timeout < RECOVERY_TIMEOUT_MAX; i++) {
+        timeout *= 2;
+    }
+    return (timeout > RECOVERY_TIMEOUT_MAX) ? RECOVERY_TIMEOUT_MAX : (int)timeout;
+}
+
+/**
+ * Write the ladder state and counters to the state file
+ */
+static void publish(void)
+{
+    char key[STATE_KEY_LEN];
+
+    state_set("recovery_step", "%s", g_step_names[g_state.step]);
+    for (int i = RECOVERY_REOPEN; i < RECOVERY_STEPS; i++) {
+        snprintf(key, sizeof(key), "recovery_attempts_%s", g_step_names[i]);
+        state_set(key, "%u", g_state.attempts[i]);
+        snprintf(key, sizeof(key), "recovery_recovered_%s", g_step_names[i]);
+        state_set(key, "%u", g_state.recovered[i]);
+    }
+    state_set("recovery_last_outage", "%lld", (long long)g_state.last_outage);
+    state_flush();
+}
+
+/**
+ * Take the next available recovery step after a given one
+ * @param from Step that timed out or failed (RECOVERY_NONE to start the ladder)
+ *
+ * Steps that cannot be taken are skipped; after the last step the ladder
+ * starts over with doubled timeouts.
+ */
+static void start_step(int from)
+{
+    int step = from;
+    time_t now = sys_time();
+
+    for (;;) {
+        if (++step >= RECOVERY_STEPS) {
+            step = RECOVERY_REOPEN;
+            g_state.round++;
+            logging_warning("Modem still not answering after %lld s, restarting recovery (round %d)",
+                           (long long)(now - g_state.outage_start), g_state.round + 1);
+        }
+        if (!step_available(step)) {
+            continue;
+        }
+
+        g_state.step = step;
+        g_state.attempts[step]++;
+        g_state.deadline = now + step_timeout(step);
+        logging_warning("Modem recovery: %s (attempt %u, timeout %d s)",
+                       g_step_names[step], g_state.attempts[step], step_timeout(step));
+
+        /* The reset goes out through the open ports; all steps end with them closed */
+        int ret = 0;
+        switch (step) {
+            case RECOVERY_RESET:
+                ret = run_reset();
+                break;
+            case RECOVERY_USB:
+                atport_close_all();
+                ret = run_usb();
+                break;
+            case RECOVERY_POWER:
+                atport_close_all();
+                ret = run_power();
+                break;
+            default:
+                break;
+        }
+        atport_close_all();
+
+        if (ret == 0 || shutdown_requested) {
+            break;
+        }
+        logging_warning("Modem recovery step %s failed, escalating", g_step_names[step]);
+        now = sys_time();
+    }
+
+    publish();
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * Apply the per-step timeouts and recovery targets
+ * @param cfg Configuration
+ */
+void recovery_configure(const config_t *cfg)
+{
+    g_timeout[RECOVERY_REOPEN] = cfg->recovery_reopen_timeout;
+    g_timeout[RECOVERY_RESET] = cfg->recovery_reset_timeout;
+    g_timeout[RECOVERY_USB] = cfg->recovery_usb_timeout;
+    g_timeout[RECOVERY_POWER] = cfg->recovery_power_timeout;
+    snprintf(g_usb_device, sizeof(g_usb_device), "%s", cfg->usb_device);
+    snprintf(g_power_gpio, sizeof(g_power_gpio), "%s", cfg->power_gpio);
+    g_power_active_low = cfg->power_gpio_active_low != 0;
+
+    /* A step that is no longer configured ends at its current deadline */
+    publish();
+}
+
+/**
+ * Account a sample the modem could not deliver
+ */
+void recovery_failure(void)
+{
+    time_t now = sys_time();
+
+    if (g_state.outage_start == 0) {
+        g_state.outage_start = now;
+        g_state.failures = 0;
+        g_state.round = 0;
+    }
+    g_state.failures++;
+
+    if (g_state.step == RECOVERY_NONE) {
+        if (g_state.failures >= RECOVERY_TRIGGER_FAILURES) {
+            start_step(RECOVERY_NONE);
+        }
+        return;
+    }
+
+    if (now >= g_state.deadline) {
+        logging_warning("Modem recovery step %s timed out", g_step_names[g_state.step]);
+        start_step(g_state.step);
+    }
+}
+
+/**
+ * Account a successful modem read, ending an outage
+ */
+void recovery_success(void)
+{
+    if (g_state.outage_start == 0) {
+        return;
+    }
+
+    if (g_state.step != RECOVERY_NONE) {
+        g_state.recovered[g_state.step]++;
+        g_state.last_outage = sys_time() - g_state.outage_start;
+        logging_info("Modem answering again after %lld s (recovered by %s)",
+                    (long long)g_state.last_outage, g_step_names[g_state.step]);
+    }
+
+    g_state.step = RECOVERY_NONE;
+    g_state.failures = 0;
+    g_state.round = 0;
+    g_state.outage_start = 0;
+    g_state.deadline = 0;
+    publish();
+}
+
+/**
+ * Limit a retry delay while a step is in progress
+ * @param delay Wanted delay in seconds
+ *
+ * During a step the ports are retried every RECOVERY_RETRY_SEC, so a modem
+ * that comes back is picked up quickly, and never past the step deadline.
+ *
+ * @return Delay in seconds (at least 1)
+ */
+int recovery_delay(int delay)
+{
+    if (g_state.step != RECOVERY_NONE) {
+        time_t left = g_state.deadline - sys_time();
+        if (delay > RECOVERY_RETRY_SEC) {
+            delay = RECOVERY_RETRY_SEC;
+        }
+        if (left < delay) {
+            delay = (int)left;
+        }
+    }
+    return (delay < 1) ? 1 : delay;
+}
+
+/**
+ * Log the per-step counters
+ */
+void recovery_log_stats(void)
+{
+    unsigned long total = 0;
+
+    for (int i = RECOVERY_REOPEN; i < RECOVERY_STEPS; i++) {
+        total += g_state.attempts[i];
+    }
+    if (total == 0) {
+        return;
+    }
+
+    logging_info("Modem recovery: reopen=%u/%u, reset=%u/%u, usb=%u/%u, power=%u/%u "
+                "(recovered/attempts), last outage %lld s",
+                g_state.recovered[RECOVERY_REOPEN], g_state.attempts[RECOVERY_REOPEN],
+                g_state.recovered[RECOVERY_RESET], g_state.attempts[RECOVERY_RESET],
+                g_state.recovered[RECOVERY_USB], g_state.attempts[RECOVERY_USB],
+                g_state.recovered[RECOVERY_POWER], g_state.attempts[RECOVERY_POWER],
+                (long long)g_state.last_outage);
+}
+
+/**
+ * Ladder state for a re-exec handoff
+ * @return Pointer to the internal state
+ */
+recovery_state_t *recovery_state(void)
+{
+    return &g_state;
+}
+
+/**
+ * Continue the ladder of a previous image
+ * @param state State handed over by the previous image
+ */
+void recovery_import(const recovery_state_t *state)
+{
+    if (state->step < RECOVERY_NONE || state->step >= RECOVERY_STEPS) {
+        return;
+    }
+    g_state = *state;
+    publish();
+}
@@ -0,0 +1,415 @@
+/**
+ * @file rules.c
+ * @brief Reaction rule engine for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the daemon's reaction rules ("PA above 70°C for
+ * 30 s", "rising faster than 2°C/min", "above 80°C in 3 samples within
+ * 5 min"). Every rule keeps constant-size state that is updated once per
+ * sample:
+ *
+ * - duration rules remember when the value last crossed the threshold
+ * - rate rules keep an exponentially smoothed derivative of the published
+ *   temperature, with the rule's window as time constant
+ * - count rules keep the timestamps of their last 'count' matches in a
+ *   ring, so "count matches within window" is a single comparison
+ *
+ * A rule fires once, then stays active until the value is back across the
+ * threshold by the hysteresis, and does not fire again within its cooldown.
+ * Actions run through /bin/sh in a child process that is reaped with
+ * WNOHANG, so a slow script never delays sampling.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/rules.h"
+#include "include/headroom.h"
+
+extern char **environ;
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define RULE_ENV_VARS    5       /* Variables added to the action environment */
+#define RULE_ENV_LEN     96
+#define RULE_FD_CLOSE_MAX 1024   /* Descriptors closed in the action child */
+
+typedef struct {
+    rule_config_t cfg;
+    bool active;                 /* Fired and not yet cleared */
+    time_t cond_since;           /* Start of the current run past the threshold, 0 = none */
+    time_t last_fired;           /* 0 = never */
+    unsigned long fired;
+    pid_t pid;                   /* Running action, 0 = none */
+    /* count rules: timestamps of the last matches (ring) */
+    time_t matches[RULE_COUNT_MAX];
+    int match_head;
+    int match_count;
+    /* rate rules: smoothed derivative of the published temperature */
+    bool have_prev;
+    int prev_mdeg;
+    time_t prev_time;
+    double rate;                 /* m°C per minute */
+} rule_state_t;
+
+static rule_state_t g_rules[MAX_RULES];
+static int g_rule_count = 0;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * rule_value - Value of a rule's metric for this sample
+ * @r: Rule
+ * @s: Sample
+ * @now: Daemon clock
+ * @value: Metric value (m°C, m°C/min for rate)
+ *
+ * Return: false if the metric is not available for this sample
+ */
+static bool rule_value(rule_state_t *r, const rules_sample_t *s, time_t now, int *value)
+{
+    switch (r->cfg.metric) {
+    case RULE_METRIC_MODEM:
+        *value = s->modem_mdeg;
+        return s->has_modem;
+    case RULE_METRIC_AP:
+        *value = s->ap_mdeg;
+        return s->has_ap;
+    case RULE_METRIC_PA:
+        *value = s->pa_mdeg;
+        return s->has_pa;
+    case RULE_METRIC_RATE: {
+        bool valid = r->have_prev && now > r->prev_time;
+        if (valid) {
+            double dt = (double)(now - r->prev_time);
+            double slope = (s->temp_mdeg - r->prev_mdeg) * 60.0 / dt;
+            double alpha = r->cfg.window > 0 ? dt / (r->cfg.window + dt) : 1.0;
+            r->rate += alpha * (slope - r->rate);
+        }
+        if (!r->have_prev || now > r->prev_time) {
+            r->prev_mdeg = s->temp_mdeg;
+            r->prev_time = now;
+            r->have_prev = true;
+        }
+        *value = (int)r->rate;
+        return valid;
+    }
+    case RULE_METRIC_HEADROOM: {
+        const headroom_t *h = headroom_get();
+        *value = h->score * 1000;
+        return h->score >= 0;
+    }
+    default:
+        *value = s->temp_mdeg;
+        return true;
+    }
+}
+
+/**
+ * rule_run_action - Start a rule action without waiting for it
+ * @r: Rule
+ * @command: Shell command
+ * @event: "fire" or "clear"
+ * @value: Metric value that triggered the event
+ * @s: Sample
+ *
+ * The environment is prepared before fork() so the child only calls
+ * async-signal-safe functions until exec.
+ */
+static void rule_run_action(rule_state_t *r, const char *command, const char *event,
+                            int value, const rules_sample_t *s)
+{
+    static const char *const own[] = {
+        "QUECTEL_RULE=", "QUECTEL_EVENT=", "QUECTEL_VALUE=", "QUECTEL_TEMP=", "QUECTEL_ESTIMATED="
+    };
+    char vars[RULE_ENV_VARS][RULE_ENV_LEN];
+    size_t env_count = 0;
+
+    if (r->pid > 0) {
+        logging_warning("Rule '%s': previous action (pid %d) still running, not starting '%s' action",
+                        r->cfg.name, (int)r->pid, event);
+        return;
+    }
+
+    while (environ && environ[env_count]) {
+        env_count++;
+    }
+    char **envp = calloc(env_count + RULE_ENV_VARS + 1, sizeof(*envp));
+    if (!envp) {
+        logging_error("Rule '%s': out of memory starting action", r->cfg.name);
+        return;
+    }
+
+    snprintf(vars[0], sizeof(vars[0]), "QUECTEL_RULE=%s", r->cfg.name);
+    snprintf(vars[1], sizeof(vars[1]), "QUECTEL_EVENT=%s", event);
+    snprintf(vars[2], sizeof(vars[2]), "QUECTEL_VALUE=%.1f", value / 1000.0);
+    snprintf(vars[3], sizeof(vars[3]), "QUECTEL_TEMP=%.1f", s->temp_mdeg / 1000.0);
+    snprintf(vars[4], sizeof(vars[4]), "QUECTEL_ESTIMATED=%d", s->estimated ? 1 : 0);
+
+    size_t n = 0;
+    for (size_t i = 0; i < RULE_ENV_VARS; i++) {
+        envp[n++] = vars[i];
+    }
+    for (size_t i = 0; i < env_count; i++) {
+        bool shadowed = false;
+        for (size_t j = 0; j < RULE_ENV_VARS; j++) {
+            if (strncmp(environ[i], own[j], strlen(own[j])) == 0) {
+                shadowed = true;
+            }
+        }
+        if (!shadowed) {
+            envp[n++] = environ[i];
+        }
+    }
+    envp[n] = NULL;
+
+    char *const argv[] = { "sh", "-c", (char *)command, NULL };
+    long fd_max = sysconf(_SC_OPEN_MAX);
+    if (fd_max < 0 || fd_max > RULE_FD_CLOSE_MAX) {
+        fd_max = RULE_FD_CLOSE_MAX;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        /* Child: default signal state, no inherited ports, sockets or locks */
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, NULL);
+        for (int fd = 3; fd < fd_max; fd++) {
+            close(fd);
+        }
+        execve("/bin/sh", argv, envp);
+        _exit(127);
+    }
+    free(envp);
+
+    if (pid < 0) {
+        logging_error("Rule '%s': cannot start action: %s", r->cfg.name, strerror(errno));
+        return;
+    }
+
+    r->pid = pid;
+    logging_debug("Rule '%s': %s action started (pid %d)", r->cfg.name, event, (int)pid);
+}
+
+/**
+ * rule_evaluate - Update one rule with a new sample
+ * @r: Rule
+ * @s: Sample
+ * @now: Daemon clock
+ */
+static void rule_evaluate(rule_state_t *r, const rules_sample_t *s, time_t now)
+{
+    const rule_config_t *c = &r->cfg;
+    int value;
+
+    if (!rule_value(r, s, now, &value)) {
+        return;
+    }
+
+    bool past = c->above ? value > c->threshold : value < c->threshold;
+    bool cleared = c->above ? value <= c->threshold - c->hysteresis
+                            : value >= c->threshold + c->hysteresis;
+    bool matched;
+
+    if (c->count > 0) {
+        if (past) {
+            r->matches[r->match_head] = now;
+            r->match_head = (r->match_head + 1) % RULE_COUNT_MAX;
+            if (r->match_count < RULE_COUNT_MAX) {
+                r->match_count++;
+            }
+        }
+        /* Oldest of the last 'count' matches must lie within the window */
+        int oldest = (r->match_head - c->count + RULE_COUNT_MAX) % RULE_COUNT_MAX;
+        matched = r->match_count >= c->count && now - r->matches[oldest] <= c->window;
+    } else {
+        if (past && r->cond_since == 0) {
+            r->cond_since = now;
+        } else if (!past) {
+            r->cond_since = 0;
+        }
+        matched = past && now - r->cond_since >= c->duration;
+    }
+
+    if (r->active) {
+        if (cleared) {
+            r->active = false;
+            r->match_count = 0;
+            logging_info("Rule '%s' cleared (%.1f)", c->name, value / 1000.0);
+            if (c->clear_action[0]) {
+                rule_run_action(r, c->clear_action, "clear", value, s);
+            }
+        }
+        return;
+    }
+
+    if (!matched) {
+        return;
+    }
+
+    if (r->last_fired != 0 && now - r->last_fired < c->cooldown) {
+        logging_debug("Rule '%s' matched during cooldown (%lds left)",
+                      c->name, (long)(c->cooldown - (now - r->last_fired)));
+        return;
+    }
+
+    r->active = true;
+    r->last_fired = now;
+    r->fired++;
+    logging_warning("Rule '%s' fired (%.1f %s %.1f%s)", c->name, value / 1000.0,
+                    c->above ? ">" : "<", c->threshold / 1000.0,
+                    s->estimated ? ", estimated" : "");
+    if (c->action[0]) {
+        rule_run_action(r, c->action, "fire", value, s);
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * rules_configure - Apply the configured rules
+ */
+void rules_configure(const config_t *cfg)
+{
+    rule_state_t previous[MAX_RULES];
+    int previous_count = g_rule_count;
+    memcpy(previous, g_rules, sizeof(previous));
+
+    g_rule_count = 0;
+    for (int i = 0; i < cfg->rule_count && i < MAX_RULES; i++) {
+        rule_state_t *r = &g_rules[g_rule_count++];
+        memset(r, 0, sizeof(*r));
+        r->cfg = cfg->rules[i];
+
+        for (int j = 0; j < previous_count; j++) {
+            if (strcmp(previous[j].cfg.name, cfg->rules[i].name) != 0) {
+                continue;
+            }
+            if (memcmp(&previous[j].cfg, &cfg->rules[i], sizeof(rule_config_t)) == 0) {
+                *r = previous[j];
+            } else {
+                /* Redefined: start over, but keep the counter and a running action */
+                r->pid = previous[j].pid;
+                r->fired = previous[j].fired;
+            }
+            break;
+        }
+    }
+
+    if (g_rule_count > 0) {
+        logging_info("%d reaction rule%s active", g_rule_count, g_rule_count == 1 ? "" : "s");
+    }
+}
+
+/**
+ * rules_evaluate - Evaluate all rules on a new sample
+ */
+void rules_evaluate(const rules_sample_t *sample)
+{
+    if (g_rule_count == 0) {
+        return;
+    }
+
+    time_t now = sys_time();
+    for (int i = 0; i < g_rule_count; i++) {
+        rule_evaluate(&g_rules[i], sample, now);
+    }
+}
+
+/**
+ * rules_reap - Reap finished actions without blocking
+ *
+ * Uses waitpid(-1) so actions started by a previous image before a re-exec
+ * are reaped as well.
+ */
+void rules_reap(void)
+{
+    int status;
+    pid_t pid;
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        const char *name = "(previous image)";
+        for (int i = 0; i < g_rule_count; i++) {
+            if (g_rules[i].pid == pid) {
+                g_rules[i].pid = 0;
+                name = g_rules[i].cfg.name;
+                break;
+            }
+        }
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            logging_debug("Rule %s action (pid %d) finished", name, (int)pid);
+        } else if (WIFEXITED(status)) {
+            logging_warning("Rule %s action (pid %d) exited with status %d",
+                            name, (int)pid, WEXITSTATUS(status));
+        } else if (WIFSIGNALED(status)) {
+            logging_warning("Rule %s action (pid %d) killed by signal %d",
+                            name, (int)pid, WTERMSIG(status));
+        }
+    }
+}
+
+/**
+ * rules_log_stats - Log per-rule firing counters
+ */
+void rules_log_stats(void)
+{
+    for (int i = 0; i < g_rule_count; i++) {
+        const rule_state_t *r = &g_rules[i];
+        logging_info("Rule '%s': fired=%lu, %s", r->cfg.name, r->fired,
+                     r->active ? "active" : "idle");
+    }
+}
+
+/**
+ * rules_export - Describe rule state for a re-exec handoff
+ */
+void rules_export(handoff_rules_t *state)
+{
+    memset(state, 0, sizeof(*state));
+    for (int i = 0; i < g_rule_count && i < HANDOFF_MAX_RULES; i++) {
+        const rule_state_t *r = &g_rules[i];
+        handoff_rule_t *h = &state->rules[state->count++];
+        memcpy(h->name, r->cfg.name, sizeof(h->name) - 1);
+        h->active = r->active;
+        h->fired = (int32_t)r->fired;
+        h->last_fired = (int64_t)r->last_fired;
+        h->cond_since = (int64_t)r->cond_since;
+    }
+}
+
+/**
+ * rules_import - Take over rule state from a previous image
+ */
+void rules_import(const handoff_rules_t *state)
+{
+    for (uint32_t i = 0; i < state->count && i < HANDOFF_MAX_RULES; i++) {
+        const handoff_rule_t *h = &state->rules[i];
+        for (int j = 0; j < g_rule_count; j++) {
+            rule_state_t *r = &g_rules[j];
+            if (strncmp(r->cfg.name, h->name, sizeof(h->name)) == 0) {
+                r->active = h->active != 0;
+                r->fired = (unsigned long)h->fired;
+                r->last_fired = (time_t)h->last_fired;
+                r->cond_since = (time_t)h->cond_since;
+                break;
+            }
+        }
+    }
+}
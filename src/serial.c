@@ -7,6 +7,13 @@
  * 
  * This module provides common serial communication functions used by
  * both the daemon and CLI tools for AT command communication.
+ *
+ * Network endpoints (tcp://, rfc2217://) use the same calls. Their
+ * descriptors are sockets, so termios does not apply: the line settings
+ * are sent as RFC 2217 subnegotiations instead, Telnet commands are
+ * stripped from the input, and a closed connection is reported as an
+ * error so the caller reconnects. A connection stays open across AT
+ * transactions and is handed over on re-exec like a tty.
  */
 
 #include <stdio.h>
@@ -17,7 +24,13 @@
 #include <termios.h>
 #include <errno.h>
 #include <time.h>
+#include <ctype.h>
+#include <netdb.h>
 #include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "include/logging.h"
 #include "include/serial.h"
 #include "include/system.h"
 
@@ -27,6 +40,56 @@
 /* Buffer size constants */
 #define MIN_BUFFER_SIZE 64
 #define MAX_BUFFER_SIZE 4096
+#define MAX_COMMAND_LEN 256
+
+/* Telnet (RFC 854) and COM port option (RFC 2217) */
+#define TELNET_SE              240
+#define TELNET_SB              250
+#define TELNET_WILL            251
+#define TELNET_WONT            252
+#define TELNET_DO              253
+#define TELNET_DONT            254
+#define TELNET_IAC             255
+#define TELOPT_BINARY          0
+#define TELOPT_SGA             3
+#define TELOPT_COM_PORT        44
+#define COM_PORT_SET_BAUDRATE  1
+#define COM_PORT_SET_DATASIZE  2
+#define COM_PORT_SET_PARITY    3
+#define COM_PORT_SET_STOPSIZE  4
+#define COM_PORT_SET_CONTROL   5
+#define COM_PORT_PARITY_NONE   1
+#define COM_PORT_STOPSIZE_1    1
+#define COM_PORT_CONTROL_NONE  1
+
+/* Telnet parser states */
+enum {
+    IAC_DATA = 0,
+    IAC_COMMAND,                 /* After IAC */
+    IAC_OPTION,                  /* After IAC WILL/WONT/DO/DONT */
+    IAC_SUB,                     /* Inside IAC SB ... */
+    IAC_SUB_IAC                  /* IAC inside a subnegotiation */
+};
+
+/* Option replies already sent (bit per verb), so negotiation cannot loop */
+#define SENT_WILL  0x01
+#define SENT_WONT  0x02
+#define SENT_DO    0x04
+#define SENT_DONT  0x08
+
+typedef struct {
+    bool used;
+    int fd;
+    serial_transport_t transport;
+    int timeout;
+    int iac_state;
+    unsigned char iac_verb;
+    bool com_port;               /* Server accepted the COM port option */
+    bool com_port_refused;       /* Server answered DONT COM_PORT */
+    unsigned char sent[256];
+} net_conn_t;
+
+static net_conn_t g_conns[SERIAL_NET_MAX];
 
 /**
  * validate_serial_params - Helper function to validate serial communication parameters
@@ -55,6 +118,435 @@ static int validate_serial_params(int fd, const char *buf, size_t buflen)
     return 1;
 }
 
+/* ============================================================================
+ * NETWORK ENDPOINTS
+ * ============================================================================ */
+
+/**
+ * net_find - Connection state of a descriptor
+ *
+ * Return: Connection, or NULL for a local tty
+ */
+static net_conn_t *net_find(int fd)
+{
+    for (int i = 0; i < SERIAL_NET_MAX; i++) {
+        if (g_conns[i].used && g_conns[i].fd == fd) {
+            return &g_conns[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * net_register - Claim a connection slot for a descriptor
+ */
+static net_conn_t *net_register(int fd, const serial_endpoint_t *ep)
+{
+    for (int i = 0; i < SERIAL_NET_MAX; i++) {
+        if (!g_conns[i].used) {
+            net_conn_t *c = &g_conns[i];
+            memset(c, 0, sizeof(*c));
+            c->used = true;
+            c->fd = fd;
+            c->transport = ep->transport;
+            c->timeout = ep->timeout;
+            return c;
+        }
+    }
+    errno = EMFILE;
+    return NULL;
+}
+
+/**
+ * net_send - Write a buffer to a socket, waiting while it is full
+ */
+static int net_send(net_conn_t *c, const unsigned char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(c->fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            fd_set write_fds;
+            struct timeval tv = { .tv_sec = c->timeout, .tv_usec = 0 };
+            FD_ZERO(&write_fds);
+            FD_SET(c->fd, &write_fds);
+            if (select(c->fd + 1, NULL, &write_fds, NULL, &tv) > 0) {
+                continue;
+            }
+            errno = ETIMEDOUT;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * net_send_option - Send IAC <verb> <option> unless already sent
+ */
+static void net_send_option(net_conn_t *c, unsigned char verb, unsigned char option)
+{
+    static const unsigned char flags[] = { SENT_WILL, SENT_WONT, SENT_DO, SENT_DONT };
+    unsigned char flag = flags[verb - TELNET_WILL];
+
+    if (c->sent[option] & flag) {
+        return;
+    }
+    c->sent[option] |= flag;
+
+    unsigned char cmd[3] = { TELNET_IAC, verb, option };
+    net_send(c, cmd, sizeof(cmd));
+}
+
+/**
+ * net_send_com_port - Send one COM port setting
+ */
+static void net_send_com_port(net_conn_t *c, unsigned char command, const unsigned char *value, size_t len)
+{
+    unsigned char buf[16];
+    size_t n = 0;
+
+    buf[n++] = TELNET_IAC;
+    buf[n++] = TELNET_SB;
+    buf[n++] = TELOPT_COM_PORT;
+    buf[n++] = command;
+    for (size_t i = 0; i < len; i++) {
+        buf[n++] = value[i];
+        if (value[i] == TELNET_IAC) {
+            buf[n++] = TELNET_IAC;
+        }
+    }
+    buf[n++] = TELNET_IAC;
+    buf[n++] = TELNET_SE;
+    net_send(c, buf, n);
+}
+
+/**
+ * net_handle_option - Answer a WILL/WONT/DO/DONT from the server
+ *
+ * Binary, suppress-go-ahead and the COM port option are accepted,
+ * everything else is refused.
+ */
+static void net_handle_option(net_conn_t *c, unsigned char verb, unsigned char option)
+{
+    switch (verb) {
+        case TELNET_DO:
+            if (option == TELOPT_BINARY || option == TELOPT_SGA || option == TELOPT_COM_PORT) {
+                net_send_option(c, TELNET_WILL, option);
+                if (option == TELOPT_COM_PORT) {
+                    c->com_port = true;
+                }
+            } else {
+                net_send_option(c, TELNET_WONT, option);
+            }
+            break;
+        case TELNET_WILL:
+            if (option == TELOPT_BINARY || option == TELOPT_SGA) {
+                net_send_option(c, TELNET_DO, option);
+            } else {
+                net_send_option(c, TELNET_DONT, option);
+            }
+            break;
+        case TELNET_DONT:
+            if (option == TELOPT_COM_PORT) {
+                c->com_port_refused = true;
+            }
+            break;
+        default:
+            /* WONT needs no answer */
+            break;
+    }
+}
+
+/**
+ * net_filter - Strip Telnet commands from received bytes in place
+ * @c: Connection
+ * @buf: Received bytes, replaced with the data bytes
+ * @len: Number of received bytes
+ *
+ * Return: Number of data bytes
+ */
+static size_t net_filter(net_conn_t *c, char *buf, size_t len)
+{
+    unsigned char *p = (unsigned char *)buf;
+    size_t out = 0;
+
+    if (c->transport != SERIAL_TRANSPORT_RFC2217) {
+        return len;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char b = p[i];
+
+        switch (c->iac_state) {
+            case IAC_DATA:
+                if (b == TELNET_IAC) {
+                    c->iac_state = IAC_COMMAND;
+                } else {
+                    p[out++] = b;
+                }
+                break;
+            case IAC_COMMAND:
+                if (b == TELNET_IAC) {
+                    p[out++] = b;            /* Escaped 0xFF */
+                    c->iac_state = IAC_DATA;
+                } else if (b >= TELNET_WILL && b <= TELNET_DONT) {
+                    c->iac_verb = b;
+                    c->iac_state = IAC_OPTION;
+                } else if (b == TELNET_SB) {
+                    c->iac_state = IAC_SUB;
+                } else {
+                    c->iac_state = IAC_DATA; /* NOP, GA, ... */
+                }
+                break;
+            case IAC_OPTION:
+                net_handle_option(c, c->iac_verb, b);
+                c->iac_state = IAC_DATA;
+                break;
+            case IAC_SUB:
+                /* COM port notifications (line/modem state) are not used */
+                if (b == TELNET_IAC) {
+                    c->iac_state = IAC_SUB_IAC;
+                }
+                break;
+            case IAC_SUB_IAC:
+                c->iac_state = (b == TELNET_SE) ? IAC_DATA : IAC_SUB;
+                break;
+        }
+    }
+
+    return out;
+}
+
+/**
+ * net_drain - Discard pending input before a command
+ *
+ * Return: 0 on success, -1 if the server closed the connection
+ */
+static int net_drain(net_conn_t *c)
+{
+    char buf[256];
+
+    for (;;) {
+        ssize_t n = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0) {
+            net_filter(c, buf, (size_t)n);
+            continue;
+        }
+        if (n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+}
+
+/**
+ * baud_to_int - Numeric value of a termios baud rate
+ */
+static uint32_t baud_to_int(speed_t baud_rate)
+{
+    switch (baud_rate) {
+        case B9600:   return 9600;
+        case B19200:  return 19200;
+        case B38400:  return 38400;
+        case B57600:  return 57600;
+        default:      return 115200;
+    }
+}
+
+/**
+ * net_negotiate - Set up the COM port option on an RFC 2217 connection
+ * @c: Connection
+ * @ep: Endpoint
+ * @baud_rate: Line speed to request
+ *
+ * Offers the COM port option and waits up to the connect timeout for the
+ * server to accept it, then requests 8N1 without flow control. Servers
+ * that refuse the option keep their own line settings.
+ */
+static void net_negotiate(net_conn_t *c, const serial_endpoint_t *ep, speed_t baud_rate)
+{
+    char buf[256];
+    time_t start = sys_time();
+
+    net_send_option(c, TELNET_WILL, TELOPT_COM_PORT);
+    net_send_option(c, TELNET_WILL, TELOPT_BINARY);
+    net_send_option(c, TELNET_DO, TELOPT_BINARY);
+    net_send_option(c, TELNET_DO, TELOPT_SGA);
+
+    while (!c->com_port && !c->com_port_refused &&
+           sys_time() - start < ep->connect_timeout && !shutdown_requested) {
+        fd_set read_fds;
+        struct timeval tv = { .tv_sec = 0, .tv_usec = sys_real_usec(100000) };
+        FD_ZERO(&read_fds);
+        FD_SET(c->fd, &read_fds);
+        if (select(c->fd + 1, &read_fds, NULL, NULL, &tv) <= 0) {
+            continue;
+        }
+        ssize_t n = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n <= 0) {
+            break;
+        }
+        net_filter(c, buf, (size_t)n);
+    }
+
+    if (!c->com_port) {
+        logging_debug("RFC 2217 server did not accept the COM port option, using its line settings");
+        return;
+    }
+
+    uint32_t baud = baud_to_int(baud_rate);
+    unsigned char value[4] = {
+        (unsigned char)(baud >> 24), (unsigned char)(baud >> 16),
+        (unsigned char)(baud >> 8), (unsigned char)baud
+    };
+    unsigned char datasize = 8, parity = COM_PORT_PARITY_NONE;
+    unsigned char stopsize = COM_PORT_STOPSIZE_1, control = COM_PORT_CONTROL_NONE;
+
+    net_send_com_port(c, COM_PORT_SET_BAUDRATE, value, sizeof(value));
+    net_send_com_port(c, COM_PORT_SET_DATASIZE, &datasize, 1);
+    net_send_com_port(c, COM_PORT_SET_PARITY, &parity, 1);
+    net_send_com_port(c, COM_PORT_SET_STOPSIZE, &stopsize, 1);
+    net_send_com_port(c, COM_PORT_SET_CONTROL, &control, 1);
+}
+
+/**
+ * net_connect - Connect to a network endpoint with a timeout
+ *
+ * Return: Non-blocking socket, or -1 on error
+ */
+static int net_connect(const serial_endpoint_t *ep)
+{
+    struct addrinfo hints, *res, *ai;
+    int fd = -1;
+    int err = ECONNREFUSED;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int gai = getaddrinfo(ep->host, ep->service, &hints, &res);
+    if (gai != 0) {
+        logging_debug("Cannot resolve %s: %s", ep->host, gai_strerror(gai));
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+
+    for (ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            err = errno;
+            continue;
+        }
+
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        if (errno == EINPROGRESS) {
+            int64_t usec = sys_real_usec((int64_t)ep->connect_timeout * 1000000LL);
+            struct timeval tv = { .tv_sec = (time_t)(usec / 1000000LL),
+                                  .tv_usec = (suseconds_t)(usec % 1000000LL) };
+            fd_set write_fds;
+            FD_ZERO(&write_fds);
+            FD_SET(fd, &write_fds);
+
+            int sel = select(fd + 1, NULL, &write_fds, NULL, &tv);
+            socklen_t len = sizeof(err);
+            if (sel > 0 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+                break;
+            }
+            if (sel == 0) {
+                err = ETIMEDOUT;
+            }
+        } else {
+            err = errno;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (fd < 0) {
+        errno = err;
+        return -1;
+    }
+
+    /* AT transactions are small request/response pairs */
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * parse_seconds - Parse an endpoint timeout option
+ */
+static int parse_seconds(const char *str, size_t len, int *value)
+{
+    char buf[8];
+    char *endptr;
+
+    if (len == 0 || len >= sizeof(buf)) {
+        return -1;
+    }
+    memcpy(buf, str, len);
+    buf[len] = '\0';
+
+    long v = strtol(buf, &endptr, 10);
+    if (*endptr != '\0' || v < 1 || v > SERIAL_NET_TIMEOUT_MAX) {
+        return -1;
+    }
+    *value = (int)v;
+    return 0;
+}
+
+/**
+ * net_open - Open a network endpoint
+ */
+static int net_open(const char *port, speed_t baud_rate)
+{
+    serial_endpoint_t ep;
+
+    if (serial_parse_endpoint(port, &ep) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int fd = net_connect(&ep);
+    if (fd < 0) {
+        return -1;
+    }
+
+    net_conn_t *c = net_register(fd, &ep);
+    if (!c) {
+        close(fd);
+        errno = EMFILE;
+        return -1;
+    }
+
+    if (ep.transport == SERIAL_TRANSPORT_RFC2217) {
+        net_negotiate(c, &ep, baud_rate);
+    }
+
+    logging_debug("Connected to %s:%s (%s, timeout %d s)", ep.host, ep.service,
+                  ep.transport == SERIAL_TRANSPORT_RFC2217 ? "rfc2217" : "tcp", ep.timeout);
+    return fd;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
 /**
  * Initializes the serial port and configures it
  * @param port Serial port device path
@@ -72,9 +564,14 @@ int init_serial_port(const char *port, speed_t baud_rate)
         errno = EINVAL;
         return -1;
     }
+
+    /* Network endpoints have no termios; line settings go over RFC 2217 */
+    if (serial_is_network(port)) {
+        return net_open(port, baud_rate);
+    }
     
     /* Open serial port with proper flags */
-    fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    fd = sys_open(port, O_RDWR | O_NOCTTY | O_NONBLOCK, 0);
     if (fd < 0) {
         return -1;
     }
@@ -140,6 +637,8 @@ int read_modem_response(int fd, char *buf, size_t buflen)
     int total = 0;
     fd_set read_fds;
     struct timeval tv;
+    net_conn_t *conn = net_find(fd);
+    int timeout = conn ? conn->timeout : AT_TIMEOUT_SEC;
 
     /* Validate input parameters */
     if (!validate_serial_params(fd, buf, buflen)) {
@@ -149,7 +648,7 @@ int read_modem_response(int fd, char *buf, size_t buflen)
 
     /* Clear buffer and initialize */
     memset(buf, 0, buflen);
-    start_time = time(NULL);
+    start_time = sys_time();
 
     /* Read response with timeout, checking for shutdown */
     while (total < (int)buflen - 1) {
@@ -160,7 +659,7 @@ int read_modem_response(int fd, char *buf, size_t buflen)
         }
 
         /* Check overall timeout */
-        if ((time(NULL) - start_time) >= AT_TIMEOUT_SEC) {
+        if ((sys_time() - start_time) >= timeout) {
             errno = ETIMEDOUT;
             break;
         }
@@ -169,7 +668,7 @@ int read_modem_response(int fd, char *buf, size_t buflen)
         FD_ZERO(&read_fds);
         FD_SET(fd, &read_fds);
         tv.tv_sec = 0;
-        tv.tv_usec = 500000;  /* 500ms - allows checking shutdown flag */
+        tv.tv_usec = sys_real_usec(500000);  /* 500ms - allows checking shutdown flag */
 
         int sel_ret = select(fd + 1, &read_fds, NULL, NULL, &tv);
 
@@ -190,6 +689,16 @@ int read_modem_response(int fd, char *buf, size_t buflen)
         /* Data available, read it */
         int n = read(fd, buf + total, buflen - total - 1);
 
+        if (conn && n == 0) {
+            /* Server closed the connection */
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (conn && n > 0) {
+            n = (int)net_filter(conn, buf + total, (size_t)n);
+            buf[total + n] = '\0';
+        }
+
         if (n > 0) {
             total += n;
             buf[total] = '\0';
@@ -229,12 +738,39 @@ int send_at_command(int fd, const char *command, char *response, size_t response
 {
     ssize_t written;
     int result;
+    net_conn_t *conn = net_find(fd);
     
     /* Validate input parameters */
     if (fd < 0 || !command || !validate_serial_params(fd, response, response_len)) {
         errno = EINVAL;
         return -1;
     }
+
+    if (conn) {
+        /* Sockets: drop stale input, send command and terminator in one go */
+        unsigned char out[2 * MAX_COMMAND_LEN + 2];
+        size_t len = 0;
+
+        if (net_drain(conn) != 0) {
+            return -1;
+        }
+        for (const char *c = command; *c; c++) {
+            if (len + 4 > sizeof(out)) {
+                errno = EMSGSIZE;
+                return -1;
+            }
+            out[len++] = (unsigned char)*c;
+            if ((unsigned char)*c == TELNET_IAC && conn->transport == SERIAL_TRANSPORT_RFC2217) {
+                out[len++] = TELNET_IAC;
+            }
+        }
+        out[len++] = '\r';
+        out[len++] = '\n';
+        if (net_send(conn, out, len) != 0) {
+            return -1;
+        }
+        return read_modem_response(fd, response, response_len);
+    }
     
     /* Flush input buffer before sending command */
     if (tcflush(fd, TCIFLUSH) != 0) {
@@ -269,6 +805,12 @@ int close_serial_port(int fd)
         errno = EINVAL;
         return -1;
     }
+
+    net_conn_t *conn = net_find(fd);
+    if (conn) {
+        conn->used = false;
+        return close(fd);
+    }
     
     /* Flush any pending data */
     tcflush(fd, TCIOFLUSH);
@@ -280,3 +822,142 @@ int close_serial_port(int fd)
     
     return 0;
 }
+
+/**
+ * Check whether a port names a network endpoint
+ */
+bool serial_is_network(const char *port)
+{
+    return port && (strncmp(port, SERIAL_SCHEME_TCP, strlen(SERIAL_SCHEME_TCP)) == 0 ||
+                    strncmp(port, SERIAL_SCHEME_RFC2217, strlen(SERIAL_SCHEME_RFC2217)) == 0);
+}
+
+/**
+ * Parse a network endpoint
+ */
+int serial_parse_endpoint(const char *port, serial_endpoint_t *ep)
+{
+    const char *p;
+    const char *host_end;
+    size_t host_len;
+
+    memset(ep, 0, sizeof(*ep));
+    ep->timeout = AT_TIMEOUT_SEC;
+    ep->connect_timeout = SERIAL_NET_CONNECT_TIMEOUT;
+
+    if (!port) {
+        return -1;
+    } else if (strncmp(port, SERIAL_SCHEME_TCP, strlen(SERIAL_SCHEME_TCP)) == 0) {
+        ep->transport = SERIAL_TRANSPORT_TCP;
+        p = port + strlen(SERIAL_SCHEME_TCP);
+    } else if (strncmp(port, SERIAL_SCHEME_RFC2217, strlen(SERIAL_SCHEME_RFC2217)) == 0) {
+        ep->transport = SERIAL_TRANSPORT_RFC2217;
+        p = port + strlen(SERIAL_SCHEME_RFC2217);
+    } else {
+        return -1;
+    }
+
+    /* Host: name, IPv4 address or [IPv6 address] */
+    if (*p == '[') {
+        host_end = strchr(++p, ']');
+        if (!host_end) {
+            return -1;
+        }
+        host_len = (size_t)(host_end - p);
+        for (size_t i = 0; i < host_len; i++) {
+            if (!isxdigit((unsigned char)p[i]) && p[i] != ':' && p[i] != '.') {
+                return -1;
+            }
+        }
+        host_end++;
+    } else {
+        host_end = p;
+        while (isalnum((unsigned char)*host_end) || *host_end == '.' || *host_end == '-') {
+            host_end++;
+        }
+        host_len = (size_t)(host_end - p);
+    }
+    if (host_len == 0 || host_len >= sizeof(ep->host) || *host_end != ':') {
+        return -1;
+    }
+    memcpy(ep->host, p, host_len);
+    ep->host[host_len] = '\0';
+
+    /* TCP port */
+    p = host_end + 1;
+    size_t service_len = strspn(p, "0123456789");
+    long service = strtol(p, NULL, 10);
+    if (service_len == 0 || service_len >= sizeof(ep->service) || service < 1 || service > 65535) {
+        return -1;
+    }
+    memcpy(ep->service, p, service_len);
+    ep->service[service_len] = '\0';
+    p += service_len;
+
+    if (*p == '\0') {
+        return 0;
+    }
+    if (*p++ != '?') {
+        return -1;
+    }
+
+    /* Options: timeout=<s>,connect=<s> */
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        const char *eq = memchr(p, '=', len);
+        if (!eq) {
+            return -1;
+        }
+        size_t key_len = (size_t)(eq - p);
+        size_t value_len = len - key_len - 1;
+
+        if (key_len == 7 && strncmp(p, "timeout", 7) == 0) {
+            if (parse_seconds(eq + 1, value_len, &ep->timeout) != 0) {
+                return -1;
+            }
+        } else if (key_len == 7 && strncmp(p, "connect", 7) == 0) {
+            if (parse_seconds(eq + 1, value_len, &ep->connect_timeout) != 0) {
+                return -1;
+            }
+        } else {
+            return -1;
+        }
+
+        p += len;
+        if (*p == ',') {
+            p++;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Register a descriptor inherited from a previous image (re-exec)
+ */
+int serial_adopt(int fd, const char *port)
+{
+    serial_endpoint_t ep;
+
+    if (!serial_is_network(port)) {
+        return 0;
+    }
+    if (serial_parse_endpoint(port, &ep) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    net_conn_t *c = net_register(fd, &ep);
+    if (!c) {
+        return -1;
+    }
+
+    /* Negotiation finished in the previous image; do not offer again */
+    if (ep.transport == SERIAL_TRANSPORT_RFC2217) {
+        c->sent[TELOPT_COM_PORT] = SENT_WILL;
+        c->sent[TELOPT_BINARY] = SENT_WILL | SENT_DO;
+        c->sent[TELOPT_SGA] = SENT_DO;
+        c->com_port = true;
+    }
+    return 0;
+}
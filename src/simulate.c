@@ -0,0 +1,555 @@
+/**
+ * @file simulate.c
+ * @brief Offline thermal policy simulator for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the simulate subcommand. It replays a recorded
+ * temperature trace through a model of the thermal zone trip table,
+ * hysteresis and the step_wise or bang_bang governor, and reports time
+ * above each trip, cooling state changes and fan duty. Trips and
+ * thresholds can so be tuned against fleet data before they are deployed
+ * in the device tree overlay or UCI.
+ *
+ * The trace is streamed and each sample is handled in constant time, so
+ * months of samples replay in seconds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "include/logging.h"
+#include "include/config.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/simulate.h"
+
+/* Global configuration (defined in main.c) */
+extern config_t config;
+
+/* ============================================================================
+ * CONSTANTS & DATA STRUCTURES
+ * ============================================================================ */
+
+#define SIM_LINE_LEN        256
+#define SIM_MDEG_THRESHOLD  1000.0      /* Values above this are m°C */
+#define SIM_TEMP_MIN        -100000L    /* Plausible range in m°C */
+#define SIM_TEMP_MAX        250000L
+
+typedef enum {
+    SIM_TREND_STABLE = 0,
+    SIM_TREND_RAISING,
+    SIM_TREND_DROPPING,
+} sim_trend_t;
+
+/* One active trip and the governor instance bound to it */
+typedef struct {
+    long temp;                   /* Trip temperature (m°C) */
+    long hyst;                   /* Hysteresis (m°C) */
+    bool crossed;                /* Trip crossed, cleared below temp - hyst */
+    bool initialized;            /* Governor instance evaluated at least once */
+    int target;                  /* Requested cooling state, 0 = no target */
+    double seconds_above;        /* Time at or above the trip temperature */
+} sim_trip_t;
+
+/* A UCI threshold the time above is reported for */
+typedef struct {
+    const char *name;
+    bool set;
+    long temp;                   /* m°C */
+    double seconds_above;
+} sim_threshold_t;
+
+/* Simulator state and accumulated report */
+typedef struct {
+    sim_trip_t trips[SIMULATE_MAX_TRIPS];
+    int num_trips;
+    bool step_wise;              /* false = bang_bang */
+    sim_threshold_t thresholds[2];
+
+    int state;                   /* Cooling device state (0..num_trips) */
+    long last_temp;
+    double last_ts;
+    bool have_sample;
+
+    long samples;
+    long skipped;
+    double duration;             /* Seconds covered by samples */
+    double gap_seconds;          /* Seconds dropped as gaps */
+    long min_temp, max_temp;
+    double temp_seconds;         /* Time-weighted temperature sum (m°C * s) */
+    long state_changes;
+    int peak_state;
+    double state_seconds[SIMULATE_MAX_TRIPS + 1];
+} sim_t;
+
+/* ============================================================================
+ * PARSING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * parse_celsius - Parse a temperature or hysteresis in °C
+ * @str: String to parse
+ * @mdeg: Result in m°C
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int parse_celsius(const char *str, long *mdeg)
+{
+    char *endptr;
+
+    errno = 0;
+    double value = strtod(str, &endptr);
+    if (errno != 0 || endptr == str || *endptr != '\0' || value < -100.0 || value > 250.0) {
+        return -1;
+    }
+    *mdeg = (long)(value * 1000.0 + (value < 0 ? -0.5 : 0.5));
+    return 0;
+}
+
+/**
+ * parse_policy - Parse trip table, hysteresis and governor
+ * @sim: Simulator to configure
+ * @trips: Comma separated "temp[:hyst]" list in °C
+ * @hysteresis: Default hysteresis in °C
+ * @governor: Governor name
+ *
+ * Return: 0 on success, -1 on error (message printed)
+ */
+static int parse_policy(sim_t *sim, const char *trips, const char *hysteresis, const char *governor)
+{
+    char list[CONFIG_STRING_LEN];
+    long default_hyst;
+
+    if (strcmp(governor, "step_wise") == 0) {
+        sim->step_wise = true;
+    } else if (strcmp(governor, "bang_bang") == 0) {
+        sim->step_wise = false;
+    } else {
+        fprintf(stderr, "Error: Invalid governor '%s'. Supported values: step_wise, bang_bang\n", governor);
+        return -1;
+    }
+
+    if (parse_celsius(hysteresis, &default_hyst) != 0 || default_hyst < 0) {
+        fprintf(stderr, "Error: Invalid hysteresis '%s'. Must be a temperature in °C >= 0\n", hysteresis);
+        return -1;
+    }
+
+    if (strlen(trips) >= sizeof(list)) {
+        fprintf(stderr, "Error: Trip list too long\n");
+        return -1;
+    }
+    snprintf(list, sizeof(list), "%s", trips);
+
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(list, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+        if (sim->num_trips >= SIMULATE_MAX_TRIPS) {
+            fprintf(stderr, "Error: Too many trips (maximum %d)\n", SIMULATE_MAX_TRIPS);
+            return -1;
+        }
+
+        sim_trip_t *trip = &sim->trips[sim->num_trips];
+        char *hyst = strchr(tok, ':');
+        if (hyst) {
+            *hyst++ = '\0';
+        }
+
+        if (parse_celsius(tok, &trip->temp) != 0) {
+            fprintf(stderr, "Error: Invalid trip temperature '%s'\n", tok);
+            return -1;
+        }
+        if (hyst) {
+            if (parse_celsius(hyst, &trip->hyst) != 0 || trip->hyst < 0) {
+                fprintf(stderr, "Error: Invalid hysteresis '%s' for trip %s\n", hyst, tok);
+                return -1;
+            }
+        } else {
+            trip->hyst = default_hyst;
+        }
+        if (sim->num_trips > 0 && trip->temp <= sim->trips[sim->num_trips - 1].temp) {
+            fprintf(stderr, "Error: Trips must be in ascending order\n");
+            return -1;
+        }
+        sim->num_trips++;
+    }
+
+    if (sim->num_trips == 0) {
+        fprintf(stderr, "Error: No trips given\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * parse_sample - Parse one trace line
+ * @line: Line without newline
+ * @ts: Timestamp (set only if the line has one)
+ * @has_ts: Whether the line carried a timestamp
+ * @temp: Temperature in m°C
+ *
+ * Return: 1 for a sample, 0 for a comment or empty line, -1 on error
+ */
+static int parse_sample(const char *line, double *ts, bool *has_ts, long *temp)
+{
+    const char *p = line + strspn(line, " \t");
+    char *endptr;
+
+    if (*p == '\0' || *p == '#') {
+        return 0;
+    }
+
+    errno = 0;
+    double first = strtod(p, &endptr);
+    if (errno != 0 || endptr == p) {
+        return -1;
+    }
+
+    p = endptr + strspn(endptr, " \t,;");
+    double value = first;
+    *has_ts = false;
+    if (*p != '\0') {
+        value = strtod(p, &endptr);
+        if (errno != 0 || endptr == p) {
+            return -1;
+        }
+        *ts = first;
+        *has_ts = true;
+    }
+
+    if (value > SIM_MDEG_THRESHOLD || value < -SIM_MDEG_THRESHOLD) {
+        *temp = (long)value;
+    } else {
+        *temp = (long)(value * 1000.0 + (value < 0 ? -0.5 : 0.5));
+    }
+
+    return (*temp >= SIM_TEMP_MIN && *temp <= SIM_TEMP_MAX) ? 1 : -1;
+}
+
+/* ============================================================================
+ * GOVERNOR MODEL
+ * ============================================================================ */
+
+/**
+ * step_wise_target - Next target of one instance, as the kernel step_wise governor
+ * @trip: Trip and instance state
+ * @upper: Highest cooling state of the instance
+ * @cur: Current cooling device state
+ * @trend: Temperature trend
+ */
+static int step_wise_target(sim_trip_t *trip, int upper, int cur, sim_trend_t trend)
+{
+    bool throttle = trip->crossed;
+
+    if (!trip->initialized) {
+        trip->initialized = true;
+        return throttle ? ((cur + 1 < upper) ? cur + 1 : upper) : 0;
+    }
+
+    if (throttle) {
+        if (trend == SIM_TREND_RAISING) {
+            return (cur + 1 < upper) ? cur + 1 : upper;
+        }
+    } else if (trend == SIM_TREND_DROPPING) {
+        if (cur <= 0) {
+            return 0;
+        }
+        return (cur - 1 < upper) ? cur - 1 : upper;
+    }
+
+    return trip->target;
+}
+
+/**
+ * sim_evaluate - Update trips and cooling state for a new temperature
+ */
+static void sim_evaluate(sim_t *sim, long temp)
+{
+    sim_trend_t trend = SIM_TREND_STABLE;
+    int state = 0;
+
+    if (sim->have_sample) {
+        if (temp > sim->last_temp) {
+            trend = SIM_TREND_RAISING;
+        } else if (temp < sim->last_temp) {
+            trend = SIM_TREND_DROPPING;
+        }
+    }
+
+    for (int i = 0; i < sim->num_trips; i++) {
+        sim_trip_t *trip = &sim->trips[i];
+
+        /* Crossed at the trip temperature, cleared below trip - hysteresis */
+        if (!trip->crossed && temp >= trip->temp) {
+            trip->crossed = true;
+        } else if (trip->crossed && temp < trip->temp - trip->hyst) {
+            trip->crossed = false;
+        }
+
+        /* Cooling map of trip i covers states 0..i+1 */
+        if (sim->step_wise) {
+            trip->target = step_wise_target(trip, i + 1, sim->state, trend);
+        } else {
+            trip->target = trip->crossed ? i + 1 : 0;
+        }
+
+        /* The cooling device applies the highest requested state */
+        if (trip->target > state) {
+            state = trip->target;
+        }
+    }
+
+    if (sim->have_sample && state != sim->state) {
+        sim->state_changes++;
+    }
+    sim->state = state;
+    if (state > sim->peak_state) {
+        sim->peak_state = state;
+    }
+}
+
+/**
+ * sim_account - Attribute the interval since the last sample
+ * @sim: Simulator
+ * @dt: Interval in seconds
+ *
+ * Zero-order hold: temperature and cooling state of the previous sample
+ * apply until the next one.
+ */
+static void sim_account(sim_t *sim, double dt)
+{
+    sim->duration += dt;
+    sim->temp_seconds += (double)sim->last_temp * dt;
+    sim->state_seconds[sim->state] += dt;
+
+    for (int i = 0; i < sim->num_trips; i++) {
+        if (sim->last_temp >= sim->trips[i].temp) {
+            sim->trips[i].seconds_above += dt;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        if (sim->thresholds[i].set && sim->last_temp >= sim->thresholds[i].temp) {
+            sim->thresholds[i].seconds_above += dt;
+        }
+    }
+}
+
+/**
+ * sim_sample - Feed one sample into the simulator
+ */
+static void sim_sample(sim_t *sim, double ts, long temp)
+{
+    if (sim->have_sample) {
+        double dt = ts - sim->last_ts;
+        if (dt >= 0 && dt <= SIMULATE_MAX_GAP) {
+            sim_account(sim, dt);
+        } else if (dt > 0) {
+            sim->gap_seconds += dt;
+        }
+    }
+
+    sim_evaluate(sim, temp);
+
+    if (sim->samples == 0 || temp < sim->min_temp) {
+        sim->min_temp = temp;
+    }
+    if (sim->samples == 0 || temp > sim->max_temp) {
+        sim->max_temp = temp;
+    }
+    sim->samples++;
+    sim->last_temp = temp;
+    sim->last_ts = ts;
+    sim->have_sample = true;
+}
+
+/* ============================================================================
+ * REPORT FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * share - Percentage of the simulated duration
+ */
+static double share(const sim_t *sim, double seconds)
+{
+    return sim->duration > 0 ? seconds * 100.0 / sim->duration : 0.0;
+}
+
+/**
+ * mean_fan_duty - Time-weighted fan duty in percent
+ */
+static double mean_fan_duty(const sim_t *sim)
+{
+    double weighted = 0;
+
+    for (int s = 1; s <= sim->num_trips; s++) {
+        weighted += sim->state_seconds[s] * s;
+    }
+    return share(sim, weighted) / sim->num_trips;
+}
+
+/**
+ * print_report - Print the simulation report as text or JSON
+ */
+static void print_report(const sim_t *sim, const char *trace, bool json)
+{
+    double mean = sim->duration > 0 ? sim->temp_seconds / sim->duration : (double)sim->last_temp;
+    const char *governor = sim->step_wise ? "step_wise" : "bang_bang";
+
+    if (json) {
+        printf("{\n");
+        printf("  \"trace\": \"%s\",\n", trace);
+        printf("  \"governor\": \"%s\",\n", governor);
+        printf("  \"samples\": %ld,\n", sim->samples);
+        printf("  \"skipped_lines\": %ld,\n", sim->skipped);
+        printf("  \"duration_s\": %.0f,\n", sim->duration);
+        printf("  \"gap_s\": %.0f,\n", sim->gap_seconds);
+        printf("  \"temp_min\": %ld,\n", sim->min_temp);
+        printf("  \"temp_mean\": %.0f,\n", mean);
+        printf("  \"temp_max\": %ld,\n", sim->max_temp);
+        printf("  \"trips\": [\n");
+        for (int i = 0; i < sim->num_trips; i++) {
+            const sim_trip_t *t = &sim->trips[i];
+            printf("    {\"temp\": %ld, \"hysteresis\": %ld, \"seconds_above\": %.0f, \"percent_above\": %.2f}%s\n",
+                   t->temp, t->hyst, t->seconds_above, share(sim, t->seconds_above),
+                   (i + 1 < sim->num_trips) ? "," : "");
+        }
+        printf("  ],\n");
+        printf("  \"thresholds\": {");
+        bool first = true;
+        for (int i = 0; i < 2; i++) {
+            const sim_threshold_t *th = &sim->thresholds[i];
+            if (!th->set) {
+                continue;
+            }
+            printf("%s\"%s\": {\"temp\": %ld, \"seconds_above\": %.0f, \"percent_above\": %.2f}",
+                   first ? "" : ", ", th->name, th->temp, th->seconds_above, share(sim, th->seconds_above));
+            first = false;
+        }
+        printf("},\n");
+        printf("  \"state_changes\": %ld,\n", sim->state_changes);
+        printf("  \"peak_state\": %d,\n", sim->peak_state);
+        printf("  \"state_seconds\": [");
+        for (int s = 0; s <= sim->num_trips; s++) {
+            printf("%s%.0f", s ? ", " : "", sim->state_seconds[s]);
+        }
+        printf("],\n");
+        printf("  \"mean_fan_duty\": %.2f\n", mean_fan_duty(sim));
+        printf("}\n");
+        return;
+    }
+
+    printf("Simulation: %s, governor %s\n", trace, governor);
+    printf("Samples: %ld (%ld lines skipped), %.0f s simulated (%.1f h), %.0f s in gaps\n",
+           sim->samples, sim->skipped, sim->duration, sim->duration / 3600.0, sim->gap_seconds);
+    printf("Temperature: min %.1f°C, mean %.1f°C, max %.1f°C\n\n",
+           sim->min_temp / 1000.0, mean / 1000.0, sim->max_temp / 1000.0);
+
+    printf("%-10s %8s %8s %12s %8s\n", "Trip", "Temp", "Hyst", "Above s", "Above %");
+    for (int i = 0; i < sim->num_trips; i++) {
+        const sim_trip_t *t = &sim->trips[i];
+        printf("%-10d %6.1f°C %6.1f°C %12.0f %7.2f%%\n", i, t->temp / 1000.0, t->hyst / 1000.0,
+               t->seconds_above, share(sim, t->seconds_above));
+    }
+    for (int i = 0; i < 2; i++) {
+        const sim_threshold_t *th = &sim->thresholds[i];
+        if (th->set) {
+            printf("%-10s %6.1f°C %8s %12.0f %7.2f%%\n", th->name, th->temp / 1000.0, "-",
+                   th->seconds_above, share(sim, th->seconds_above));
+        }
+    }
+
+    printf("\nCooling state changes: %ld, peak state %d of %d\n",
+           sim->state_changes, sim->peak_state, sim->num_trips);
+    printf("%-10s %12s %8s %9s\n", "State", "Time s", "Time %", "Fan duty");
+    for (int s = 0; s <= sim->num_trips; s++) {
+        printf("%-10d %12.0f %7.2f%% %8.1f%%\n", s, sim->state_seconds[s],
+               share(sim, sim->state_seconds[s]), s * 100.0 / sim->num_trips);
+    }
+    printf("Mean fan duty: %.1f%%\n", mean_fan_duty(sim));
+}
+
+/* ============================================================================
+ * SIMULATE MODE IMPLEMENTATION
+ * ============================================================================ */
+
+/**
+ * Simulate mode - replay a temperature trace through a thermal policy
+ *
+ * @param trace Trace file, or "-" for stdin
+ * @param trips Comma separated trip temperatures in °C (NULL = overlay example)
+ * @param hysteresis Default hysteresis in °C (NULL = overlay example)
+ * @param governor "step_wise" or "bang_bang" (NULL = step_wise)
+ * @param json Output the report as JSON
+ * @return 0 on success, 1 if the trace cannot be read, 2 on invalid policy
+ */
+int simulate_mode(const char *trace, const char *trips, const char *hysteresis,
+                  const char *governor, bool json)
+{
+    static sim_t sim;
+    char line[SIM_LINE_LEN];
+    long lineno = 0;
+    double ts = 0;
+
+    memset(&sim, 0, sizeof(sim));
+    if (parse_policy(&sim, trips ? trips : SIMULATE_DEFAULT_TRIPS,
+                     hysteresis ? hysteresis : SIMULATE_DEFAULT_HYST,
+                     governor ? governor : SIMULATE_DEFAULT_GOVERNOR) != 0) {
+        return 2;
+    }
+
+    /* Report time above the UCI thresholds the kernel module alerts on */
+    sim.thresholds[0].name = "temp_max";
+    sim.thresholds[0].set = config.temp_max[0] && parse_celsius(config.temp_max, &sim.thresholds[0].temp) == 0;
+    sim.thresholds[1].name = "temp_crit";
+    sim.thresholds[1].set = config.temp_crit[0] && parse_celsius(config.temp_crit, &sim.thresholds[1].temp) == 0;
+
+    /* The trace is local input, not part of the device filesystem */
+    FILE *fp = strcmp(trace, "-") == 0 ? stdin : fopen(trace, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open trace '%s': %s\n", trace, strerror(errno));
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), fp) && !shutdown_requested) {
+        double line_ts = 0;
+        bool has_ts;
+        long temp;
+
+        lineno++;
+        STRIP_NEWLINE(line);
+
+        int r = parse_sample(line, &line_ts, &has_ts, &temp);
+        if (r == 0) {
+            continue;
+        }
+        if (r < 0) {
+            if (sim.skipped++ == 0) {
+                logging_warning("Skipping unparsable trace line %ld: '%s'", lineno, line);
+            }
+            continue;
+        }
+
+        /* Untimed traces are taken to be sampled at the UCI interval */
+        ts = has_ts ? line_ts : ts + config.interval;
+        sim_sample(&sim, ts, temp);
+    }
+
+    bool read_error = ferror(fp);
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    if (read_error) {
+        fprintf(stderr, "Error: Failed to read trace '%s'\n", trace);
+        return 1;
+    }
+    if (sim.samples == 0) {
+        fprintf(stderr, "Error: No samples in trace '%s'\n", trace);
+        return 1;
+    }
+
+    print_report(&sim, trace, json);
+    return 0;
+}
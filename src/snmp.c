@@ -0,0 +1,463 @@
+/**
+ * @file snmp.c
+ * @brief SNMP pass_persist helper for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file implements the snmp subcommand. snmpd keeps it running as a
+ * pass_persist helper:
+ *
+ *   pass_persist .1.3.6.1.4.1.8072.9999.9999.520 /usr/bin/quectel_rm520n_temp snmp
+ *
+ * On a request the helper takes a snapshot of the kernel module's sysfs
+ * values and the daemon's state file and answers from it. The snapshot is
+ * reused for SNMP_CACHE_SEC, so a full walk reads the files once. The
+ * modem is never queried here; without a running daemon only the
+ * daemonRunning object is served.
+ *
+ * Objects below SNMP_BASE_OID:
+ *
+ *   .1.0   daemonRunning       integer  1 = daemon running
+ *   .2.0   temperature         integer  m°C, as published by the daemon
+ *   .3.0   temperatureSource   string   modem or estimated
+ *   .4.0   tempMin             integer  m°C
+ *   .5.0   tempMax             integer  m°C
+ *   .6.0   tempCrit            integer  m°C
+ *   .7.0   headroom            integer  0-100
+ *   .8.0   headroomLevel       string   ok, warm, hot or critical
+ *   .9.0   updates             counter  Temperatures written to the module
+ *   .10.0  iterations          counter  Daemon sampling iterations
+ *   .11.0  successfulReads     counter
+ *   .12.0  serialErrors        counter
+ *   .13.0  atErrors            counter
+ *   .14.0  parseErrors         counter
+ *   .15.0  estimatedWrites     counter  Board-sensor estimates published
+ *   .20.1.<column>.<sensor>    sensor table, sensor 1 = modem, 2 = ap, 3 = pa
+ *          column 1 index (integer), 2 name (string), 3 temperature (integer, °C),
+ *          4 p50, 5 p95, 6 p99 (integer, °C), 7 stress (gauge, 1/10 equivalent hours)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/state.h"
+#include "include/snmp.h"
+
+/* ============================================================================
+ * CONSTANTS & STATE
+ * ============================================================================ */
+
+#define SNMP_MAX_ENTRIES   64
+#define SNMP_VALUE_LEN     64
+#define SNMP_LINE_LEN      512
+#define SNMP_SYSFS_DIR     "/sys/kernel/quectel_rm520n_thermal/"
+#define SNMP_SENSOR_TABLE  20
+
+typedef struct {
+    uint32_t oid[SNMP_MAX_OID_LEN];
+    int len;
+    const char *type;            /* pass_persist type keyword */
+    char value[SNMP_VALUE_LEN];
+} snmp_entry_t;
+
+typedef struct {
+    char key[STATE_KEY_LEN];
+    char value[STATE_VALUE_LEN];
+} snmp_state_t;
+
+static uint32_t g_base[SNMP_MAX_OID_LEN];
+static int g_base_len = 0;
+
+static snmp_entry_t g_entries[SNMP_MAX_ENTRIES];
+static int g_entry_count = 0;
+static time_t g_snapshot_time = 0;
+
+static snmp_state_t g_state[STATE_MAX_KEYS];
+static int g_state_count = 0;
+
+/* ============================================================================
+ * HELPER FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * parse_oid - Parse a dotted OID
+ * @str: OID such as ".1.3.6.1"
+ * @oid: Filled with the sub-identifiers
+ *
+ * Return: Number of sub-identifiers, -1 if the OID is malformed
+ */
+static int parse_oid(const char *str, uint32_t *oid)
+{
+    int len = 0;
+    const char *p = str;
+
+    if (*p == '.') {
+        p++;
+    }
+
+    while (*p) {
+        char *end;
+        errno = 0;
+        unsigned long v = strtoul(p, &end, 10);
+        if (end == p || errno != 0 || v > UINT32_MAX || len >= SNMP_MAX_OID_LEN ||
+            (*end != '.' && *end != '\0')) {
+            return -1;
+        }
+        oid[len++] = (uint32_t)v;
+        p = (*end == '.') ? end + 1 : end;
+    }
+
+    return len;
+}
+
+/**
+ * compare_oid - Lexicographic OID order
+ *
+ * Return: <0, 0 or >0 like strcmp()
+ */
+static int compare_oid(const uint32_t *a, int a_len, const uint32_t *b, int b_len)
+{
+    for (int i = 0; i < a_len && i < b_len; i++) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return a_len - b_len;
+}
+
+/**
+ * print_oid - Write an OID in dotted form
+ */
+static void print_oid(const uint32_t *oid, int len)
+{
+    for (int i = 0; i < len; i++) {
+        printf(".%u", oid[i]);
+    }
+    printf("\n");
+}
+
+/**
+ * add_entry - Append an object below the base OID
+ * @sub: Sub-identifiers after the base
+ * @sub_len: Number of sub-identifiers
+ * @type: pass_persist type keyword
+ * @value: Value ("" = object not available, skipped)
+ *
+ * Objects must be added in OID order.
+ */
+static void add_entry(const uint32_t *sub, int sub_len, const char *type, const char *value)
+{
+    if (!value || !value[0] || g_entry_count >= SNMP_MAX_ENTRIES ||
+        g_base_len + sub_len > SNMP_MAX_OID_LEN) {
+        return;
+    }
+
+    snmp_entry_t *e = &g_entries[g_entry_count++];
+    memcpy(e->oid, g_base, (size_t)g_base_len * sizeof(uint32_t));
+    memcpy(e->oid + g_base_len, sub, (size_t)sub_len * sizeof(uint32_t));
+    e->len = g_base_len + sub_len;
+    e->type = type;
+    snprintf(e->value, sizeof(e->value), "%s", value);
+}
+
+/**
+ * add_scalar - Append a scalar object (<base>.<id>.0)
+ */
+static void add_scalar(uint32_t id, const char *type, const char *value)
+{
+    uint32_t sub[2] = { id, 0 };
+    add_entry(sub, 2, type, value);
+}
+
+/**
+ * read_sysfs - Read one value of the kernel module
+ * @name: Attribute below SNMP_SYSFS_DIR
+ * @buf: Buffer for the value ("" if unavailable)
+ * @size: Size of the buffer
+ */
+static void read_sysfs(const char *name, char *buf, size_t size)
+{
+    char path[PATH_MAX_LEN];
+
+    buf[0] = '\0';
+    snprintf(path, sizeof(path), "%s%s", SNMP_SYSFS_DIR, name);
+
+    FILE *fp = sys_fopen(path, "r");
+    if (!fp) {
+        return;
+    }
+    if (fgets(buf, (int)size, fp) == NULL) {
+        buf[0] = '\0';
+    }
+    fclose(fp);
+    STRIP_NEWLINE(buf);
+}
+
+/**
+ * numeric - Keep a value only if it is an integer
+ */
+static const char *numeric(const char *value)
+{
+    char *end;
+
+    if (!value[0]) {
+        return "";
+    }
+    errno = 0;
+    (void)strtoll(value, &end, 10);
+    return (errno == 0 && *end == '\0') ? value : "";
+}
+
+/**
+ * load_state - Read the daemon's state file into g_state
+ */
+static void load_state(void)
+{
+    char line[STATE_KEY_LEN + STATE_VALUE_LEN + 2];
+
+    g_state_count = 0;
+
+    FILE *fp = sys_fopen(STATE_FILE, "r");
+    if (!fp) {
+        return;
+    }
+
+    while (g_state_count < STATE_MAX_KEYS && fgets(line, sizeof(line), fp) != NULL) {
+        char *eq = strchr(line, '=');
+        if (!eq || eq - line >= STATE_KEY_LEN) {
+            continue;
+        }
+        STRIP_NEWLINE(eq + 1);
+        size_t key_len = (size_t)(eq - line);
+        size_t value_len = strlen(eq + 1);
+        if (value_len >= STATE_VALUE_LEN) {
+            continue;
+        }
+        memcpy(g_state[g_state_count].key, line, key_len);
+        g_state[g_state_count].key[key_len] = '\0';
+        memcpy(g_state[g_state_count].value, eq + 1, value_len + 1);
+        g_state_count++;
+    }
+    fclose(fp);
+}
+
+/**
+ * state_value - Value of a key in the loaded state file
+ *
+ * Return: Value, "" if the key is not published
+ */
+static const char *state_value(const char *key)
+{
+    for (int i = 0; i < g_state_count; i++) {
+        if (strcmp(g_state[i].key, key) == 0) {
+            return g_state[i].value;
+        }
+    }
+    return "";
+}
+
+/**
+ * counter - Format a statistics value as Counter32
+ */
+static const char *counter(const char *value, char *buf, size_t size)
+{
+    if (!numeric(value)[0]) {
+        return "";
+    }
+    snprintf(buf, size, "%lu", (unsigned long)(strtoull(value, NULL, 10) & 0xffffffffULL));
+    return buf;
+}
+
+/**
+ * snapshot - Rebuild the object table from sysfs and the state file
+ */
+static void snapshot(void)
+{
+    static const char *const sensors[] = { "modem", "ap", "pa" };
+    static const char *const quantiles[] = { "p50", "p95", "p99" };
+    char value[SNMP_VALUE_LEN], buf[SNMP_VALUE_LEN], key[STATE_KEY_LEN];
+    time_t now = time(NULL);
+
+    if (g_entry_count > 0 && now - g_snapshot_time < SNMP_CACHE_SEC) {
+        return;
+    }
+    g_snapshot_time = now;
+    g_entry_count = 0;
+
+    bool running = check_daemon_running() == 1;
+    add_scalar(1, "integer", running ? "1" : "0");
+    if (!running) {
+        return;
+    }
+
+    load_state();
+
+    read_sysfs("temp", value, sizeof(value));
+    add_scalar(2, "integer", numeric(value));
+    read_sysfs("temp_source", value, sizeof(value));
+    add_scalar(3, "string", value);
+    read_sysfs("temp_min", value, sizeof(value));
+    add_scalar(4, "integer", numeric(value));
+    read_sysfs("temp_max", value, sizeof(value));
+    add_scalar(5, "integer", numeric(value));
+    read_sysfs("temp_crit", value, sizeof(value));
+    add_scalar(6, "integer", numeric(value));
+
+    add_scalar(7, "integer", numeric(state_value("headroom")));
+    add_scalar(8, "string", state_value("headroom_level"));
+
+    /* The stats attribute has several lines; only total_updates is served */
+    FILE *fp = sys_fopen(SNMP_SYSFS_DIR "stats", "r");
+    if (fp) {
+        unsigned long updates;
+        while (fgets(value, sizeof(value), fp) != NULL) {
+            if (sscanf(value, "total_updates: %lu", &updates) == 1) {
+                snprintf(buf, sizeof(buf), "%lu", updates & 0xffffffffUL);
+                add_scalar(9, "counter", buf);
+                break;
+            }
+        }
+        fclose(fp);
+    }
+
+    add_scalar(10, "counter", counter(state_value("iterations"), buf, sizeof(buf)));
+    add_scalar(11, "counter", counter(state_value("successful_reads"), buf, sizeof(buf)));
+    add_scalar(12, "counter", counter(state_value("serial_errors"), buf, sizeof(buf)));
+    add_scalar(13, "counter", counter(state_value("at_errors"), buf, sizeof(buf)));
+    add_scalar(14, "counter", counter(state_value("parse_errors"), buf, sizeof(buf)));
+    add_scalar(15, "counter", counter(state_value("estimated_writes"), buf, sizeof(buf)));
+
+    /* Sensor table, column by column so entries stay in OID order */
+    for (uint32_t column = 1; column <= 7; column++) {
+        for (uint32_t i = 0; i < 3; i++) {
+            uint32_t sub[4] = { SNMP_SENSOR_TABLE, 1, column, i + 1 };
+            const char *type = "integer";
+
+            switch (column) {
+                case 1:
+                    snprintf(buf, sizeof(buf), "%u", i + 1);
+                    break;
+                case 2:
+                    type = "string";
+                    snprintf(buf, sizeof(buf), "%s", sensors[i]);
+                    break;
+                case 3:
+                    snprintf(key, sizeof(key), "temp_%s", sensors[i]);
+                    snprintf(buf, sizeof(buf), "%s", numeric(state_value(key)));
+                    break;
+                case 4:
+                case 5:
+                case 6:
+                    snprintf(key, sizeof(key), "%s_%s", quantiles[column - 4], sensors[i]);
+                    snprintf(buf, sizeof(buf), "%s", numeric(state_value(key)));
+                    break;
+                case 7: {
+                    type = "gauge";
+                    snprintf(key, sizeof(key), "stress_%s", sensors[i]);
+                    const char *stress = state_value(key);
+                    char *end;
+                    double hours = strtod(stress, &end);
+                    buf[0] = '\0';
+                    if (stress[0] && *end == '\0' && hours >= 0.0) {
+                        snprintf(buf, sizeof(buf), "%lu",
+                                 (unsigned long)((unsigned long long)(hours * 10.0 + 0.5) & 0xffffffffULL));
+                    }
+                    break;
+                }
+            }
+            add_entry(sub, 4, type, buf);
+        }
+    }
+}
+
+/**
+ * answer - Answer a get or getnext request
+ * @oid_str: Requested OID
+ * @next: true for getnext
+ */
+static void answer(const char *oid_str, bool next)
+{
+    uint32_t oid[SNMP_MAX_OID_LEN];
+    int len = parse_oid(oid_str, oid);
+
+    if (len < 0) {
+        printf("NONE\n");
+        return;
+    }
+
+    snapshot();
+
+    for (int i = 0; i < g_entry_count; i++) {
+        snmp_entry_t *e = &g_entries[i];
+        int cmp = compare_oid(e->oid, e->len, oid, len);
+        if ((next && cmp > 0) || (!next && cmp == 0)) {
+            print_oid(e->oid, e->len);
+            printf("%s\n%s\n", e->type, e->value);
+            return;
+        }
+    }
+
+    printf("NONE\n");
+}
+
+/**
+ * read_line - Read one protocol line without the newline
+ *
+ * Return: true on success, false on end of input
+ */
+static bool read_line(char *buf, size_t size)
+{
+    if (fgets(buf, (int)size, stdin) == NULL) {
+        return false;
+    }
+    STRIP_NEWLINE(buf);
+    return true;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * SNMP subcommand - serve the pass_persist protocol on stdin/stdout
+ */
+int snmp_mode(void)
+{
+    char line[SNMP_LINE_LEN];
+    char oid[SNMP_LINE_LEN];
+
+    g_base_len = parse_oid(SNMP_BASE_OID, g_base);
+
+    while (!shutdown_requested && read_line(line, sizeof(line))) {
+        if (line[0] == '\0') {
+            break;
+        } else if (strcmp(line, "PING") == 0) {
+            printf("PONG\n");
+        } else if (strcmp(line, "get") == 0 || strcmp(line, "getnext") == 0) {
+            if (!read_line(oid, sizeof(oid))) {
+                break;
+            }
+            answer(oid, strcmp(line, "getnext") == 0);
+        } else if (strcmp(line, "set") == 0) {
+            /* OID and "type value" follow; everything here is read-only */
+            if (!read_line(oid, sizeof(oid)) || !read_line(oid, sizeof(oid))) {
+                break;
+            }
+            printf("not-writable\n");
+        } else {
+            logging_debug("SNMP: unknown request '%s'", line);
+            printf("NONE\n");
+        }
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file state.c
+ * @brief Published daemon state for Quectel RM520N thermal management
+ * @author Christopher Sollinger
+ * @date 2025
+ * @license GPL
+ *
+ * This file keeps a small table of values published by the daemon and
+ * writes it as key=value lines to the state file. The file is replaced
+ * with rename(), so readers always see a complete set of values.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "include/logging.h"
+#include "include/common.h"
+#include "include/system.h"
+#include "include/state.h"
+
+/* ============================================================================
+ * STATE
+ * ============================================================================ */
+
+typedef struct {
+    char key[STATE_KEY_LEN];
+    char value[STATE_VALUE_LEN];
+} state_entry_t;
+
+static state_entry_t g_entries[STATE_MAX_KEYS];
+static int g_entry_count = 0;
+static bool g_dirty = false;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * state_set - Set a published value
+ * @key: Key name
+ * @fmt: printf-style format of the value
+ */
+void state_set(const char *key, const char *fmt, ...)
+{
+    char value[STATE_VALUE_LEN];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(value, sizeof(value), fmt, ap);
+    va_end(ap);
+
+    int i;
+    for (i = 0; i < g_entry_count; i++) {
+        if (strcmp(g_entries[i].key, key) == 0) {
+            break;
+        }
+    }
+
+    if (i == g_entry_count) {
+        if (g_entry_count >= STATE_MAX_KEYS) {
+            logging_warning("State table full, dropping '%s'", key);
+            return;
+        }
+        snprintf(g_entries[i].key, sizeof(g_entries[i].key), "%s", key);
+        g_entries[i].value[0] = '\0';
+        g_entry_count++;
+        g_dirty = true;
+    }
+
+    if (strcmp(g_entries[i].value, value) != 0) {
+        snprintf(g_entries[i].value, sizeof(g_entries[i].value), "%s", value);
+        g_dirty = true;
+    }
+}
+
+/**
+ * state_flush - Write the state file if a value changed
+ */
+void state_flush(void)
+{
+    char tmp_path[PATH_MAX_LEN];
+    char buf[STATE_MAX_KEYS * (STATE_KEY_LEN + STATE_VALUE_LEN + 2)];
+    size_t len = 0;
+
+    if (!g_dirty) {
+        return;
+    }
+
+    for (int i = 0; i < g_entry_count; i++) {
+        len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s=%s\n",
+                                g_entries[i].key, g_entries[i].value);
+    }
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%d", STATE_FILE, (int)getpid()) >= (int)sizeof(tmp_path)) {
+        return;
+    }
+
+    int fd = sys_open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        logging_debug("Cannot write state file: %s", strerror(errno));
+        return;
+    }
+
+    int ok = write(fd, buf, len) == (ssize_t)len;
+    close(fd);
+
+    if (!ok || sys_rename(tmp_path, STATE_FILE) != 0) {
+        logging_debug("Failed to update state file");
+        sys_unlink(tmp_path);
+        return;
+    }
+    g_dirty = false;
+}
+
+/**
+ * state_remove - Remove the state file
+ */
+void state_remove(void)
+{
+    sys_unlink(STATE_FILE);
+    g_dirty = g_entry_count > 0;
+}
+
+/**
+ * state_read - Look up a value in the state file
+ * @key: Key name
+ * @value: Buffer for the value
+ * @size: Size of the buffer
+ *
+ * Return: 0 on success, -1 if the file or key does not exist
+ */
+int state_read(const char *key, char *value, size_t size)
+{
+    char line[STATE_KEY_LEN + STATE_VALUE_LEN + 2];
+    size_t key_len = strlen(key);
+    int ret = -1;
+
+    FILE *fp = sys_fopen(STATE_FILE, "r");
+    if (!fp) {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == '=') {
+            STRIP_NEWLINE(line);
+            snprintf(value, size, "%s", line + key_len + 1);
+            ret = 0;
+            break;
+        }
+    }
+    fclose(fp);
+    return ret;
+}
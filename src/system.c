@@ -10,6 +10,7 @@
  * provide robust system integration and process control.
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,11 +18,16 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <limits.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sched.h>
 #include <dirent.h>
+#include <time.h>
 #include "include/common.h"
 #include "include/logging.h"
 #include "include/system.h"
@@ -32,6 +38,8 @@
 
 #define PID_FILE "/var/run/quectel_rm520n_temp.pid"
 #define LOCK_FILE "/var/run/quectel_rm520n_temp.lock"
+#define PAUSE_FILE "/var/run/quectel_rm520n_temp.pause"    /* Holder PID, written by bench */
+#define PAUSED_FILE "/var/run/quectel_rm520n_temp.paused"  /* Daemon acknowledgement */
 
 /* Global file descriptor for daemon lock */
 static int daemon_lock_fd = -1;
@@ -52,7 +60,7 @@ static int daemon_lock_fd = -1;
 int check_daemon_running(void)
 {
     // Check PID file
-    FILE *pid_file = fopen(PID_FILE, "r");
+    FILE *pid_file = sys_fopen(PID_FILE, "r");
     if (!pid_file) {
         return 0; // No PID file, daemon not running
     }
@@ -70,7 +78,7 @@ int check_daemon_running(void)
     }
     
     // Process not running, clean up stale PID file
-    unlink(PID_FILE);
+    sys_unlink(PID_FILE);
     return 0;
 }
 
@@ -88,7 +96,7 @@ int check_daemon_running(void)
  */
 int acquire_daemon_lock(void)
 {
-    daemon_lock_fd = open(LOCK_FILE, O_CREAT | O_RDWR, 0600);
+    daemon_lock_fd = sys_open(LOCK_FILE, O_CREAT | O_RDWR, 0600);
     if (daemon_lock_fd < 0) {
         return -1;
     }
@@ -101,12 +109,12 @@ int acquire_daemon_lock(void)
     }
 
     // Write PID to PID file with explicit permissions
-    FILE *pid_file = fopen(PID_FILE, "w");
+    FILE *pid_file = sys_fopen(PID_FILE, "w");
     if (pid_file) {
         fprintf(pid_file, "%d\n", getpid());
         fclose(pid_file);
         // Set explicit permissions: world-readable PID file is OK (0644)
-        chmod(PID_FILE, 0644);
+        sys_chmod(PID_FILE, 0644);
     }
 
     return 0;
@@ -131,17 +139,49 @@ void release_daemon_lock(void)
     }
 
     // Remove PID file
-    unlink(PID_FILE);
+    sys_unlink(PID_FILE);
 
     // Remove lock file
-    unlink(LOCK_FILE);
+    sys_unlink(LOCK_FILE);
+}
+
+/**
+ * Get the daemon lock file descriptor (for re-exec handoff)
+ *
+ * @return Lock file descriptor, -1 if the lock is not held
+ */
+int get_daemon_lock_fd(void)
+{
+    return daemon_lock_fd;
+}
+
+/**
+ * Adopt a daemon lock inherited from a previous image
+ *
+ * flock() locks belong to the open file description, so re-locking through
+ * the inherited descriptor succeeds only if it still holds the lock.
+ *
+ * @param fd Inherited lock file descriptor
+ * @return 0 on success, -1 if the descriptor does not hold the lock
+ */
+int adopt_daemon_lock(int fd)
+{
+    if (fd < 0 || flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        return -1;
+    }
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    daemon_lock_fd = fd;
+    return 0;
 }
 
 /**
  * Signal handler for graceful shutdown
  *
- * Handles SIGTERM and SIGINT signals to ensure graceful daemon shutdown.
- * Only sets the shutdown flag - logging is done in the main loop after
+ * Handles SIGTERM and SIGINT signals to ensure graceful daemon shutdown,
+ * SIGHUP to request a re-exec with state handoff, and SIGUSR1 to wake the
+ * daemon early when the pause state changed.
+ * Only sets the flags - logging is done in the main loop after
  * detecting the flag to maintain async-signal-safety.
  *
  * Following clig.dev guidelines for signal handling and graceful
@@ -154,7 +194,512 @@ void signal_handler(int sig)
     if (sig == SIGTERM || sig == SIGINT) {
         /* Only set flag - do not call non-async-signal-safe functions */
         shutdown_requested = 1;
+    } else if (sig == SIGHUP) {
+        reexec_requested = 1;
+    }
+    /* SIGUSR1 only interrupts the current sleep (pause state changed) */
+}
+
+/* ============================================================================
+ * DAEMON PAUSE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * read_pid_file - Read a PID from a file
+ * @path: Logical path of the file
+ *
+ * Return: PID, or -1 if the file is missing or invalid
+ */
+static pid_t read_pid_file(const char *path)
+{
+    FILE *fp = sys_fopen(path, "r");
+    int pid = -1;
+
+    if (!fp) {
+        return -1;
+    }
+    if (fscanf(fp, "%d", &pid) != 1 || pid <= 0) {
+        pid = -1;
+    }
+    fclose(fp);
+    return (pid_t)pid;
+}
+
+/**
+ * wake_daemon - Interrupt the daemon's sleep so it re-checks the pause file
+ */
+static void wake_daemon(void)
+{
+    pid_t pid = read_pid_file(PID_FILE);
+    if (pid > 0 && pid != getpid()) {
+        kill(pid, SIGUSR1);
+    }
+}
+
+/**
+ * Ask a running daemon to release the serial port
+ *
+ * @param timeout_sec Seconds to wait for the daemon's acknowledgement
+ * @return 0 if the daemon paused (or is not running), -1 on failure
+ */
+int request_daemon_pause(int timeout_sec)
+{
+    if (check_daemon_running() != 1) {
+        return 0;
+    }
+
+    pid_t holder = read_pid_file(PAUSE_FILE);
+    if (holder > 0 && holder != getpid() && kill(holder, 0) == 0) {
+        logging_error("Daemon is already paused by process %d", (int)holder);
+        return -1;
+    }
+
+    FILE *fp = sys_fopen(PAUSE_FILE, "w");
+    if (!fp) {
+        logging_error("Cannot create pause file %s: %s", PAUSE_FILE, strerror(errno));
+        return -1;
+    }
+    fprintf(fp, "%d\n", (int)getpid());
+    fclose(fp);
+
+    wake_daemon();
+
+    for (int waited_ms = 0; waited_ms < timeout_sec * 1000; waited_ms += 100) {
+        if (sys_access(PAUSED_FILE, F_OK) == 0) {
+            return 0;
+        }
+        if (shutdown_requested) {
+            break;
+        }
+        usleep(100000);
+    }
+
+    logging_error("Daemon did not release the serial port within %d seconds", timeout_sec);
+    release_daemon_pause();
+    return -1;
+}
+
+/**
+ * Let a paused daemon resume sampling
+ */
+void release_daemon_pause(void)
+{
+    if (read_pid_file(PAUSE_FILE) == getpid()) {
+        sys_unlink(PAUSE_FILE);
+        wake_daemon();
+    }
+}
+
+/**
+ * Check whether a live process asked the daemon to pause
+ *
+ * Stale pause files (holder no longer running) are removed.
+ *
+ * @return 1 if the daemon should pause, 0 otherwise
+ */
+int daemon_pause_requested(void)
+{
+    pid_t holder = read_pid_file(PAUSE_FILE);
+
+    if (holder <= 0) {
+        return 0;
+    }
+    if (kill(holder, 0) != 0 && errno == ESRCH) {
+        logging_warning("Removing stale pause file of process %d", (int)holder);
+        sys_unlink(PAUSE_FILE);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Acknowledge or clear the daemon's paused state
+ *
+ * @param paused Non-zero once the serial port has been released
+ */
+void set_daemon_paused(int paused)
+{
+    if (paused) {
+        FILE *fp = sys_fopen(PAUSED_FILE, "w");
+        if (fp) {
+            fprintf(fp, "%d\n", (int)getpid());
+            fclose(fp);
+        }
+    } else {
+        sys_unlink(PAUSED_FILE);
+    }
+}
+
+/* ============================================================================
+ * FILESYSTEM ROOT FUNCTIONS
+ * ============================================================================ */
+
+/* Resolved root prefix (from QUECTEL_ROOT) */
+static char g_sys_root[PATH_MAX_LEN] = {0};
+static int g_sys_root_init = 0;
+
+/**
+ * sys_root - Get the filesystem root prefix
+ *
+ * The prefix is read once from QUECTEL_ROOT. It must be an absolute path;
+ * other values are ignored so a stray relative value cannot redirect
+ * writes into the current directory.
+ *
+ * @return Root prefix (never NULL)
+ */
+const char *sys_root(void)
+{
+    if (!g_sys_root_init) {
+        const char *env = getenv("QUECTEL_ROOT");
+        if (env && env[0] == '/' && strlen(env) < sizeof(g_sys_root)) {
+            SAFE_STRNCPY(g_sys_root, env, sizeof(g_sys_root));
+            /* Strip trailing slashes ("/" itself becomes the empty prefix) */
+            size_t len = strlen(g_sys_root);
+            while (len > 0 && g_sys_root[len - 1] == '/') {
+                g_sys_root[--len] = '\0';
+            }
+        }
+        g_sys_root_init = 1;
+    }
+    return g_sys_root;
+}
+
+/**
+ * sys_path - Resolve an absolute path below the filesystem root prefix
+ * @buf: Buffer to store the resolved path
+ * @size: Size of the buffer
+ * @path: Absolute path as seen on a real system (relative paths are kept)
+ *
+ * @return 0 on success, -1 on truncation
+ */
+int sys_path(char *buf, size_t size, const char *path)
+{
+    if (!buf || size == 0 || !path) {
+        return -1;
+    }
+
+    const char *root = (path[0] == '/') ? sys_root() : "";
+    if (snprintf(buf, size, "%s%s", root, path) >= (int)size) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return 0;
+}
+
+/* Root-aware libc wrappers (documented in system.h) */
+
+FILE *sys_fopen(const char *path, const char *mode)
+{
+    char real_path[PATH_MAX_LEN * 2];
+    if (sys_path(real_path, sizeof(real_path), path) < 0) {
+        return NULL;
+    }
+    return fopen(real_path, mode);
+}
+
+DIR *sys_opendir(const char *path)
+{
+    char real_path[PATH_MAX_LEN * 2];
+    if (sys_path(real_path, sizeof(real_path), path) < 0) {
+        return NULL;
+    }
+    return opendir(real_path);
+}
+
+int sys_open(const char *path, int flags, mode_t mode)
+{
+    char real_path[PATH_MAX_LEN * 2];
+    if (sys_path(real_path, sizeof(real_path), path) < 0) {
+        return -1;
+    }
+    return open(real_path, flags, mode);
+}
+
+int sys_access(const char *path, int mode)
+{
+    char real_path[PATH_MAX_LEN * 2];
+    if (sys_path(real_path, sizeof(real_path), path) < 0) {
+        return -1;
+    }
+    return access(real_path, mode);
+}
+
+int sys_stat(const char *path, struct stat *st)
+{
+    char real_path[PATH_MAX_LEN * 2];
+    if (sys_path(real_path, sizeof(real_path), path) < 0) {
+        return -1;
     }
+    return stat(real_path, st);
+}
+
+int sys_unlink(const char *path)
+{
+    char real_path[PATH_MAX_LEN * 2];
+    if (sys_path(real_path, sizeof(real_path), path) < 0) {
+        return -1;
+    }
+    return unlink(real_path);
+}
+
+int sys_chmod(const char *path, mode_t mode)
+{
+    char real_path[PATH_MAX_LEN * 2];
+    if (sys_path(real_path, sizeof(real_path), path) < 0) {
+        return -1;
+    }
+    return chmod(real_path, mode);
+}
+
+int sys_rename(const char *oldpath, const char *newpath)
+{
+    char real_old[PATH_MAX_LEN * 2];
+    char real_new[PATH_MAX_LEN * 2];
+    if (sys_path(real_old, sizeof(real_old), oldpath) < 0 ||
+        sys_path(real_new, sizeof(real_new), newpath) < 0) {
+        return -1;
+    }
+    return rename(real_old, real_new);
+}
+
+/* ============================================================================
+ * CLOCK FUNCTIONS
+ * ============================================================================ */
+
+/* Clock acceleration state (0 = not yet initialized) */
+static unsigned int g_time_scale = 0;
+static time_t g_clock_epoch = 0;
+static struct timespec g_clock_mono = {0};
+
+/**
+ * sys_time_scale - Get the clock acceleration factor
+ *
+ * @return Acceleration factor (1 = real time)
+ */
+unsigned int sys_time_scale(void)
+{
+    if (g_time_scale == 0) {
+        const char *env = getenv("QUECTEL_TIME_SCALE");
+        g_time_scale = 1;
+
+        if (env && *env && sys_root()[0] != '\0') {
+            char *end;
+            long scale = strtol(env, &end, 10);
+            if (*end == '\0' && scale >= 1 && scale <= SYS_TIME_SCALE_MAX) {
+                g_time_scale = (unsigned int)scale;
+            }
+        }
+
+        if (g_time_scale > 1) {
+            g_clock_epoch = time(NULL);
+            clock_gettime(CLOCK_MONOTONIC, &g_clock_mono);
+            logging_info("Clock accelerated %ux (QUECTEL_TIME_SCALE)", g_time_scale);
+        }
+    }
+    return g_time_scale;
+}
+
+/**
+ * sys_time - Current time on the daemon clock
+ *
+ * @return Seconds since the epoch on the (possibly virtual) clock
+ */
+time_t sys_time(void)
+{
+    unsigned int scale = sys_time_scale();
+    if (scale == 1) {
+        return time(NULL);
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (double)(now.tv_sec - g_clock_mono.tv_sec) +
+                     (now.tv_nsec - g_clock_mono.tv_nsec) / 1e9;
+    return g_clock_epoch + (time_t)(elapsed * scale);
+}
+
+/**
+ * sys_sleep - Sleep on the daemon clock
+ * @seconds: Seconds to sleep on the (possibly virtual) clock
+ */
+void sys_sleep(unsigned int seconds)
+{
+    unsigned int scale = sys_time_scale();
+    if (scale == 1) {
+        sleep(seconds);
+        return;
+    }
+
+    long long ns = (long long)seconds * 1000000000LL / scale;
+    struct timespec ts = {
+        .tv_sec = (time_t)(ns / 1000000000LL),
+        .tv_nsec = (long)(ns % 1000000000LL)
+    };
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * sys_sleep_until - Sleep until an absolute CLOCK_MONOTONIC deadline
+ * @deadline: Deadline on the real monotonic clock
+ *
+ * @return Wakeup lateness in microseconds, -1 if interrupted by a signal
+ */
+long sys_sleep_until(const struct timespec *deadline)
+{
+    struct timespec now;
+
+    if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL) != 0) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t late_us = (int64_t)(now.tv_sec - deadline->tv_sec) * 1000000LL +
+                      (now.tv_nsec - deadline->tv_nsec) / 1000L;
+    if (late_us > LONG_MAX) {
+        return LONG_MAX;
+    }
+    return (late_us > 0) ? (long)late_us : 0;
+}
+
+/**
+ * sys_real_usec - Convert a daemon clock duration to real microseconds
+ * @usec: Duration on the (possibly virtual) clock
+ *
+ * @return Duration in real microseconds (at least 1 for non-zero input)
+ */
+int64_t sys_real_usec(int64_t usec)
+{
+    int64_t real = usec / (int64_t)sys_time_scale();
+    return (real == 0 && usec > 0) ? 1 : real;
+}
+
+/* ============================================================================
+ * REAL-TIME SCHEDULING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * prefault_stack - Touch the stack so its pages are mapped and locked
+ */
+static void prefault_stack(void)
+{
+    volatile unsigned char stack[SYS_PREFAULT_STACK];
+
+    for (size_t i = 0; i < sizeof(stack); i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+/**
+ * sys_set_realtime - Switch the process in or out of real-time mode
+ * @enable: Non-zero for SCHED_FIFO + mlockall, zero to restore SCHED_OTHER
+ * @priority: SCHED_FIFO priority (1-99)
+ * @cpu_mask: CPU affinity mask (bit N = CPU N, 0 = all CPUs)
+ *
+ * @return 0 if all steps succeeded, -1 otherwise
+ */
+int sys_set_realtime(int enable, int priority, unsigned long cpu_mask)
+{
+    int result = 0;
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    if (enable && cpu_mask != 0) {
+        for (int cpu = 0; cpu < (int)(sizeof(cpu_mask) * 8) && cpu < CPU_SETSIZE; cpu++) {
+            if (cpu_mask & (1UL << cpu)) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+    } else {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+        logging_warning("Failed to set CPU affinity: %s", strerror(errno));
+        result = -1;
+    }
+
+    if (!enable) {
+        struct sched_param param = { .sched_priority = 0 };
+        sched_setscheduler(0, SCHED_OTHER, &param);
+        munlockall();
+        return result;
+    }
+
+    struct sched_param param = { .sched_priority = priority };
+    int policy = SCHED_FIFO;
+#ifdef SCHED_RESET_ON_FORK
+    policy |= SCHED_RESET_ON_FORK;   /* Helper processes must not run real-time */
+#endif
+    if (sched_setscheduler(0, policy, &param) != 0) {
+        logging_warning("Failed to set SCHED_FIFO priority %d: %s", priority, strerror(errno));
+        result = -1;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        logging_warning("Failed to lock memory: %s", strerror(errno));
+        result = -1;
+    }
+    prefault_stack();
+
+    return result;
+}
+
+/* ============================================================================
+ * RESOURCE MONITORING FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * sys_resource_usage - Sample the resource usage of the current process
+ * @res: Snapshot to fill in (fields that cannot be read are set to -1/0)
+ *
+ * @return 0 on success, -1 if nothing could be read
+ */
+int sys_resource_usage(sys_resources_t *res)
+{
+    int ok = 0;
+
+    if (!res) {
+        return -1;
+    }
+    res->open_fds = -1;
+    res->rss_kb = -1;
+    res->cpu_ms = 0;
+
+    DIR *fd_dir = opendir("/proc/self/fd");
+    if (fd_dir) {
+        struct dirent *entry;
+        int count = 0;
+        while ((entry = readdir(fd_dir)) != NULL) {
+            if (entry->d_name[0] != '.') {
+                count++;
+            }
+        }
+        closedir(fd_dir);
+        res->open_fds = count - 1;  /* Exclude the directory stream itself */
+        ok = 1;
+    }
+
+    FILE *status_fp = fopen("/proc/self/status", "r");
+    if (status_fp) {
+        char line[128];
+        while (fgets(line, sizeof(line), status_fp)) {
+            if (sscanf(line, "VmRSS: %ld", &res->rss_kb) == 1) {
+                ok = 1;
+                break;
+            }
+        }
+        fclose(status_fp);
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        res->cpu_ms = (unsigned long)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000UL +
+                      (unsigned long)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000UL;
+        ok = 1;
+    }
+
+    return ok ? 0 : -1;
 }
 
 /* ============================================================================
@@ -218,7 +763,7 @@ int find_quectel_hwmon_device(int use_cache)
             /* Verify device still exists */
             char verify_path[PATH_MAX_LEN];
             snprintf(verify_path, sizeof(verify_path), "/sys/class/hwmon/hwmon%d/temp1_input", g_hwmon_device_num);
-            if (access(verify_path, R_OK) == 0) {
+            if (sys_access(verify_path, R_OK) == 0) {
                 logging_debug("Using cached hwmon device: hwmon%d", g_hwmon_device_num);
                 return g_hwmon_device_num;
             }
@@ -228,7 +773,7 @@ int find_quectel_hwmon_device(int use_cache)
         g_hwmon_cache_valid = 0;
     }
 
-    hwmon_dir = opendir("/sys/class/hwmon");
+    hwmon_dir = sys_opendir("/sys/class/hwmon");
     if (!hwmon_dir) {
         return -1;
     }
@@ -249,7 +794,7 @@ int find_quectel_hwmon_device(int use_cache)
             continue;
 
         /* Read device name */
-        name_fp = fopen(name_path, "r");
+        name_fp = sys_fopen(name_path, "r");
         if (!name_fp)
             continue;
 
@@ -263,7 +808,7 @@ int find_quectel_hwmon_device(int use_cache)
         logging_debug("Found hwmon device: %s -> %s", entry->d_name, dev_name);
 
         /* Verify device has temp1_input */
-        if (access(verify_path, R_OK) != 0)
+        if (sys_access(verify_path, R_OK) != 0)
             continue;
 
         int num = extract_hwmon_number(entry->d_name);
@@ -261,3 +261,22 @@ int select_best_temperature(int modem_temp, int ap_temp, int pa_temp, int *resul
 
     return 1;
 }
+
+/**
+ * Check whether a sensor has a value in the AT+QTEMP response
+ *
+ * @param response AT command response string
+ * @param prefix Sensor prefix (e.g., "modem-ambient-usr")
+ * @return 1 if the sensor has a value, 0 otherwise
+ */
+int temp_sensor_present(const char *response, const char *prefix)
+{
+    char pattern[PATTERN_LEN];
+    int value;
+
+    if (!response || !prefix) {
+        return 0;
+    }
+    snprintf(pattern, sizeof(pattern), "\"%s\"", prefix);
+    return extract_single_temperature(response, pattern, strlen(pattern), &value);
+}
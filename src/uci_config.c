@@ -28,10 +28,10 @@
 #include <errno.h>
 #include <dirent.h>
 #include <ctype.h>
-#include <uci.h>
 #include "include/logging.h"
 #include "include/common.h"
 #include "include/system.h"
+#include "include/config.h"
 
 /* ============================================================================
  * CONSTANTS & CONFIGURATION
@@ -40,8 +40,6 @@
 #define SYSFS_BASE "/sys/kernel/quectel_rm520n_thermal"
 #define HWMON_BASE "/sys/class/hwmon"
 #define HWMON_NUM_MAX 255   /* Maximum valid hwmon device number */
-#define UCI_CONFIG "quectel_rm520n_thermal"
-#define UCI_SECTION "settings"
 
 /* Temperature threshold options in UCI */
 #define UCI_TEMP_MIN "temp_min"
@@ -53,51 +51,41 @@
  * UCI CONFIGURATION FUNCTIONS
  * ============================================================================ */
 
+/* Configuration snapshot used while applying thresholds */
+static config_t g_uci_config;
+
 /**
- * Read a UCI configuration value using UCI C library
+ * Read a temperature threshold option from the configuration snapshot
  *
- * Uses the UCI C library directly instead of popen() to avoid
- * command injection vulnerabilities.
+ * The snapshot is taken once per uci_config_mode() call through
+ * config_read_uci(), which serves it from the binary configuration cache
+ * instead of allocating a UCI context per option.
  *
  * @param option Option name to read
  * @param buffer Buffer to store the value
  * @param buffer_size Size of the buffer
- * @return 0 on success, -1 on error
+ * @return 0 on success, -1 if the option is not set
  */
 static int read_uci_option(const char *option, char *buffer, size_t buffer_size)
 {
-    struct uci_context *ctx;
-    struct uci_package *pkg;
-    struct uci_section *section;
-    const char *value;
+    const char *value = NULL;
 
     if (!option || !buffer || buffer_size == 0) {
         return -1;
     }
 
-    ctx = uci_alloc_context();
-    if (!ctx) {
-        logging_error("Failed to allocate UCI context");
-        return -1;
-    }
-
-    if (uci_load(ctx, UCI_CONFIG, &pkg) != UCI_OK) {
-        logging_debug("Failed to load UCI package '%s'", UCI_CONFIG);
-        uci_free_context(ctx);
-        return -1;
+    if (strcmp(option, UCI_TEMP_MIN) == 0) {
+        value = g_uci_config.temp_min;
+    } else if (strcmp(option, UCI_TEMP_MAX) == 0) {
+        value = g_uci_config.temp_max;
+    } else if (strcmp(option, UCI_TEMP_CRIT) == 0) {
+        value = g_uci_config.temp_crit;
+    } else if (strcmp(option, UCI_TEMP_DEFAULT) == 0) {
+        value = g_uci_config.temp_default;
     }
 
-    section = uci_lookup_section(ctx, pkg, UCI_SECTION);
-    if (!section) {
-        logging_debug("UCI section '%s' not found", UCI_SECTION);
-        uci_free_context(ctx);
-        return -1;
-    }
-
-    value = uci_lookup_option_string(ctx, section, option);
-    if (!value) {
+    if (!value || value[0] == '\0') {
         logging_debug("UCI option '%s' not found", option);
-        uci_free_context(ctx);
         return -1;
     }
 
@@ -105,7 +93,6 @@ static int read_uci_option(const char *option, char *buffer, size_t buffer_size)
     strncpy(buffer, value, buffer_size - 1);
     buffer[buffer_size - 1] = '\0';
 
-    uci_free_context(ctx);
     return 0;
 }
 
@@ -164,7 +151,7 @@ static int write_sysfs_value(const char *filename, int value)
     }
     
     // Open file for writing (avoid TOCTOU race with access() check)
-    fp = fopen(path, "w");
+    fp = sys_fopen(path, "w");
     if (!fp) {
         logging_debug("Sysfs file not writable: %s", path);
         return -1;
@@ -200,7 +187,7 @@ static int read_sysfs_value(const char *filename)
     }
     
     // Open file for reading (avoid TOCTOU race with access() check)
-    fp = fopen(path, "r");
+    fp = sys_fopen(path, "r");
     if (!fp) {
         logging_debug("Sysfs file not readable: %s", path);
         return -1;
@@ -237,9 +224,14 @@ int uci_config_mode(void)
     int updated = 0;
     
     logging_info("Updating kernel module thresholds from UCI config");
+
+    if (config_read_uci(&g_uci_config) != 0) {
+        logging_warning("Failed to read UCI configuration");
+        config_set_defaults(&g_uci_config);
+    }
     
     // Check if kernel module is loaded
-    if (access(SYSFS_BASE, F_OK) != 0) {
+    if (sys_access(SYSFS_BASE, F_OK) != 0) {
         logging_error("Kernel module not loaded or sysfs not available: %s", SYSFS_BASE);
         logging_error("Please load the quectel_rm520n_temp kernel module first");
         return 1;
@@ -343,7 +335,7 @@ int uci_config_mode(void)
     
     // List all available hwmon devices for debugging (debug level only)
     logging_debug("Available hwmon devices:");
-    DIR *debug_hwmon_dir = opendir(HWMON_BASE);
+    DIR *debug_hwmon_dir = sys_opendir(HWMON_BASE);
     if (debug_hwmon_dir) {
         struct dirent *debug_entry;
         while ((debug_entry = readdir(debug_hwmon_dir)) != NULL) {
@@ -353,7 +345,7 @@ int uci_config_mode(void)
             char debug_name_path[256];
             if (snprintf(debug_name_path, sizeof(debug_name_path), "%s/%s/name", HWMON_BASE, debug_entry->d_name) < sizeof(debug_name_path)) {
                 char debug_dev_name[64];
-                FILE *debug_name_fp = fopen(debug_name_path, "r");
+                FILE *debug_name_fp = sys_fopen(debug_name_path, "r");
                 if (debug_name_fp) {
                     if (fgets(debug_dev_name, sizeof(debug_dev_name), debug_name_fp) != NULL) {
                         STRIP_NEWLINE(debug_dev_name);
@@ -396,18 +388,18 @@ int uci_config_mode(void)
         // Verify this device has Quectel attributes and is writable
         char verify_path[256];
         if (snprintf(verify_path, sizeof(verify_path), "%s/hwmon%d/temp1_input", HWMON_BASE, hwmon_num) < sizeof(verify_path)) {
-            if (access(verify_path, R_OK) == 0) {
+            if (sys_access(verify_path, R_OK) == 0) {
                 logging_info("Verified: hwmon%d has Quectel attributes", hwmon_num);
                 
                         // Check if the device is writable
         char write_test_path[256];
         if (snprintf(write_test_path, sizeof(write_test_path), "%s/hwmon%d/temp1_crit", HWMON_BASE, hwmon_num) < sizeof(write_test_path)) {
-            if (access(write_test_path, W_OK) == 0) {
+            if (sys_access(write_test_path, W_OK) == 0) {
                 logging_info("Verified: hwmon%d is writable", hwmon_num);
                 
                 // Check actual file permissions
                 struct stat st;
-                if (stat(write_test_path, &st) == 0) {
+                if (sys_stat(write_test_path, &st) == 0) {
                     logging_info("File permissions: %o (owner: %d, group: %d)", 
                                st.st_mode & 0777, st.st_uid, st.st_gid);
                 }
@@ -429,7 +421,7 @@ int uci_config_mode(void)
         // Read current hwmon values for comparison (debug level)
         logging_debug("Current hwmon hwmon%d values:", hwmon_num);
         if (snprintf(hwmon_path, sizeof(hwmon_path), "%s/hwmon%d/temp1_min", HWMON_BASE, hwmon_num) < sizeof(hwmon_path)) {
-            FILE *fp = fopen(hwmon_path, "r");
+            FILE *fp = sys_fopen(hwmon_path, "r");
             if (fp) {
                 int current_val;
                 if (fscanf(fp, "%d", &current_val) == 1) {
@@ -440,7 +432,7 @@ int uci_config_mode(void)
         }
         
         if (snprintf(hwmon_path, sizeof(hwmon_path), "%s/hwmon%d/temp1_max", HWMON_BASE, hwmon_num) < sizeof(hwmon_path)) {
-            FILE *fp = fopen(hwmon_path, "r");
+            FILE *fp = sys_fopen(hwmon_path, "r");
             if (fp) {
                 int current_val;
                 if (fscanf(fp, "%d", &current_val) == 1) {
@@ -451,7 +443,7 @@ int uci_config_mode(void)
         }
         
         if (snprintf(hwmon_path, sizeof(hwmon_path), "%s/hwmon%d/temp1_crit", HWMON_BASE, hwmon_num) < sizeof(hwmon_path)) {
-            FILE *fp = fopen(hwmon_path, "r");
+            FILE *fp = sys_fopen(hwmon_path, "r");
             if (fp) {
                 int current_val;
                 if (fscanf(fp, "%d", &current_val) == 1) {
@@ -466,7 +458,7 @@ int uci_config_mode(void)
             temp_min = celsius_to_millidegrees(uci_value);
             if (snprintf(hwmon_path, sizeof(hwmon_path), "%s/hwmon%d/temp1_min", HWMON_BASE, hwmon_num) < (int)sizeof(hwmon_path)) {
                 logging_info("Attempting to update hwmon temp1_min at: %s", hwmon_path);
-                FILE *fp = fopen(hwmon_path, "w");
+                FILE *fp = sys_fopen(hwmon_path, "w");
                 if (fp) {
                     int write_result = fprintf(fp, "%d", temp_min);
                     if (write_result > 0) {
@@ -488,7 +480,7 @@ int uci_config_mode(void)
             temp_max = celsius_to_millidegrees(uci_value);
             if (snprintf(hwmon_path, sizeof(hwmon_path), "%s/hwmon%d/temp1_max", HWMON_BASE, hwmon_num) < (int)sizeof(hwmon_path)) {
                 logging_info("Attempting to update hwmon temp1_max at: %s", hwmon_path);
-                FILE *fp = fopen(hwmon_path, "w");
+                FILE *fp = sys_fopen(hwmon_path, "w");
                 if (fp) {
                     int write_result = fprintf(fp, "%d", temp_max);
                     if (write_result > 0) {
@@ -510,7 +502,7 @@ int uci_config_mode(void)
             temp_crit = celsius_to_millidegrees(uci_value);
             if (snprintf(hwmon_path, sizeof(hwmon_path), "%s/hwmon%d/temp1_crit", HWMON_BASE, hwmon_num) < (int)sizeof(hwmon_path)) {
                 logging_info("Attempting to update hwmon temp1_crit at: %s", hwmon_path);
-                FILE *fp = fopen(hwmon_path, "w");
+                FILE *fp = sys_fopen(hwmon_path, "w");
                 if (fp) {
                     int write_result = fprintf(fp, "%d", temp_crit);
                     if (write_result > 0) {
@@ -541,12 +533,12 @@ int uci_config_mode(void)
         char main_sysfs_path[256];
         if (snprintf(main_sysfs_path, sizeof(main_sysfs_path), "%s/temp_crit", SYSFS_BASE) < sizeof(main_sysfs_path)) {
             struct stat main_st;
-            if (stat(main_sysfs_path, &main_st) == 0) {
+            if (sys_stat(main_sysfs_path, &main_st) == 0) {
                 logging_debug("Main sysfs temp_crit permissions: %o (owner: %d, group: %d)", 
                            (int)(main_st.st_mode & 0777), (int)main_st.st_uid, (int)main_st.st_gid);
                 
                 // Check if the file is actually writable
-                if (access(main_sysfs_path, W_OK) == 0) {
+                if (sys_access(main_sysfs_path, W_OK) == 0) {
                     logging_debug("Main sysfs temp_crit is writable");
                 } else {
                     logging_warning("Main sysfs temp_crit is not writable (errno: %d)", errno);
@@ -635,7 +627,7 @@ int uci_config_mode(void)
             if (snprintf(alt_hwmon_path, sizeof(alt_hwmon_path), "%s/hwmon%d/temp1_crit", HWMON_BASE, alt_hwmon_num) < sizeof(alt_hwmon_path)) {
                 if (read_uci_option(UCI_TEMP_CRIT, uci_value, sizeof(uci_value)) == 0) {
                     temp_crit = celsius_to_millidegrees(uci_value);
-                    FILE *alt_fp = fopen(alt_hwmon_path, "w");
+                    FILE *alt_fp = sys_fopen(alt_hwmon_path, "w");
                     if (alt_fp) {
                         fprintf(alt_fp, "%d", temp_crit);
                         fclose(alt_fp);
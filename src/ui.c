@@ -14,6 +14,9 @@
 #include <stdlib.h>
 #include "include/logging.h"
 #include "include/common.h"
+#include "include/bench.h"
+#include "include/simulate.h"
+#include "include/admission.h"
 
 /* External variables from main.c */
 extern bool verbose_output;
@@ -46,13 +49,28 @@ void print_usage(const char *progname)
 	printf("  read               Read current temperature (CLI mode) [default]\n");
 	printf("  daemon             Start daemon mode (background monitoring)\n");
 	printf("  config             Update kernel module thresholds from UCI config\n");
-	printf("  status             Show daemon status and system information\n\n");
+	printf("  status             Show daemon status and system information\n");
+	printf("  bench              Measure AT round-trip performance (pauses the daemon)\n");
+	printf("  simulate TRACE     Replay a temperature trace through a trip/governor policy\n");
+	printf("  histogram [window] Show hours per 1°C band and equivalent stress hours,\n");
+	printf("                     or the sliding window with p50/p95/p99\n");
+	printf("  snmp               Serve the daemon's values as an snmpd pass_persist helper\n");
+	printf("  history            Show or export (--export) the samples since a cursor\n");
+	printf("  admit [SECONDS]    Ask whether a heavy modem operation of SECONDS may start now\n");
+	printf("                     (exit 0 admit, %d defer, 1 deny; default: %d s)\n\n",
+	       ADMISSION_EXIT_DEFER, ADMISSION_DEFAULT_DURATION);
     printf("Options:\n");
-    printf("  -p, --port PORT    Serial port (default: /dev/ttyUSB2)\n");
+    printf("  -p, --port PORT    Serial port or tcp:// / rfc2217:// endpoint (default: /dev/ttyUSB2)\n");
     printf("  -b, --baud RATE    Baud rate (default: 115200)\n");
     printf("  -j, --json         JSON output format (CLI mode only)\n");
     printf("  -c, --celsius      Return temperature in degrees Celsius (CLI mode only)\n");
     printf("  -w, --watch        Continuously monitor temperature (CLI mode only, respects UCI interval)\n");
+    printf("  -n, --count N      Transactions per command and baud rate (bench, default: %d)\n", BENCH_DEFAULT_COUNT);
+    printf("  -t, --trips LIST   Trips in °C, e.g. 65,70:3,75 (simulate, default: %s)\n", SIMULATE_DEFAULT_TRIPS);
+    printf("  -H, --hysteresis C Default trip hysteresis in °C (simulate, default: %s)\n", SIMULATE_DEFAULT_HYST);
+    printf("  -g, --governor G   step_wise or bang_bang (simulate, default: %s)\n", SIMULATE_DEFAULT_GOVERNOR);
+    printf("  -e, --export       Write compact binary chunks (history)\n");
+    printf("  -s, --since SEQ    First sample to include, from the last cursor (history, default: oldest)\n");
     printf("  -d, --debug        Enable debug output\n");
     printf("  -V, --version      Show version information\n");
     printf("  -h, --help         Show this help message\n\n");
@@ -62,12 +80,20 @@ void print_usage(const char *progname)
 	printf("  %s daemon             # Start daemon mode\n", progname);
 	printf("  %s config             # Update kernel module thresholds\n", progname);
 	printf("  %s status             # Check daemon status\n", progname);
+	printf("  %s bench -n 100       # Benchmark all baud rates, 100 transactions each\n", progname);
+	printf("  %s bench --baud 115200 # Benchmark a single baud rate\n", progname);
+	printf("  %s simulate trace.log --trips 60,68,75 --hysteresis 3 # Evaluate a policy\n", progname);
+	printf("  %s histogram --json   # Time-at-temperature vector for fleet tools\n", progname);
+	printf("  %s histogram window   # Percentiles of the last quantile_window seconds\n", progname);
+	printf("  %s history --export --since 1234 > chunk.bin # Samples since the last upload\n", progname);
+	printf("  %s admit 300 && speedtest # Start a 5 minute operation only with headroom\n", progname);
     printf("  %s --json             # Read temperature in JSON format\n", progname);
     printf("  %s --celsius          # Return temperature in degrees Celsius\n", progname);
     printf("  %s --watch            # Continuously monitor temperature\n", progname);
     printf("  %s --watch --celsius  # Monitor temperature in degrees Celsius\n", progname);
     printf("  %s --watch --json     # Monitor temperature in JSON format\n", progname);
     printf("  %s --port /dev/ttyUSB3 # Read from specific port\n", progname);
+    printf("  %s --port rfc2217://10.0.0.20:2001 # Read through a serial server\n", progname);
     printf("  %s --debug            # Enable debug output\n", progname);
     printf("\n");
     printf("Exit codes:\n");
@@ -79,7 +105,11 @@ void print_usage(const char *progname)
     printf("CONFIGURATION\n");
     printf("  UCI Config: /etc/config/quectel_rm520n_thermal\n\n");
     printf("ENVIRONMENT VARIABLES\n");
-    printf("  DEBUG           Enable debug output (same as --debug flag)\n\n");
+    printf("  DEBUG           Enable debug output (same as --debug flag)\n");
+    printf("  QUECTEL_ROOT    Resolve /sys, /proc, /dev, /var/run and /etc/config\n");
+    printf("                  below this directory (testing without hardware)\n");
+    printf("  QUECTEL_TIME_SCALE  Run the daemon clock N times faster (requires\n");
+    printf("                  QUECTEL_ROOT, for soak testing)\n\n");
     printf("LOGS\n");
     printf("  Daemon: /var/log/messages (filter: quectel_rm520n_temp)\n");
     printf("  CLI: stderr (use --debug for more details)\n");